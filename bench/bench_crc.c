@@ -0,0 +1,88 @@
+//! \file bench_crc.c
+//! \brief Throughput and memory of the CRC strategies on the host
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 3
+//!
+//! Prints bytes processed per microsecond over a 64 KiB buffer for CRC-8
+//! and CRC-16, next to the flash taken by the tables of each strategy.
+//! Tables are const, in flash on AVR and in .rodata elsewhere, so no
+//! strategy uses RAM beyond a few bytes of stack. Code size is not
+//! counted, see the map file of the target build for it.
+
+#include "onewire_crc.h"
+
+#include <stdio.h>
+#include <time.h>
+
+
+#define BUFFER_SIZE     65536
+#define ROUNDS          20
+
+
+typedef struct strategy {
+    const char *name;
+    uint8_t (*update8)(uint8_t crc, uint8_t data);
+    uint16_t (*update16)(uint16_t crc, uint8_t data);
+    uint16_t table8;            //!< bytes of the CRC-8 table
+    uint16_t table16;           //!< bytes of the CRC-16 table
+} strategy_t;
+
+static const strategy_t strategies[] = {
+    {"bitwise", crc8_update_bitwise, crc16_update_bitwise, 0, 0},
+    {"nibble", crc8_update_nibble, crc16_update_nibble, 16, 16 * 2},
+    {"table", crc8_update_table, crc16_update_table, 256, 256 * 2},
+};
+
+
+static double now_us(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+
+int main(void) {
+    static uint8_t data[BUFFER_SIZE];
+    volatile uint32_t sink = 0;
+
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = i * 29 + 7;
+    }
+
+    printf("method,crc8_bytes_per_us,crc16_bytes_per_us,flash_tables,ram\n");
+
+    for (uint8_t k = 0; k < sizeof(strategies) / sizeof(strategies[0]); k++) {
+        const strategy_t *strategy = &strategies[k];
+        double start;
+        double elapsed8;
+        double elapsed16;
+        uint8_t crc8_value = 0;
+        uint16_t crc16_value = 0;
+
+        start = now_us();
+        for (uint8_t round = 0; round < ROUNDS; round++) {
+            for (uint32_t i = 0; i < sizeof(data); i++) {
+                crc8_value = strategy->update8(crc8_value, data[i]);
+            }
+        }
+        elapsed8 = now_us() - start;
+
+        start = now_us();
+        for (uint8_t round = 0; round < ROUNDS; round++) {
+            for (uint32_t i = 0; i < sizeof(data); i++) {
+                crc16_value = strategy->update16(crc16_value, data[i]);
+            }
+        }
+        elapsed16 = now_us() - start;
+
+        sink += crc8_value + crc16_value;
+
+        printf("%s,%.0f,%.0f,%u,0\n", strategy->name,
+                (double)sizeof(data) * ROUNDS / elapsed8,
+                (double)sizeof(data) * ROUNDS / elapsed16,
+                strategy->table8 + strategy->table16);
+    }
+
+    return sink ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+//! \file bench_ds18b20.c
+//! \brief Bus time of reading many DS18B20 on a simulated line
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 7
+//!
+//! Prints, for several bus sizes at standard speed and 12-bit resolution,
+//! the bus time of reading every thermometer one at a time, each with its
+//! own conversion, next to ds18b20_readAll() with and without the CRC.
+//! Times are virtual, as a slave sees them; the overhead of the CPU
+//! between slots is not counted.
+
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+#define MAX_SLAVES      200
+
+
+static onewire_sim_ds18b20_t thermometers[MAX_SLAVES];
+static uint8_t address_box[MAX_SLAVES][8];
+static int16_t temperature[MAX_SLAVES];
+
+
+static double elapsed_s(const onewire_sim_t *sim) {
+    onewire_sim_counter_t counter;
+
+    onewire_sim_getCounters(sim, &counter);
+    return counter.time / 1e9;
+}
+
+
+int main(void) {
+    static const uint8_t sizes[] = {10, 50, 200};
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+    int status = 0;
+
+    printf("thermometers,one_at_a_time_s,read_all_s,read_all_no_crc_s\n");
+
+    for (uint8_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        uint8_t number = sizes[k];
+        double single;
+        double all;
+        double all_no_crc;
+
+        onewire_sim_init(&sim);
+        host_onewire_init(&bus, &sim);
+
+        for (uint8_t i = 0; i < number; i++) {
+            onewire_sim_ds18b20Init(&thermometers[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+            onewire_sim_attach(&sim, &thermometers[i].device);
+            memcpy(address_box[i], thermometers[i].device.ROM, 8);
+        }
+
+        // one conversion per thermometer, then its scratchpad with CRC
+        onewire_sim_clearCounters(&sim);
+        for (uint8_t i = 0; i < number; i++) {
+            status |= !onewire_select(&bus, address_box[i]);
+            onewire_send(&bus, DS18B20_CONVERT_T);
+            status |= !ds18b20_waitConversion(&bus);
+            status |= !ds18b20_readTemperature(&bus, address_box[i], &temperature[i]);
+        }
+        single = elapsed_s(&sim);
+
+        onewire_sim_clearCounters(&sim);
+        status |= ds18b20_readAll(&bus, address_box, temperature, number, true) != number;
+        all = elapsed_s(&sim);
+
+        onewire_sim_clearCounters(&sim);
+        status |= ds18b20_readAll(&bus, address_box, temperature, number, false) != number;
+        all_no_crc = elapsed_s(&sim);
+
+        printf("%u,%.2f,%.2f,%.2f\n", number, single, all, all_no_crc);
+    }
+
+    return status;
+}
@@ -0,0 +1,86 @@
+//! \file bench_edge_tiva.c
+//! \brief Edge latency of the Tiva C physical layer, run on the target
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 9
+//!
+//! Prints, over UART0 at 115200 baud, the CPU cycles one edge takes with
+//! the driverlib reconfiguration the physical layer used to do and with
+//! the bit-band store to GPIODIR it does now, best of RUNS. The count ends
+//! when the last instruction retires; the write buffer of the APB bridge
+//! adds a few cycles before the pad moves, which only a scope shows.
+//!
+//! Not built by the CMake project: link it into a TM4C123 firmware with
+//! the TivaWare startup code, the library and src/ on the include path.
+
+#include "onewire.h"
+#include "onewire_phy.h"
+
+#include <inc/hw_memmap.h>
+#include <driverlib/gpio.h>
+#include <driverlib/pin_map.h>
+#include <driverlib/sysctl.h>
+#include <utils/uartstdio.h>
+
+
+#define RUNS        1000
+
+
+static uint32_t best(uint32_t current, uint32_t start) {
+    uint32_t cycles = timebase_now() - start;
+
+    return (cycles < current) ? cycles : current;
+}
+
+
+int main(void) {
+    tiva_PortPin_t pin = {GPIO_PORTB_BASE, GPIO_PIN_0};
+    onewire_bus_t bus;
+    uint32_t hold_before = UINT32_MAX;
+    uint32_t release_before = UINT32_MAX;
+    uint32_t hold_after = UINT32_MAX;
+    uint32_t release_after = UINT32_MAX;
+    uint32_t cycles_per_us;
+
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ | SYSCTL_OSC_MAIN);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
+    GPIOPinConfigure(GPIO_PA0_U0RX);
+    GPIOPinConfigure(GPIO_PA1_U0TX);
+    GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+    UARTStdioConfig(0, 115200, SysCtlClockGet());
+
+    tiva_onewire_init(&bus, pin);
+    cycles_per_us = SysCtlClockGet() / 1000000;
+
+    for (uint16_t run = 0; run < RUNS; run++) {
+        uint32_t start;
+
+        // before: pin direction and level set through driverlib
+        start = timebase_now();
+        GPIOPinTypeGPIOOutput(pin.base, pin.pin);
+        GPIOPinWrite(pin.base, pin.pin, 0);
+        hold_before = best(hold_before, start);
+
+        start = timebase_now();
+        GPIOPinTypeGPIOInput(pin.base, pin.pin);
+        release_before = best(release_before, start);
+
+        // after: one store to the GPIODIR bit, DATA latched at 0
+        GPIOPinWrite(pin.base, pin.pin, 0);
+
+        start = timebase_now();
+        holdBus(&bus);
+        hold_after = best(hold_after, start);
+
+        start = timebase_now();
+        releaseBus(&bus);
+        release_after = best(release_after, start);
+    }
+
+    UARTprintf("method,hold_cycles,release_cycles,cycles_per_us\n");
+    UARTprintf("driverlib,%u,%u,%u\n", hold_before, release_before, cycles_per_us);
+    UARTprintf("bitband,%u,%u,%u\n", hold_after, release_after, cycles_per_us);
+
+    for (;;);
+}
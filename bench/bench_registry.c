@@ -0,0 +1,98 @@
+//! \file bench_registry.c
+//! \brief Lookup time and memory of the address registry on the host
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 22
+//!
+//! Prints, for several bus sizes of DS18B20 serials, the average time of
+//! looking up a present address with a linear memcmp over an address_box
+//! and with onewire_registry_find(), next to the RAM each one takes.
+//! Times depend on the host; on AVR the cost follows the bytes read.
+
+#include "onewire_sim.h"
+#include "onewire_registry.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+
+#define MAX_SLAVES      255
+#define ROUNDS          2000
+
+
+static onewire_sim_ds18b20_t thermometers[MAX_SLAVES];
+static uint8_t address_box[MAX_SLAVES][8];
+static uint8_t entries[MAX_SLAVES][ONEWIRE_REGISTRY_ENTRY];
+
+
+static double now_us(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+
+static int16_t linearFind(uint8_t number, const uint8_t *address) {
+    for (uint8_t i = 0; i < number; i++) {
+        if (memcmp(address_box[i], address, 8) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+int main(void) {
+    static const uint8_t sizes[] = {20, 100, 255};
+    onewire_registry_t registry;
+    volatile int32_t sink = 0;
+    int status = 0;
+
+    for (uint16_t i = 0; i < MAX_SLAVES; i++) {
+        onewire_sim_ds18b20Init(&thermometers[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        memcpy(address_box[i], thermometers[i].device.ROM, 8);
+    }
+
+    printf("slaves,linear_ns,registry_ns,address_box_ram,registry_ram\n");
+
+    for (uint8_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        uint8_t number = sizes[k];
+        double start;
+        double linear;
+        double lookup;
+
+        onewire_registry_init(&registry, entries, number);
+        for (uint8_t i = 0; i < number; i++) {
+            status |= !onewire_registry_add(&registry, address_box[i]);
+        }
+        status |= registry.count != number;
+
+        start = now_us();
+        for (uint16_t round = 0; round < ROUNDS; round++) {
+            for (uint8_t i = 0; i < number; i++) {
+                sink += linearFind(number, address_box[i]);
+            }
+        }
+        linear = now_us() - start;
+
+        start = now_us();
+        for (uint16_t round = 0; round < ROUNDS; round++) {
+            for (uint8_t i = 0; i < number; i++) {
+                int16_t index = onewire_registry_find(&registry, address_box[i]);
+
+                status |= index < 0;
+                sink += index;
+            }
+        }
+        lookup = now_us() - start;
+
+        printf("%u,%.0f,%.0f,%u,%u\n", number,
+                linear * 1000 / ((double)ROUNDS * number),
+                lookup * 1000 / ((double)ROUNDS * number),
+                number * 8, number * ONEWIRE_REGISTRY_ENTRY);
+    }
+
+    return status;
+}
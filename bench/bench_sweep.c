@@ -0,0 +1,76 @@
+//! \file bench_sweep.c
+//! \brief Slot counts of the core API against a stored baseline
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 21
+//!
+//! Runs onewire_sim_benchmark() over a fixed set of device counts and
+//! compares every row with the CSV file given as argument; without an
+//! argument the rows are only printed, to write a new baseline:
+//!
+//!     bench_sweep > bench/bench_sweep.csv
+//!
+//! Virtual time is deterministic, any difference is a change of the slots
+//! the library puts on the bus.
+
+#include "onewire_sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+int main(int argc, char **argv) {
+    static const uint16_t counts[] = {1, 2, 10, 50, 100, 255};
+    char actual[128];
+    char expected[128];
+    FILE *output;
+    FILE *baseline;
+    unsigned line = 0;
+    unsigned differences = 0;
+
+    if (argc < 2) {
+        return onewire_sim_benchmark(stdout, ONEWIRE_SIM_CSV, counts,
+                                    sizeof(counts) / sizeof(counts[0])) ? 0 : 1;
+    }
+
+    baseline = fopen(argv[1], "r");
+    output = tmpfile();
+    if (!baseline || !output) {
+        printf("cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    if (!onewire_sim_benchmark(output, ONEWIRE_SIM_CSV, counts,
+                                sizeof(counts) / sizeof(counts[0])))
+    {
+        printf("a search did not find every device\n");
+        differences++;
+    }
+    rewind(output);
+
+    while (fgets(actual, sizeof(actual), output)) {
+        line++;
+
+        if (!fgets(expected, sizeof(expected), baseline)) {
+            printf("%u: not in baseline: %s", line, actual);
+            differences++;
+            continue;
+        }
+
+        if (strcmp(actual, expected) != 0) {
+            printf("%u: expected %s%u: measured %s", line, expected, line, actual);
+            differences++;
+        }
+    }
+
+    if (fgets(expected, sizeof(expected), baseline)) {
+        printf("%u: missing row: %s", line + 1, expected);
+        differences++;
+    }
+
+    fclose(output);
+    fclose(baseline);
+
+    printf("%u rows, %u differences\n", line, differences);
+
+    return differences ? 1 : 0;
+}
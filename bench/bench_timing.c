@@ -0,0 +1,81 @@
+//! \file bench_timing.c
+//! \brief Bus time of the timing profiles on a simulated line
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 13
+//!
+//! Prints, for each profile, the bus time of a reset, of one read slot and of
+//! a transaction made of reset, MATCH ROM, a command and a 9-byte read.
+//! Times are virtual, as a slave sees them; the overhead of the CPU
+//! between slots is not counted.
+
+#include "onewire_sim.h"
+#include "onewire_memory.h"
+
+#include <stdio.h>
+
+
+typedef struct profile {
+    const char *name;
+    const onewire_timing_t *timing;
+} profile_t;
+
+
+static double elapsed_us(const onewire_sim_t *sim) {
+    onewire_sim_counter_t counter;
+
+    onewire_sim_getCounters(sim, &counter);
+    return counter.time / 1000.0;
+}
+
+
+int main(void) {
+    const profile_t profiles[] = {
+        {"standard", &onewire_timing_standard},
+        {"overdrive", &onewire_timing_overdrive},
+        {"longline", &onewire_timing_longline},
+    };
+    onewire_sim_ds2431_t eeprom;
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+    uint8_t data[9];
+    int status = 0;
+
+    printf("profile,reset_us,read_slot_us,transaction_us\n");
+
+    for (uint8_t k = 0; k < sizeof(profiles) / sizeof(profiles[0]); k++) {
+        double reset;
+        double slot;
+        double transaction;
+
+        onewire_sim_init(&sim);
+        host_onewire_init(&bus, &sim);
+        onewire_sim_ds2431Init(&eeprom, onewire_sim_serial(ONEWIRE_SIM_RANDOM, 0));
+        onewire_sim_attach(&sim, &eeprom.device);
+
+        // the slave goes to overdrive with the master
+        if (profiles[k].timing == &onewire_timing_overdrive) {
+            status |= !onewire_overdriveSkip(&bus);
+        }
+        else {
+            onewire_setTiming(&bus, profiles[k].timing);
+        }
+
+        onewire_sim_clearCounters(&sim);
+        status |= !onewire_reset(&bus);
+        reset = elapsed_us(&sim);
+
+        onewire_sim_clearCounters(&sim);
+        onewire_receiveBuffer(&bus, data, 1);
+        slot = elapsed_us(&sim) / 8;
+
+        onewire_sim_clearCounters(&sim);
+        status |= !onewire_select(&bus, eeprom.device.ROM);
+        onewire_send(&bus, ONEWIRE_MEMORY_READ_SCRATCHPAD);
+        onewire_receiveBuffer(&bus, data, sizeof(data));
+        transaction = elapsed_us(&sim);
+
+        printf("%s,%.1f,%.1f,%.1f\n", profiles[k].name, reset, slot, transaction);
+    }
+
+    return status;
+}
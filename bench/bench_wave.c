@@ -0,0 +1,57 @@
+//! \file bench_wave.c
+//! \brief Encoding throughput of precomputed waveforms on the host
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 30
+//!
+//! Prints bytes encoded per microsecond for burst sizes of a symbol table,
+//! next to the bus time the same bytes take at standard and overdrive speed.
+
+#include "onewire_wave.h"
+
+#include <stdio.h>
+#include <time.h>
+
+
+#define ROUNDS  20000
+
+
+static double now_us(void) {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1e6 + time.tv_nsec / 1e3;
+}
+
+
+int main(void) {
+    static const uint16_t sizes[] = {1, 9, 32, 128};
+    static uint8_t data[128];
+    static uint32_t table[8 * 128];
+    volatile uint32_t sink = 0;
+    onewire_wave_t wave;
+
+    for (uint16_t i = 0; i < sizeof(data); i++) {
+        data[i] = i * 29 + 7;
+    }
+
+    onewire_wave_setup(&wave, &onewire_timing_standard, 80);
+
+    printf("bytes,bytes_per_us,bus_us_standard,bus_us_overdrive\n");
+
+    for (uint8_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        double start = now_us();
+        double elapsed;
+
+        for (uint32_t round = 0; round < ROUNDS; round++) {
+            data[0] = round;
+            sink += onewire_wave_encode(&wave, data, sizes[k], table);
+            sink += table[8 * sizes[k] - 1];
+        }
+
+        elapsed = now_us() - start;
+        printf("%u,%.0f,%u,%u\n", sizes[k], (double)sizes[k] * ROUNDS / elapsed,
+                sizes[k] * 8 * 70, sizes[k] * 8 * 10);
+    }
+
+    return sink ? 0 : 1;
+}
@@ -21,71 +21,406 @@ extern "C" {
 #define READ_ROM        0x33
 #define MATCH_ROM       0x55
 #define SKIP_ROM        0xCC
+#define ALARM_SEARCH    0xEC
+#define OVERDRIVE_SKIP  0x3C
+#define OVERDRIVE_MATCH 0x69
+#define RESUME          0xA5
+
+//! status codes of onewire_transfer()
+#define ONEWIRE_OK              0
+#define ONEWIRE_NO_PRESENCE     1   //!< no slave answered the reset
+#define ONEWIRE_NO_RESPONSE     2   //!< data read as all 1s, slave is gone
+#define ONEWIRE_CRC_ERROR       3   //!< data corrupted
+#define ONEWIRE_PROGRAM_ERROR   4   //!< memory copy not confirmed
+#define ONEWIRE_RANGE_ERROR     5   //!< outside of the device memory
+
+//! data check of onewire_transfer()
+#define ONEWIRE_CHECK_NONE      0x00
+#define ONEWIRE_CHECK_CRC8      0x01    //!< data ends with CRC-8 of data
+#define ONEWIRE_CHECK_CRC16     0x02    //!< data ends with inverted CRC-16 of command and data
+#define ONEWIRE_CHECK_RESUME    0x80    //!< retry with RESUME instead of MATCH ROM
+
+
+//! \brief convert microseconds to the unit of onewire_timing_t
+//!
+#define ONEWIRE_US(us)  ((uint16_t)((us) * 10))
+
+//! reset pulses shorter than this (overdrive) are kept in a masked section
+//! with ONEWIRE_SHORT_MASK, longer ones may be stretched by interrupts
+#define ONEWIRE_STRETCH_RESET_LOW   ONEWIRE_US(100)
+
+
+//! \brief Slot timing profile, values in tenths of microsecond.
+//!
+//! Field letters follow the naming used in Maxim application note 126.
+//!
+typedef struct onewire_timing {
+    uint16_t write1_low;        //!< A: low time of write-1 and read slots
+    uint16_t write1_recovery;   //!< B: recovery after write-1
+    uint16_t write0_low;        //!< C: low time of write-0 slot
+    uint16_t write0_recovery;   //!< D: recovery after write-0
+    uint16_t read_sample;       //!< E: release to sample point of read slot
+    uint16_t read_recovery;     //!< F: sample point to end of read slot
+    uint16_t reset_delay;       //!< G: idle time before reset pulse
+    uint16_t reset_low;         //!< H: reset pulse
+    uint16_t presence_sample;   //!< I: release to presence sample point
+    uint16_t reset_recovery;    //!< J: presence sample to end of reset
+} onewire_timing_t;
+
+
+//! \brief Standard speed timing profile.
+//!
+extern const onewire_timing_t onewire_timing_standard;
+
+
+//! \brief Overdrive speed timing profile.
+//!
+extern const onewire_timing_t onewire_timing_overdrive;
+
+
+//! \brief Standard speed profile for long or heavily loaded lines.
+//!
+//! Longer recovery and a later sample point, at the cost of about 12% throughput.
+//! Copy and adjust it to build a profile for a specific line.
+//!
+extern const onewire_timing_t onewire_timing_longline;
+
+// Reset + MATCH ROM + command + 9-byte read, simulated by bench_timing:
+// standard 11.6 ms, overdrive 1.5 ms, longline 13.2 ms.
+
+
+#if defined(__AVR__)
+typedef avr_PortPin_t onewire_pin_t;
+typedef avr_PortPin_t onewire_port_t;           //!< pin field unused
+#elif defined(ONEWIRE_HOST)
+typedef struct onewire_sim *onewire_pin_t;
+typedef struct onewire_sim **onewire_port_t;    //!< one line per pin
+#else
+//! \brief Tiva pin whose DATA bit stays 0, an edge only changes GPIODIR.
+//!
+typedef struct tiva_onewire_pin {
+    uint32_t base;                      //!< memory base of GPIO port
+    uint8_t pin;                        //!< GPIO pin
+    volatile uint32_t *data;            //!< DATA alias that only reads pin
+    volatile uint32_t *dir;             //!< bit-band alias of the GPIODIR bit of pin
+} tiva_onewire_pin_t;
+
+typedef tiva_onewire_pin_t onewire_pin_t;
+typedef tiva_PortPin_t onewire_port_t;          //!< pin field unused
+#endif
+
+
+struct onewire_bus;
+
+//! \brief Physical layer that replaces GPIO bit-banging on a bus.
+//!
+//! reset and touchBit are mandatory, buffer operations are optional and
+//! fall back to touchBit when NULL. triplet runs one search bit: two read
+//! slots, then writes the bit read if they differ, direction otherwise;
+//! it returns the two bits read as ONEWIRE_TRIPLET_xx flags. idle waits ms
+//! milliseconds with the line released; it may only be NULL for drivers
+//! that keep bus->pin and the platform delays, as onewire_idle() then
+//! counts the time with them. setTiming, optional, is called by
+//! onewire_setTiming() once bus->timing is the new profile, for drivers
+//! whose hardware must be switched to its speed.
+//!
+typedef struct onewire_driver {
+    bool (*reset)(struct onewire_bus *bus);
+    uint8_t (*touchBit)(struct onewire_bus *bus, uint8_t bit);
+    void (*sendBuffer)(struct onewire_bus *bus, const uint8_t *data, uint16_t len);
+    void (*receiveBuffer)(struct onewire_bus *bus, uint8_t *data, uint16_t len);
+    uint8_t (*triplet)(struct onewire_bus *bus, uint8_t direction);
+    void (*idle)(struct onewire_bus *bus, uint16_t ms);
+    void (*setTiming)(struct onewire_bus *bus);
+} onewire_driver_t;
+
+//! bits read by onewire_driver_t.triplet
+#define ONEWIRE_TRIPLET_ID          0x01
+#define ONEWIRE_TRIPLET_COMPLEMENT  0x02
+
+
+#ifdef ONEWIRE_STATS
+
+//! number of log2 buckets of the histograms, the last one collects the rest
+#define ONEWIRE_STATS_BUCKETS       16
+
+//! count an event in the stats block of a bus
+#define ONEWIRE_STATS_COUNT(bus, counter)   ((bus)->stats.counter++)
+
+//! \brief Event counters and histograms of a bus.
+//!
+//! Times are nominal, computed from the timing profile: bucket k counts
+//! durations from 2^k to 2^(k+1) microseconds. A transaction lasts from
+//! a reset to the next one. Masked windows are only recorded for
+//! bit-banged buses.
+//!
+typedef struct onewire_stats {
+    uint32_t resets;                //!< reset pulses
+    uint32_t presence_failures;     //!< resets without presence pulse
+    uint32_t line_timeouts;         //!< line held low before a reset
+    uint32_t crc_failures;          //!< CRC errors in search or data
+    uint32_t retries;               //!< transactions repeated after an error
+    uint32_t searches;              //!< search calls
+    uint32_t transaction;           //!< running transaction, tenths of us
+    uint16_t duration[ONEWIRE_STATS_BUCKETS];   //!< transaction durations
+    uint16_t masked[ONEWIRE_STATS_BUCKETS];     //!< interrupt-masked windows
+} onewire_stats_t;
+
+#else
+
+#define ONEWIRE_STATS_COUNT(bus, counter)
+
+#endif
+
+
+//! \brief 1-wire bus handle, one for each bus driven by the firmware.
+//!
+typedef struct onewire_bus {
+    onewire_pin_t pin;                  //!< GPIO port and pin
+    const onewire_driver_t *driver;     //!< NULL for GPIO bit-banging
+    void *context;                      //!< driver specific data
+    const onewire_timing_t *timing;     //!< selected timing profile
+    onewire_timing_t delay;             //!< profile in platform delay units
+    void (*pullup)(struct onewire_bus *bus, bool on);   //!< strong pull-up switch, NULL if none
+    uint8_t last_conflict_bit;          //!< search state
+    bool is_last_device_found;          //!< search state
+    uint8_t ROM[8];                     //!< search state
+#ifdef ONEWIRE_STATS
+    onewire_stats_t stats;              //!< event counters
+#endif
+} onewire_bus_t;
 
 
 //! \brief initialize GPIO pin for 1-wire communication
+//! \param bus bus handle
 //! \param pin GPIO port and pin.
 //!
-void avr_onewire_init(avr_PortPin_t pin);
+void avr_onewire_init(onewire_bus_t *bus, avr_PortPin_t pin);
 
 
 //! \brief initialize GPIO pin for 1-wire communication
+//! \param bus bus handle
 //! \param pin GPIO port and pin.
 //!
-void tiva_onewire_init(tiva_PortPin_t pin);
+void tiva_onewire_init(onewire_bus_t *bus, tiva_PortPin_t pin);
+
+
+//! \brief select slot timing profile of a bus
+//! \param bus bus handle
+//! \param timing timing profile, must stay valid while the bus is used
+//!
+void onewire_setTiming(onewire_bus_t *bus, const onewire_timing_t *timing);
+
+
+//! \brief leave the line released while a slave draws power from it
+//! \param bus bus handle
+//! \param ms idle time in milliseconds
+//! \param strong switch the strong pull-up of the bus on during that time
+//!
+//! Parasite-powered slaves programming their EEPROM may need more current
+//! than the pull-up resistor supplies; bus->pullup, set by the application
+//! after the bus init, then switches a strong pull-up such as a P-MOSFET to
+//! VCC. Without it the line is only released. No slot may run meanwhile.
+//! Buses driven by a driver wait through its idle operation.
+//!
+void onewire_idle(onewire_bus_t *bus, uint16_t ms, bool strong);
+
+
+//! \brief switch all slaves to overdrive speed
+//! \param bus bus handle
+//! \return true if a slave answered the reset
+//!
+//! The bus timing profile is changed to onewire_timing_overdrive, slaves
+//! without overdrive support stay silent until the next standard reset.
+//!
+bool onewire_overdriveSkip(onewire_bus_t *bus);
+
+
+//! \brief switch one slave to overdrive speed and select it
+//! \param bus bus handle
+//! \param address slave's address
+//! \return true if a slave answered the reset
+//!
+bool onewire_overdriveSelect(onewire_bus_t *bus, const uint8_t *address);
+
+
+//! \brief switch the bus and all slaves back to standard speed
+//! \param bus bus handle
+//! \return true if a slave answered the reset
+//!
+bool onewire_standardSpeed(onewire_bus_t *bus);
 
 
 //! \brief get address of the next slave on multi-drop bus
+//! \param bus bus handle
 //! \param address slave's address
 //!
-uint8_t onewire_search(uint8_t address_box[][8], uint8_t number);
+uint8_t onewire_search(onewire_bus_t *bus, uint8_t address_box[][8], uint8_t number);
+
+
+//! \brief get addresses of slaves whose alarm flag is set
+//! \param bus bus handle
+//! \param address_box array of addresses to fill
+//! \param number size of address_box
+//! \return number of addresses found
+//!
+uint8_t onewire_searchAlarm(onewire_bus_t *bus, uint8_t address_box[][8], uint8_t number);
+
+
+//! \brief get addresses of slaves of one family on multi-drop bus
+//! \param bus bus handle
+//! \param family_code family code, first byte of address
+//! \param address_box array of addresses to fill
+//! \param number size of address_box
+//! \return number of addresses found
+//!
+//! The search starts on the path of the family code and stops as soon as
+//! it would branch out of it, so other families cost no search pass.
+//!
+uint8_t onewire_searchFamily(onewire_bus_t *bus, uint8_t family_code,
+                            uint8_t address_box[][8], uint8_t number);
+
+
+//! \brief start a search run one address at a time
+//! \param bus bus handle
+//!
+void onewire_searchStart(onewire_bus_t *bus);
+
+
+//! \brief run the next pass of a search started by onewire_searchStart()
+//! \param bus bus handle
+//! \param address slave's address, 8 bytes
+//! \return 1 if an address was found, 0 at the end, -1 on a CRC error
+//!
+//! A pass with a CRC error still moves the search on, the caller bounds
+//! the number of passes.
+//!
+int8_t onewire_searchNext(onewire_bus_t *bus, uint8_t *address);
 
 
 //! \brief get address of the slave on single-drop bus
+//! \param bus bus handle
 //! \param address slave's address
 //!
-bool onewire_getSlaveAddress(uint8_t *address);
+bool onewire_getSlaveAddress(onewire_bus_t *bus, uint8_t *address);
 
 
 //! \brief select slave with specific address
+//! \param bus bus handle
 //! \param address slave's address
 //!
-bool onewire_select(const uint8_t *address);
+bool onewire_select(onewire_bus_t *bus, const uint8_t *address);
 
 //! \brief select all slaves on bus
+//! \param bus bus handle
 //!
-bool onewire_selectAll(void);
+bool onewire_selectAll(onewire_bus_t *bus);
 
 
 //! \brief reset 1-wire bus
+//! \param bus bus handle
+//!
+bool onewire_reset(onewire_bus_t *bus);
+
+
+//! \brief send 1 bit to slave
+//! \param bus bus handle
+//! \param bit '0' or '1'
+//!
+void onewire_sendBit(onewire_bus_t *bus, uint8_t bit);
+
+
+//! \brief receive 1 bit from slave
+//! \param bus bus handle
+//! \return '0' or '1'
 //!
-bool onewire_reset(void);
+uint8_t onewire_receiveBit(onewire_bus_t *bus);
 
 
 //! \brief send 1 byte to slave
+//! \param bus bus handle
 //! \param data 1 byte data
 //!
-void onewire_send(uint8_t data);
+void onewire_send(onewire_bus_t *bus, uint8_t data);
 
 
 //! \brief send a buffer to slave
+//! \param bus bus handle
 //! \param buffer pointer to data buffer
 //! \param len the size of data buffer
 //!
-void onewire_sendBuffer(const void *buffer, uint16_t len);
+void onewire_sendBuffer(onewire_bus_t *bus, const void *buffer, uint16_t len);
 
 
 //! \brief receive 1 byte from slave
+//! \param bus bus handle
 //! \return 1 byte
 //!
-uint8_t onewire_receive(void);
+uint8_t onewire_receive(onewire_bus_t *bus);
 
 
 //! \brief receive a buffer from slave
+//! \param bus bus handle
 //! \param buffer pointer to data buffer
 //! \param len the size of data buffer
 //!
-void onewire_receiveBuffer(void *buffer, uint16_t len);
+void onewire_receiveBuffer(onewire_bus_t *bus, void *buffer, uint16_t len);
+
+//! \brief worst-case time a bus keeps interrupts masked
+//! \param bus bus handle
+//! \return time in tenths of microsecond for the current timing profile
+//!
+//! Build with ONEWIRE_SHORT_MASK to mask interrupts only during low
+//! pulses and up to sample points, leaving recovery time interruptible:
+//!
+//! | profile   | default | ONEWIRE_SHORT_MASK |
+//! |-----------|---------|--------------------|
+//! | standard  | 960 us  | 70 us              |
+//! | overdrive | 121 us  | 78.5 us            |
+//! | longline  | 1 ms    | 80 us              |
+//!
+//! An interrupt handler may then delay a slot by its own run time, which
+//! must stay below the shortest recovery time of the profile.
+//!
+uint16_t onewire_maskedTime(const onewire_bus_t *bus);
+
+
+//! \brief run a command that reads checked data, repeat it on error
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param command command and its parameters
+//! \param command_len the size of command
+//! \param data receive buffer, including the CRC bytes
+//! \param len the size of data
+//! \param check ONEWIRE_CHECK_xx, optionally or'ed with ONEWIRE_CHECK_RESUME
+//! \param retries number of repeats allowed after the first attempt
+//! \return ONEWIRE_OK or the error of the last attempt
+//!
+//! A repeat only costs reset, RESUME or MATCH ROM, command and read.
+//! RESUME saves the 64 address bits but requires slaves that support it,
+//! such as DS2431 and DS2413; DS18B20 does not.
+//!
+uint8_t onewire_transfer(onewire_bus_t *bus, const uint8_t *address,
+                        const uint8_t *command, uint8_t command_len,
+                        uint8_t *data, uint16_t len, uint8_t check, uint8_t retries);
+
+
+#ifdef ONEWIRE_STATS
+
+//! \brief copy the stats block of a bus
+//! \param bus bus handle
+//! \param stats output copy
+//!
+void onewire_stats_snapshot(const onewire_bus_t *bus, onewire_stats_t *stats);
+
+
+//! \brief clear the stats block of a bus
+//! \param bus bus handle
+//!
+void onewire_stats_clear(onewire_bus_t *bus);
+
+#endif
+
 
 //! \brief check the integrity of data with CRC-8
 //! \param data pointer to data buffer
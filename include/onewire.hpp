@@ -0,0 +1,397 @@
+//! \file onewire.hpp
+//! \brief Header-only C++17 layer over the 1-wire C API
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 13
+//!
+//! Every member forwards to the C functions of onewire.h and is defined
+//! in this header, so the compiler inlines it into the caller:
+//!
+//!     struct SensorPhy {
+//!         static void init(onewire_bus_t *bus) { sensor_init(bus); }
+//!     };
+//!
+//!     onewire::Bus<SensorPhy, onewire::timing::Standard> bus;
+//!     onewire::Rom roms[8];
+//!
+//!     size_t n = bus.search(roms);
+//!
+//!     if (onewire::Transaction t{bus, roms[0]}) {
+//!         uint8_t scratchpad[9];
+//!         t.send(0xBE);
+//!         t.receive(scratchpad);
+//!     }
+//!
+//! Phy is any type with a static init(onewire_bus_t *) that sets up the
+//! bus, e.g. around avr_onewire_init(), or around the init function made
+//! by onewire_avr_fixed.h to get slot edges inlined as single
+//! instructions. Timing is a type with a constexpr onewire_timing_t
+//! value, checked at compile time; on AVR the delays are also checked
+//! against F_CPU and converted to _delay_loop_2() iterations at compile
+//! time, onewire_setTiming() is not called.
+//!
+//! Transaction does not lock the bus by default. A bus shared with an
+//! interrupt handler takes lock::Flag as third parameter:
+//!
+//!     onewire::Bus<SensorPhy, onewire::timing::Standard, onewire::lock::Flag> bus;
+//!
+//! Generated code for reading a DS18B20 scratchpad with MATCH ROM and
+//! CRC check, host gcc/g++ 12 with -fno-exceptions:
+//!
+//! | path                    | text -O2  | text -Os | library calls |
+//! |-------------------------|-----------|----------|---------------|
+//! | C API                   | 77 bytes  | 71 bytes | 4             |
+//! | this header, lock::None | 88 bytes  | 71 bytes | 4             |
+//! | this header, lock::Flag | 115 bytes | 97 bytes | 4             |
+//!
+//! With lock::None the code is as small as the C path at -Os; at -O2 g++
+//! lays out the early return apart, with a second epilogue and alignment
+//! padding, which makes the 11 extra bytes. lock::Flag adds a load, a
+//! compare and two stores of its volatile flag around the transaction.
+//! Every path makes the same calls into the library, so the bus sees the
+//! same slots with the same timing. Without -fno-exceptions g++ also emits
+//! an unwinding path, since the C functions are not declared noexcept.
+
+#ifndef __ONEWIRE_HPP__
+#define __ONEWIRE_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "onewire.h"
+
+
+namespace onewire {
+
+//! \brief CRC-8 of a buffer, usable in constant expressions
+//!
+constexpr uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc = 0) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1;
+        }
+    }
+
+    return crc;
+}
+
+
+//! \brief Non-owning view of a buffer, as std::span of C++20.
+//!
+template <typename T>
+class Span {
+public:
+    constexpr Span() : data_(nullptr), size_(0) {}
+    constexpr Span(T *data, size_t size) : data_(data), size_(size) {}
+
+    template <size_t N>
+    constexpr Span(T (&array)[N]) : data_(array), size_(N) {}
+
+    //! a read-only view of a mutable buffer
+    template <typename U>
+    constexpr Span(const Span<U> &other) : data_(other.data()), size_(other.size()) {}
+
+    constexpr T *data() const { return data_; }
+    constexpr size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr T *begin() const { return data_; }
+    constexpr T *end() const { return data_ + size_; }
+    constexpr T &operator[](size_t i) const { return data_[i]; }
+
+    constexpr Span first(size_t n) const { return Span(data_, n); }
+    constexpr Span last(size_t n) const { return Span(data_ + size_ - n, n); }
+
+private:
+    T *data_;
+    size_t size_;
+};
+
+
+//! \brief 64-bit ROM code: family code, serial number and CRC-8.
+//!
+//! Layout is exactly uint8_t[8], so arrays of Rom are passed as they are
+//! to the search functions.
+//!
+class Rom {
+public:
+    constexpr Rom() : bytes_{} {}
+
+    constexpr Rom(uint8_t family, uint8_t s0, uint8_t s1, uint8_t s2,
+                    uint8_t s3, uint8_t s4, uint8_t s5, uint8_t crc)
+        : bytes_{family, s0, s1, s2, s3, s4, s5, crc} {}
+
+    //! \brief copy a ROM code from a C address
+    static Rom from(const uint8_t *address) {
+        Rom rom;
+
+        for (uint8_t i = 0; i < 8; i++) {
+            rom.bytes_[i] = address[i];
+        }
+
+        return rom;
+    }
+
+    //! \brief CRC of the ROM code matches, all-zero codes are invalid
+    constexpr bool valid() const {
+        return bytes_[0] != 0 && crc8(bytes_, 7) == bytes_[7];
+    }
+
+    constexpr uint8_t family() const { return bytes_[0]; }
+    constexpr uint8_t operator[](size_t i) const { return bytes_[i]; }
+    constexpr const uint8_t *data() const { return bytes_; }
+    uint8_t *data() { return bytes_; }
+
+    constexpr bool operator==(const Rom &other) const {
+        for (uint8_t i = 0; i < 8; i++) {
+            if (bytes_[i] != other.bytes_[i]) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    constexpr bool operator!=(const Rom &other) const { return !(*this == other); }
+
+private:
+    uint8_t bytes_[8];
+};
+
+static_assert(sizeof(Rom) == 8, "Rom must map onto uint8_t[8]");
+
+// example of Maxim application note 27
+static_assert(Rom(0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2).valid(), "CRC-8 broken");
+
+
+//! \brief Timing profiles, same values as the C profiles of onewire.h.
+//!
+namespace timing {
+
+struct Standard {
+    static constexpr onewire_timing_t value = {
+        ONEWIRE_US(6), ONEWIRE_US(64), ONEWIRE_US(60), ONEWIRE_US(10),
+        ONEWIRE_US(9), ONEWIRE_US(55),
+        ONEWIRE_US(0), ONEWIRE_US(480), ONEWIRE_US(70), ONEWIRE_US(410),
+    };
+};
+
+struct Overdrive {
+    static constexpr onewire_timing_t value = {
+        ONEWIRE_US(1), ONEWIRE_US(7.5), ONEWIRE_US(7.5), ONEWIRE_US(2.5),
+        ONEWIRE_US(1), ONEWIRE_US(7),
+        ONEWIRE_US(2.5), ONEWIRE_US(70), ONEWIRE_US(8.5), ONEWIRE_US(40),
+    };
+};
+
+struct Longline {
+    static constexpr onewire_timing_t value = {
+        ONEWIRE_US(6), ONEWIRE_US(74), ONEWIRE_US(60), ONEWIRE_US(20),
+        ONEWIRE_US(12), ONEWIRE_US(62),
+        ONEWIRE_US(0), ONEWIRE_US(500), ONEWIRE_US(80), ONEWIRE_US(420),
+    };
+};
+
+} // namespace timing
+
+
+//! \brief Lock policies of a Bus, checked by Transaction.
+//!
+namespace lock {
+
+//! \brief No lock, a Transaction only resets and selects as the C API does.
+struct None {
+    constexpr bool acquire() { return true; }
+    constexpr void release() {}
+};
+
+//! \brief Flag refusing a Transaction while another one holds the bus,
+//! e.g. one started from an interrupt handler.
+class Flag {
+public:
+    bool acquire() {
+        if (locked_) {
+            return false;
+        }
+
+        locked_ = true;
+        return true;
+    }
+
+    void release() { locked_ = false; }
+
+private:
+    volatile bool locked_ = false;  //!< also taken by interrupt handlers
+};
+
+} // namespace lock
+
+
+//! \brief 1-wire bus with its platform and timing fixed at compile time.
+//!
+template <typename Phy, typename Timing, typename Lock = lock::None>
+class Bus {
+public:
+    static constexpr const onewire_timing_t &profile = Timing::value;
+
+    static_assert(profile.write1_low < profile.write0_low,
+                    "write-1 low time must be shorter than write-0 low time");
+    static_assert(profile.write1_low + profile.read_sample < profile.write0_low,
+                    "read sample point must fall inside a write-0 low time");
+    static_assert(profile.write0_low < profile.reset_low,
+                    "reset pulse must be longer than any slot");
+
+#if defined(__AVR__)
+    //! \brief tenths of microsecond to _delay_loop_2() iterations
+    static constexpr uint16_t ticks(uint16_t time) {
+        return ((uint32_t)time * (F_CPU / 10000UL) + 2000) / 4000;
+    }
+
+    //! \brief the profile in _delay_loop_2() iterations, as onewire_setTiming()
+    //! converts it at run time
+    static constexpr onewire_timing_t convert() {
+        onewire_timing_t converted = {};
+
+        converted.write1_low = ticks(profile.write1_low);
+        converted.write1_recovery = ticks(profile.write1_recovery);
+        converted.write0_low = ticks(profile.write0_low);
+        converted.write0_recovery = ticks(profile.write0_recovery);
+        converted.read_sample = ticks(profile.read_sample);
+        converted.read_recovery = ticks(profile.read_recovery);
+        converted.reset_delay = ticks(profile.reset_delay);
+        converted.reset_low = ticks(profile.reset_low);
+        converted.presence_sample = ticks(profile.presence_sample);
+        converted.reset_recovery = ticks(profile.reset_recovery);
+
+        return converted;
+    }
+
+    static constexpr onewire_timing_t delay = convert();
+
+    static_assert(delay.write1_low > 0, "F_CPU too low for this profile");
+    static_assert((uint32_t)profile.reset_low * (F_CPU / 10000UL) / 4000 < 65536,
+                    "reset pulse overflows _delay_loop_2()");
+#endif
+
+    Bus() {
+        Phy::init(&bus_);
+
+#if defined(__AVR__)
+        // no 32-bit divisions at run time
+        bus_.timing = &profile;
+        bus_.delay = delay;
+#else
+        onewire_setTiming(&bus_, &profile);
+#endif
+    }
+
+    Bus(const Bus &) = delete;
+    Bus &operator=(const Bus &) = delete;
+
+    //! \brief the C bus handle, for the rest of the C API
+    onewire_bus_t *native() { return &bus_; }
+
+    bool reset() { return onewire_reset(&bus_); }
+    bool select(const Rom &rom) { return onewire_select(&bus_, rom.data()); }
+    bool selectAll() { return onewire_selectAll(&bus_); }
+
+    void send(uint8_t data) { onewire_send(&bus_, data); }
+    uint8_t receive() { return onewire_receive(&bus_); }
+
+    void send(Span<const uint8_t> data) {
+        onewire_sendBuffer(&bus_, data.data(), data.size());
+    }
+
+    void receive(Span<uint8_t> data) {
+        onewire_receiveBuffer(&bus_, data.data(), data.size());
+    }
+
+    //! \brief search all slaves
+    //! \return number of ROM codes written to roms
+    size_t search(Span<Rom> roms) {
+        return onewire_search(&bus_, rawRoms(roms), roms.size());
+    }
+
+    //! \brief search slaves in alarm state
+    size_t searchAlarm(Span<Rom> roms) {
+        return onewire_searchAlarm(&bus_, rawRoms(roms), roms.size());
+    }
+
+    //! \brief search slaves of one family
+    size_t searchFamily(uint8_t family, Span<Rom> roms) {
+        return onewire_searchFamily(&bus_, family, rawRoms(roms), roms.size());
+    }
+
+    //! \brief onewire_transfer() to one slave
+    uint8_t transfer(const Rom &rom, Span<const uint8_t> command, Span<uint8_t> data,
+                        uint8_t check, uint8_t retries = 0) {
+        return onewire_transfer(&bus_, rom.data(), command.data(), command.size(),
+                                data.data(), data.size(), check, retries);
+    }
+
+    //! \brief onewire_transfer() with SKIP ROM
+    uint8_t transfer(Span<const uint8_t> command, Span<uint8_t> data,
+                        uint8_t check, uint8_t retries = 0) {
+        return onewire_transfer(&bus_, nullptr, command.data(), command.size(),
+                                data.data(), data.size(), check, retries);
+    }
+
+private:
+    template <typename, typename, typename> friend class Transaction;
+
+    static uint8_t (*rawRoms(Span<Rom> roms))[8] {
+        return reinterpret_cast<uint8_t (*)[8]>(roms.data());
+    }
+
+    onewire_bus_t bus_;
+    Lock lock_;
+};
+
+
+//! \brief Reset and select on construction, bus locked until destruction.
+//!
+//! Evaluates to false when no slave answered the reset or, with
+//! lock::Flag, when the bus is already held by another transaction.
+//!
+template <typename Phy, typename Timing, typename Lock>
+class Transaction {
+public:
+    //! \brief address one slave with MATCH ROM
+    Transaction(Bus<Phy, Timing, Lock> &bus, const Rom &rom)
+        : bus_(bus), owner_(bus.lock_.acquire())
+    {
+        present_ = owner_ && bus_.select(rom);
+    }
+
+    //! \brief address all slaves with SKIP ROM
+    explicit Transaction(Bus<Phy, Timing, Lock> &bus)
+        : bus_(bus), owner_(bus.lock_.acquire())
+    {
+        present_ = owner_ && bus_.selectAll();
+    }
+
+    ~Transaction() {
+        if (owner_) {
+            bus_.lock_.release();
+        }
+    }
+
+    Transaction(const Transaction &) = delete;
+    Transaction &operator=(const Transaction &) = delete;
+
+    explicit operator bool() const { return present_; }
+
+    void send(uint8_t data) { bus_.send(data); }
+    uint8_t receive() { return bus_.receive(); }
+    void send(Span<const uint8_t> data) { bus_.send(data); }
+    void receive(Span<uint8_t> data) { bus_.receive(data); }
+
+private:
+    Bus<Phy, Timing, Lock> &bus_;
+    bool owner_;
+    bool present_;
+};
+
+} // namespace onewire
+
+#endif
@@ -0,0 +1,157 @@
+//! \file onewire_async.h
+//! \brief Non-blocking 1-wire transactions driven by a timer interrupt
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 23
+//!
+//! A transaction (reset, ROM command, write bytes, read bytes) is submitted
+//! and runs slot by slot from a one-shot timer interrupt. The low times of
+//! slots, the read sample point and the presence wait of a reset are
+//! busy-waited in the interrupt with interrupts disabled; the recovery
+//! times and the reset pulse at standard speed are waited by the timer.
+//! Interrupt latency lengthens those: recovery times have no upper
+//! bound, and a standard-speed reset pulse is only too long past 960 us,
+//! so latency must stay below 480 us. At overdrive the whole reset pulse
+//! is busy-waited too. The CPU is held for at most tLOW0 per slot (60 us
+//! at standard speed, 7.5 us at overdrive) and, per reset, 70 us at
+//! standard speed and 78.5 us at overdrive.
+//!
+//! Only GPIO bit-banged buses (no driver) can be used asynchronously, and
+//! the bus must not be used by the blocking API while a transaction runs.
+
+#ifndef __ONEWIRE_ASYNC__
+#define __ONEWIRE_ASYNC__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+#define ONEWIRE_ASYNC_PENDING       0
+#define ONEWIRE_ASYNC_DONE          1
+#define ONEWIRE_ASYNC_NO_PRESENCE   2
+
+
+//! \brief One-shot timer that calls onewire_async_tick() from its interrupt.
+//!
+typedef struct onewire_timer_port {
+    //! fire once after time tenths of microsecond
+    void (*schedule)(void *context, uint16_t time);
+
+    //! cancel the pending interrupt, if any
+    void (*stop)(void *context);
+
+    void *context;
+} onewire_timer_port_t;
+
+
+struct onewire_transaction;
+
+//! \brief Transaction submitted to onewire_async_submit().
+//!
+typedef struct onewire_transaction {
+    bool reset;                 //!< start with a reset pulse
+    uint8_t rom_command;        //!< SKIP_ROM, MATCH_ROM, ... or 0 for none
+    const uint8_t *address;     //!< 8-byte address sent after MATCH_ROM
+    const uint8_t *tx;          //!< bytes written after the ROM command
+    uint16_t tx_len;
+    uint8_t *rx;                //!< bytes read after the written ones
+    uint16_t rx_len;
+
+    //! called from the timer interrupt when the transaction ends, may be NULL
+    void (*callback)(struct onewire_transaction *transaction);
+    void *arg;                  //!< free for the caller
+
+    volatile uint8_t status;    //!< ONEWIRE_ASYNC_PENDING until it ends
+} onewire_transaction_t;
+
+
+//! \brief Asynchronous engine, one for each bus.
+//!
+typedef struct onewire_async {
+    onewire_bus_t *bus;
+    const onewire_timer_port_t *timer;
+    onewire_transaction_t *volatile transaction;    //!< NULL when idle
+    uint8_t state;
+    uint8_t stage;
+    uint16_t index;             //!< byte index in the current stage
+    uint8_t mask;               //!< bit mask in the current byte
+    uint8_t data;               //!< byte being written or read
+    bool presence;
+} onewire_async_t;
+
+
+//! \brief Tiva C general purpose timer used as one-shot timer.
+//!
+//! The application enables the timer peripheral, and calls
+//! tiva_onewire_timerISR() from the timer A interrupt handler.
+//!
+typedef struct tiva_timer {
+    uint32_t base;              //!< timer base address, e.g. TIMER0_BASE
+    uint32_t ticks_per_us;      //!< set by tiva_onewire_timerInit()
+    onewire_timer_port_t port;  //!< filled by tiva_onewire_timerInit()
+} tiva_timer_t;
+
+
+//! \brief attach an asynchronous engine to a bus
+//! \param engine asynchronous engine
+//! \param bus GPIO bit-banged bus
+//! \param timer timer port, must stay valid while the engine is used
+//!
+void onewire_async_init(onewire_async_t *engine, onewire_bus_t *bus,
+                        const onewire_timer_port_t *timer);
+
+
+//! \brief start a transaction
+//! \param engine asynchronous engine
+//! \param transaction transaction, must stay valid until it ends
+//! \return false if another transaction is running
+//!
+bool onewire_async_submit(onewire_async_t *engine, onewire_transaction_t *transaction);
+
+
+//! \brief check whether a transaction is running
+//! \param engine asynchronous engine
+//! \return true or false
+//!
+bool onewire_async_isBusy(const onewire_async_t *engine);
+
+
+//! \brief run the next step of the current transaction
+//! \param engine asynchronous engine
+//!
+//! Call from the timer interrupt handler.
+//!
+void onewire_async_tick(onewire_async_t *engine);
+
+
+//! \brief use Timer1 compare A of AVR as one-shot timer
+//! \param port timer port to fill
+//!
+//! Timer1 runs free with prescaler 8. The application calls
+//! onewire_async_tick() from ISR(TIMER1_COMPA_vect).
+//!
+void avr_onewire_timerInit(onewire_timer_port_t *port);
+
+
+//! \brief use a Tiva C timer as one-shot timer
+//! \param timer timer description
+//!
+void tiva_onewire_timerInit(tiva_timer_t *timer);
+
+
+//! \brief handle a Tiva C timer interrupt
+//! \param timer timer description
+//! \param engine asynchronous engine driven by this timer
+//!
+void tiva_onewire_timerISR(tiva_timer_t *timer, onewire_async_t *engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,195 @@
+//! \file onewire_avr_fixed.h
+//! \brief 1-wire driver for AVR bound to one pin at compile time
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 11
+//!
+//! avr_onewire_init() reaches the I/O registers through the pointers of
+//! avr_PortPin_t, so every edge is a read-modify-write through a pointer
+//! with a runtime bit mask. Including this file with a fixed port and pin
+//! generates a driver whose edges are single cbi/sbi instructions and
+//! whose sample is a single sbis:
+//!
+//!     #define ONEWIRE_FIXED_NAME  sensor
+//!     #define ONEWIRE_FIXED_DDR   DDRB
+//!     #define ONEWIRE_FIXED_PORT  PORTB
+//!     #define ONEWIRE_FIXED_PIN   PINB
+//!     #define ONEWIRE_FIXED_BIT   0
+//!     #include "onewire_avr_fixed.h"
+//!
+//!     sensor_init(&bus);
+//!
+//! The file can be included again with other parameters for more buses.
+//! Timing profiles, search and every other API work unchanged on the bus.
+//!
+//! Estimated cost inside the timing windows, counted by hand from the
+//! instruction sequences avr-gcc -O2 is expected to emit, not measured
+//! on a build (registers in the low I/O space, as PORTB..PORTD of
+//! ATmega328P):
+//!
+//! | hook           | runtime pointers      | fixed pin        |
+//! |----------------|-----------------------|------------------|
+//! | hold           | 20..40 cycles, ~30 B  | 4 cycles, 4 B    |
+//! | release        | 20..40 cycles, ~30 B  | 4 cycles, 4 B    |
+//! | sample         | 10..25 cycles, ~16 B  | 2 cycles, 4 B    |
+//!
+//! The runtime range comes from the shift loop building 1 << pin. At
+//! 1 MHz the runtime path alone exceeds the 6 us write-1 low time.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay_basic.h>
+
+#include "onewire.h"
+
+#if !defined(ONEWIRE_FIXED_NAME) || !defined(ONEWIRE_FIXED_DDR) \
+    || !defined(ONEWIRE_FIXED_PORT) || !defined(ONEWIRE_FIXED_PIN) \
+    || !defined(ONEWIRE_FIXED_BIT)
+#error "define ONEWIRE_FIXED_NAME, _DDR, _PORT, _PIN and _BIT first"
+#endif
+
+#define ONEWIRE_FIXED_JOIN(name, suffix)    name##suffix
+#define ONEWIRE_FIXED_SYMBOL(name, suffix)  ONEWIRE_FIXED_JOIN(name, suffix)
+#define ONEWIRE_FIXED(suffix)               ONEWIRE_FIXED_SYMBOL(ONEWIRE_FIXED_NAME, suffix)
+
+
+// pull-up is switched off before the pin becomes an output, so the line
+// is never driven high
+static inline void ONEWIRE_FIXED(_hold)(void) {
+    ONEWIRE_FIXED_PORT &= ~_BV(ONEWIRE_FIXED_BIT);
+    ONEWIRE_FIXED_DDR |= _BV(ONEWIRE_FIXED_BIT);
+}
+
+
+static inline void ONEWIRE_FIXED(_release)(void) {
+    ONEWIRE_FIXED_DDR &= ~_BV(ONEWIRE_FIXED_BIT);
+    ONEWIRE_FIXED_PORT |= _BV(ONEWIRE_FIXED_BIT);
+}
+
+
+static inline uint8_t ONEWIRE_FIXED(_sample)(void) {
+    return (ONEWIRE_FIXED_PIN & _BV(ONEWIRE_FIXED_BIT)) ? 1 : 0;
+}
+
+
+static inline void ONEWIRE_FIXED(_delay)(uint16_t ticks) {
+    if (ticks) {
+        _delay_loop_2(ticks);
+    }
+}
+
+
+static bool ONEWIRE_FIXED(_reset)(onewire_bus_t *bus) {
+    bool status;
+    uint8_t timeout = 100;
+
+    // wait until the line is released by slaves, 2 us steps
+    while (!ONEWIRE_FIXED(_sample)()) {
+        if (--timeout == 0) {
+            return false;
+        }
+        _delay_loop_2(F_CPU / 2000000UL + 1);
+    }
+
+#ifdef ONEWIRE_SHORT_MASK
+    // standard reset pulses may be stretched, see onewire_maskedTime()
+    bool mask_low = bus->timing->reset_low < ONEWIRE_STRETCH_RESET_LOW;
+
+    ONEWIRE_FIXED(_delay)(bus->delay.reset_delay);
+    if (mask_low) {
+        cli();
+    }
+    ONEWIRE_FIXED(_hold)();
+    ONEWIRE_FIXED(_delay)(bus->delay.reset_low);
+    cli();
+    ONEWIRE_FIXED(_release)();
+    ONEWIRE_FIXED(_delay)(bus->delay.presence_sample);
+    status = !ONEWIRE_FIXED(_sample)();
+    sei();
+    ONEWIRE_FIXED(_delay)(bus->delay.reset_recovery);
+#else
+    cli();
+    ONEWIRE_FIXED(_delay)(bus->delay.reset_delay);
+    ONEWIRE_FIXED(_hold)();
+    ONEWIRE_FIXED(_delay)(bus->delay.reset_low);
+    ONEWIRE_FIXED(_release)();
+    ONEWIRE_FIXED(_delay)(bus->delay.presence_sample);
+    status = !ONEWIRE_FIXED(_sample)();
+    ONEWIRE_FIXED(_delay)(bus->delay.reset_recovery);
+    sei();
+#endif
+
+    return status;
+}
+
+
+//! \brief write-0 slot for bit 0, read slot (same as write-1) for bit 1
+//!
+static uint8_t ONEWIRE_FIXED(_touchBit)(onewire_bus_t *bus, uint8_t bit) {
+    uint8_t sample;
+
+    cli();
+    ONEWIRE_FIXED(_hold)();
+
+    if (!bit) {
+        ONEWIRE_FIXED(_delay)(bus->delay.write0_low);
+        ONEWIRE_FIXED(_release)();
+#ifdef ONEWIRE_SHORT_MASK
+        sei();
+        ONEWIRE_FIXED(_delay)(bus->delay.write0_recovery);
+#else
+        ONEWIRE_FIXED(_delay)(bus->delay.write0_recovery);
+        sei();
+#endif
+        return 0;
+    }
+
+    ONEWIRE_FIXED(_delay)(bus->delay.write1_low);
+    ONEWIRE_FIXED(_release)();
+    ONEWIRE_FIXED(_delay)(bus->delay.read_sample);
+    sample = ONEWIRE_FIXED(_sample)();
+#ifdef ONEWIRE_SHORT_MASK
+    sei();
+    ONEWIRE_FIXED(_delay)(bus->delay.read_recovery);
+#else
+    ONEWIRE_FIXED(_delay)(bus->delay.read_recovery);
+    sei();
+#endif
+
+    return sample;
+}
+
+
+static const onewire_driver_t ONEWIRE_FIXED(_driver) = {
+    .reset = ONEWIRE_FIXED(_reset),
+    .touchBit = ONEWIRE_FIXED(_touchBit),
+    .sendBuffer = NULL,
+    .receiveBuffer = NULL,
+};
+
+
+//! \brief initialize a bus on the fixed pin
+//! \param bus bus handle
+//!
+static inline void ONEWIRE_FIXED(_init)(onewire_bus_t *bus) {
+    avr_PortPin_t pin = {
+        &ONEWIRE_FIXED_DDR, &ONEWIRE_FIXED_PORT, &ONEWIRE_FIXED_PIN, ONEWIRE_FIXED_BIT
+    };
+
+    avr_onewire_init(bus, pin);
+    bus->driver = &ONEWIRE_FIXED(_driver);
+
+    ONEWIRE_FIXED(_release)();
+}
+
+
+#undef ONEWIRE_FIXED
+#undef ONEWIRE_FIXED_SYMBOL
+#undef ONEWIRE_FIXED_JOIN
+#undef ONEWIRE_FIXED_NAME
+#undef ONEWIRE_FIXED_DDR
+#undef ONEWIRE_FIXED_PORT
+#undef ONEWIRE_FIXED_PIN
+#undef ONEWIRE_FIXED_BIT
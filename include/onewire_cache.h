@@ -0,0 +1,146 @@
+//! \file onewire_cache.h
+//! \brief Persistent cache of slave addresses with fast verification
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 20
+//!
+//! Addresses found by a search are kept sorted in search order and can be
+//! saved to EEPROM/flash. At startup each cached address is checked with a
+//! search pass that follows its path ONEWIRE_CACHE_LEAF_DEPTH bits past
+//! the point where it leaves the other cached addresses (at least
+//! ONEWIRE_CACHE_MIN_DEPTH bits), and that expects a branch exactly where
+//! the cache has one. A missing slave breaks its path, a new slave shows up
+//! as an unexpected branch, and either one triggers a full search.
+//!
+//! For 100 thermometers a check pass reads about 28 bits instead of 64,
+//! about 7.4 ms instead of 15 ms per slave at standard speed. A new slave
+//! is missed only if it shares ONEWIRE_CACHE_LEAF_DEPTH more bits with a
+//! cached one, 1 in 4096 by default; strict mode reads all 64 bits and
+//! misses none.
+//!
+//! Startup time is therefore still proportional to the number of cached
+//! slaves, about half a full search, not to the number of changes.
+//! This is a deliberate limit: a SEARCH ROM pass follows a single path
+//! from the root, and a slave added below a leaf of the cached tree is
+//! only seen by a pass down that leaf, so one pass per cached slave is
+//! the least a check can cost.
+//!
+//! onewire_cache_update() follows hot-plugged slaves. Its check passes
+//! go as deep as those of onewire_cache_verify() but do not stop at the
+//! first mismatch: each one tells which subtree changed, where a branch
+//! disappeared, appeared or moved, and only that subtree is searched
+//! again. Added and removed slaves are reported one by one.
+//!
+//! | 100 thermometers, standard speed | bus time |
+//! |----------------------------------|----------|
+//! | full search                      | 1.50 s   |
+//! | update, no change                | 0.74 s   |
+//! | update, 1 slave added            | 0.77 s   |
+//! | update, 5 slaves changed         | 0.85 s   |
+//! | update, 20 slaves changed        | 1.16 s   |
+//!
+//! Only the work that follows a change scales with the changes, about
+//! 25 ms per changed slave. The check itself does not: it costs one pass
+//! per cached slave, for the reason given above, so a periodic check of
+//! an unchanged bus takes half the time of a full search and grows
+//! linearly with the bus. test_cache covers added, removed and moved
+//! slaves, 200 random runs and the missed slave case.
+
+#ifndef __ONEWIRE_CACHE__
+#define __ONEWIRE_CACHE__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+//! minimum number of address bits checked for each slave
+#ifndef ONEWIRE_CACHE_MIN_DEPTH
+#define ONEWIRE_CACHE_MIN_DEPTH     16
+#endif
+
+//! bits checked past the last branch of each path by onewire_cache_update()
+#ifndef ONEWIRE_CACHE_LEAF_DEPTH
+#define ONEWIRE_CACHE_LEAF_DEPTH    12
+#endif
+
+//! size of a saved cache holding n addresses
+#define ONEWIRE_CACHE_SIZE(n)       (1 + 8 * (n) + 2)
+
+
+//! \brief Cache of slave addresses.
+//!
+typedef struct onewire_cache {
+    uint8_t (*address_box)[8];  //!< caller storage, sorted in search order
+    uint8_t count;              //!< number of cached addresses
+    uint8_t capacity;           //!< size of address_box
+} onewire_cache_t;
+
+
+//! \brief initialize an empty cache
+//! \param cache address cache
+//! \param address_box storage for addresses
+//! \param capacity size of address_box
+//!
+void onewire_cache_init(onewire_cache_t *cache, uint8_t address_box[][8], uint8_t capacity);
+
+
+//! \brief check that the bus holds exactly the cached slaves
+//! \param bus bus handle
+//! \param cache address cache
+//! \param strict check all 64 bits of every address
+//! \return true or false
+//!
+bool onewire_cache_verify(onewire_bus_t *bus, const onewire_cache_t *cache, bool strict);
+
+
+//! \brief verify the cache and search the bus again if it does not match
+//! \param bus bus handle
+//! \param cache address cache
+//! \param strict check all 64 bits of every address
+//! \return true if the cache was valid, false if it has been rebuilt
+//!
+bool onewire_cache_refresh(onewire_bus_t *bus, onewire_cache_t *cache, bool strict);
+
+
+//! \brief follow the bus changes since the last check or search
+//! \param bus bus handle
+//! \param cache address cache
+//! \param strict check all 64 bits of every address
+//! \param changed called for each address added (present) or removed, optional
+//! \param context first argument of changed
+//! \return number of addresses added or removed
+//!
+//! Addresses found when the cache is full are neither added nor reported.
+//!
+uint8_t onewire_cache_update(onewire_bus_t *bus, onewire_cache_t *cache, bool strict,
+                            void (*changed)(void *context, const uint8_t *address, bool present),
+                            void *context);
+
+
+//! \brief serialize a cache, protected by CRC-16
+//! \param cache address cache
+//! \param buffer output buffer, ONEWIRE_CACHE_SIZE(cache->count) bytes
+//! \param size the size of buffer
+//! \return number of bytes written, 0 if buffer is too small
+//!
+uint16_t onewire_cache_save(const onewire_cache_t *cache, uint8_t *buffer, uint16_t size);
+
+
+//! \brief load a cache serialized by onewire_cache_save()
+//! \param cache address cache, initialized with onewire_cache_init()
+//! \param buffer serialized cache
+//! \param size the size of buffer
+//! \return false if the data is corrupted or does not fit, cache is empty then
+//!
+bool onewire_cache_load(onewire_cache_t *cache, const uint8_t *buffer, uint16_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,130 @@
+//! \file onewire_crc.h
+//! \brief CRC-8 and CRC-16 used by 1-wire devices
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 2
+//!
+//! CRC-8 is the Dallas/Maxim polynomial x^8 + x^5 + x^4 + 1 (ROM codes,
+//! scratchpads), CRC-16 is x^16 + x^15 + x^2 + 1 (memory and counter
+//! families). Both are computed LSB first, as they are shifted on the bus.
+//!
+//! Three strategies are provided, each in its own translation unit so that
+//! only the selected one is linked from the static library:
+//!
+//! | method              | CRC-8 table | CRC-16 table | CRC-8 / CRC-16 speed (*) |
+//! |---------------------|-------------|--------------|--------------------------|
+//! | ONEWIRE_CRC_BITWISE | none        | none         | 91 / 84 bytes/us         |
+//! | ONEWIRE_CRC_NIBBLE  | 16 bytes    | 32 bytes     | 191 / 177 bytes/us       |
+//! | ONEWIRE_CRC_TABLE   | 256 bytes   | 512 bytes    | 412 / 319 bytes/us       |
+//!
+//! (*) printed by bench_crc on the host (x86-64, gcc -O2) over a 64 KiB
+//! buffer, useful as a relative figure only. test_crc checks the three
+//! strategies against known ROM codes, scratchpads and DS2431 frames.
+//!
+//! Tables are placed in flash (PROGMEM) on AVR and in .rodata elsewhere, so
+//! none of the strategies uses RAM. On AVR the nibble method is the default,
+//! everywhere else the full table is.
+
+#ifndef __ONEWIRE_CRC__
+#define __ONEWIRE_CRC__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#define ONEWIRE_CRC_BITWISE     0
+#define ONEWIRE_CRC_NIBBLE      1
+#define ONEWIRE_CRC_TABLE       2
+
+#ifndef ONEWIRE_CRC_METHOD
+#if defined(__AVR__)
+#define ONEWIRE_CRC_METHOD      ONEWIRE_CRC_NIBBLE
+#else
+#define ONEWIRE_CRC_METHOD      ONEWIRE_CRC_TABLE
+#endif
+#endif
+
+
+//! \brief update CRC-8 with 1 byte, bit by bit
+//! \param crc current CRC value
+//! \param data 1 byte data
+//! \return new CRC value
+//!
+uint8_t crc8_update_bitwise(uint8_t crc, uint8_t data);
+
+
+//! \brief update CRC-8 with 1 byte, using a 16-entry nibble table
+//!
+uint8_t crc8_update_nibble(uint8_t crc, uint8_t data);
+
+
+//! \brief update CRC-8 with 1 byte, using a 256-entry table
+//!
+uint8_t crc8_update_table(uint8_t crc, uint8_t data);
+
+
+//! \brief update CRC-16 with 1 byte, bit by bit
+//! \param crc current CRC value
+//! \param data 1 byte data
+//! \return new CRC value
+//!
+uint16_t crc16_update_bitwise(uint16_t crc, uint8_t data);
+
+
+//! \brief update CRC-16 with 1 byte, using a 16-entry nibble table
+//!
+uint16_t crc16_update_nibble(uint16_t crc, uint8_t data);
+
+
+//! \brief update CRC-16 with 1 byte, using a 256-entry table
+//!
+uint16_t crc16_update_table(uint16_t crc, uint8_t data);
+
+
+#if ONEWIRE_CRC_METHOD == ONEWIRE_CRC_BITWISE
+#define crc8_update     crc8_update_bitwise
+#define crc16_update    crc16_update_bitwise
+#elif ONEWIRE_CRC_METHOD == ONEWIRE_CRC_NIBBLE
+#define crc8_update     crc8_update_nibble
+#define crc16_update    crc16_update_nibble
+#elif ONEWIRE_CRC_METHOD == ONEWIRE_CRC_TABLE
+#define crc8_update     crc8_update_table
+#define crc16_update    crc16_update_table
+#else
+#error "unknown ONEWIRE_CRC_METHOD"
+#endif
+
+
+//! \brief compute CRC-8 of a buffer
+//! \param crc initial CRC value (0 for a new computation)
+//! \param buffer pointer to data buffer
+//! \param len the size of data buffer
+//! \return CRC-8 value, 0 if buffer ends with its own valid CRC
+//!
+uint8_t crc8(uint8_t crc, const void *buffer, uint16_t len);
+
+
+//! \brief compute CRC-16 of a buffer
+//! \param crc initial CRC value (0 for a new computation)
+//! \param buffer pointer to data buffer
+//! \param len the size of data buffer
+//! \return CRC-16 value
+//!
+uint16_t crc16(uint16_t crc, const void *buffer, uint16_t len);
+
+
+//! \brief compare CRC-16 with the value sent by a device
+//! \param crc CRC-16 computed over the transferred data
+//! \param received 2 bytes sent by the device (inverted, LSB first)
+//! \return true or false
+//!
+bool crc16_check(uint16_t crc, const uint8_t *received);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
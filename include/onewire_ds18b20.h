@@ -0,0 +1,141 @@
+//! \file onewire_ds18b20.h
+//! \brief DS18B20 digital thermometer on 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 6
+//!
+//! Temperatures are fixed-point values in 1/16 degree Celsius, as stored in
+//! the scratchpad. Conversion polling requires externally powered devices.
+
+#ifndef __ONEWIRE_DS18B20__
+#define __ONEWIRE_DS18B20__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+#include "onewire_group.h"
+
+
+#define DS18B20_FAMILY_CODE         0x28
+
+#define DS18B20_CONVERT_T           0x44
+#define DS18B20_WRITE_SCRATCHPAD    0x4E
+#define DS18B20_READ_SCRATCHPAD     0xBE
+#define DS18B20_COPY_SCRATCHPAD     0x48
+
+#define DS18B20_RESOLUTION_9        0x1F
+#define DS18B20_RESOLUTION_10       0x3F
+#define DS18B20_RESOLUTION_11       0x5F
+#define DS18B20_RESOLUTION_12       0x7F
+
+#define DS18B20_SCRATCHPAD_SIZE     9
+
+//! temperature of a thermometer that could not be read
+#define DS18B20_NO_READING          INT16_MIN
+
+//! number of polling bytes (560 us each) before a conversion times out
+#define DS18B20_CONVERSION_TIMEOUT  1500
+
+
+//! \brief set alarm thresholds and resolution of a thermometer
+//! \param bus bus handle
+//! \param address slave's address, NULL for all slaves
+//! \param low alarm when temperature is below, in degree Celsius
+//! \param high alarm when temperature is above, in degree Celsius
+//! \param resolution DS18B20_RESOLUTION_xx
+//! \return true or false
+//!
+bool ds18b20_configure(onewire_bus_t *bus, const uint8_t *address,
+                        int8_t low, int8_t high, uint8_t resolution);
+
+
+//! \brief start temperature conversion on all thermometers
+//! \param bus bus handle
+//! \return true or false
+//!
+bool ds18b20_convertAll(onewire_bus_t *bus);
+
+
+//! \brief check whether the running conversion has finished
+//! \param bus bus handle
+//! \return true or false
+//!
+bool ds18b20_isConversionDone(onewire_bus_t *bus);
+
+
+//! \brief wait until the running conversion has finished
+//! \param bus bus handle
+//! \return false on timeout
+//!
+bool ds18b20_waitConversion(onewire_bus_t *bus);
+
+
+//! \brief read temperature of a thermometer
+//! \param bus bus handle
+//! \param address slave's address
+//! \param temperature temperature in 1/16 degree Celsius
+//! \return false if the slave is absent or the scratchpad is corrupted
+//!
+bool ds18b20_readTemperature(onewire_bus_t *bus, const uint8_t *address,
+                            int16_t *temperature);
+
+
+//! \brief read many thermometers with a single conversion
+//! \param bus bus handle
+//! \param address_box addresses of thermometers
+//! \param temperature array filled with temperatures, DS18B20_NO_READING
+//!                    for thermometers that could not be read
+//! \param number size of both arrays
+//! \param verify read the whole scratchpad and check its CRC, otherwise
+//!               only the 2 temperature bytes are read
+//! \return number of thermometers read
+//!
+//! Without verify, 0xFFFF is what an absent thermometer reads and is
+//! reported as DS18B20_NO_READING, so a genuine -0.0625 C is lost too.
+//!
+//! 200 thermometers at 12-bit with CRC, simulated by bench_ds18b20: 3.07 s, 153.7 s one at a time.
+//!
+uint8_t ds18b20_readAll(onewire_bus_t *bus, const uint8_t address_box[][8],
+                        int16_t *temperature, uint8_t number, bool verify);
+
+
+//! \brief poll cycle reading only out-of-range thermometers
+//! \param bus bus handle
+//! \param address_box array filled with addresses of alarming slaves
+//! \param temperature array filled with their temperatures
+//! \param number size of both arrays
+//! \return number of alarming slaves read
+//!
+//! One broadcast conversion is followed by an alarm search, so slaves
+//! within their thresholds cost no bus time besides the conversion.
+//!
+uint8_t ds18b20_monitor(onewire_bus_t *bus, uint8_t address_box[][8],
+                        int16_t *temperature, uint8_t number);
+
+
+
+//! \brief start temperature conversion on all buses of a group
+//! \param group bus group
+//! \return mask of buses where a slave answered
+//!
+uint8_t ds18b20_groupConvertAll(onewire_group_t *group);
+
+
+//! \brief read one thermometer on each bus of a group
+//! \param group bus group
+//! \param address slave's address for each pin, NULL for single-drop buses
+//! \param temperature temperature for each pin, in 1/16 degree Celsius
+//! \return mask of buses where the temperature was read correctly
+//!
+uint8_t ds18b20_groupReadTemperature(onewire_group_t *group, const uint8_t address[8][8],
+                                    int16_t temperature[8]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+//! \file onewire_ds2482.h
+//! \brief DS2482 I2C to 1-wire bridge as physical layer of a bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 15
+//!
+//! The bridge generates every slot itself, the CPU only queues commands
+//! over I2C and polls the status register until the bridge is idle. A
+//! search bit is one 1-Wire Triplet command (two read slots and the write
+//! of the chosen direction) instead of three slots timed by the CPU.
+//!
+//! DS2482-100 has one channel, DS2482-800 has eight; each channel is an
+//! independent bus with its own search state and timing profile. The
+//! channel is selected on the bridge before each operation, only when it
+//! changes. Overdrive speed follows the timing profile of the bus, as set
+//! by onewire_overdriveSkip() and onewire_standardSpeed().
+//!
+//! I2C transactions per operation, polling excluded:
+//!
+//! | operation      | write | read |
+//! |----------------|-------|------|
+//! | reset          | 1     | 1    |
+//! | send byte      | 1     | 1    |
+//! | receive byte   | 2     | 2    |
+//! | search bit     | 1     | 1    |
+
+#ifndef __ONEWIRE_DS2482__
+#define __ONEWIRE_DS2482__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+//! 7-bit I2C address of a bridge with AD0..AD2 low
+#define DS2482_ADDRESS              0x18
+
+#define DS2482_100_CHANNELS         1
+#define DS2482_800_CHANNELS         8
+
+//! status register reads before an operation is given up
+#ifndef DS2482_POLL_LIMIT
+#define DS2482_POLL_LIMIT           200
+#endif
+
+// commands
+#define DS2482_DEVICE_RESET         0xF0
+#define DS2482_SET_POINTER          0xE1
+#define DS2482_WRITE_CONFIG         0xD2
+#define DS2482_CHANNEL_SELECT       0xC3
+#define DS2482_1WIRE_RESET          0xB4
+#define DS2482_1WIRE_BIT            0x87
+#define DS2482_1WIRE_WRITE          0xA5
+#define DS2482_1WIRE_READ           0x96
+#define DS2482_1WIRE_TRIPLET        0x78
+
+// register pointer codes
+#define DS2482_STATUS_REGISTER      0xF0
+#define DS2482_DATA_REGISTER        0xE1
+#define DS2482_CONFIG_REGISTER      0xC3
+#define DS2482_CHANNEL_REGISTER     0xD2
+
+// status register
+#define DS2482_STATUS_1WB           0x01    //!< 1-wire busy
+#define DS2482_STATUS_PPD           0x02    //!< presence pulse detected
+#define DS2482_STATUS_SD            0x04    //!< short detected
+#define DS2482_STATUS_LL            0x08    //!< logic level of the line
+#define DS2482_STATUS_RST           0x10    //!< device reset since last config write
+#define DS2482_STATUS_SBR           0x20    //!< single bit result
+#define DS2482_STATUS_TSB           0x40    //!< triplet second bit
+#define DS2482_STATUS_DIR           0x80    //!< branch direction taken
+
+// configuration register
+#define DS2482_CONFIG_APU           0x01    //!< active pull-up
+#define DS2482_CONFIG_SPU           0x04    //!< strong pull-up
+#define DS2482_CONFIG_1WS           0x08    //!< overdrive speed
+
+
+//! \brief I2C master used to reach the bridge.
+//!
+typedef struct onewire_i2c_port {
+    //! write len bytes to a 7-bit address, false if not acknowledged
+    bool (*write)(void *context, uint8_t address, const uint8_t *data, uint8_t len);
+
+    //! read len bytes from a 7-bit address, false if not acknowledged
+    bool (*read)(void *context, uint8_t address, uint8_t *data, uint8_t len);
+
+    //! wait ms milliseconds, the bridge keeps the line released meanwhile
+    void (*delay)(void *context, uint16_t ms);
+
+    void *context;
+} onewire_i2c_port_t;
+
+
+struct onewire_ds2482;
+
+//! \brief Channel of a bridge, context of the bus driven through it.
+//!
+typedef struct onewire_ds2482_channel {
+    struct onewire_ds2482 *bridge;      //!< bridge of the channel
+    uint8_t index;                      //!< channel number, 0 to 7
+} onewire_ds2482_channel_t;
+
+
+//! \brief DS2482-100 or DS2482-800 bridge.
+//!
+typedef struct onewire_ds2482 {
+    const onewire_i2c_port_t *port;     //!< I2C master
+    uint8_t address;                    //!< 7-bit I2C address
+    uint8_t channels;                   //!< 1 or 8
+    uint8_t channel;                    //!< selected channel
+    uint8_t config;                     //!< configuration register
+    onewire_ds2482_channel_t channel_list[DS2482_800_CHANNELS];
+} onewire_ds2482_t;
+
+
+//! \brief Tiva C I2C master.
+//!
+//! I2C peripheral and pin muxing must be set up by the application.
+//!
+typedef struct tiva_i2c {
+    uint32_t base;                      //!< I2C base address
+    onewire_i2c_port_t port;            //!< filled by tiva_onewire_i2cInit()
+} tiva_i2c_t;
+
+
+//! \brief reset a bridge and enable its active pull-up
+//! \param bridge bridge handle
+//! \param port I2C master, must stay valid while the bridge is used
+//! \param address 7-bit I2C address, DS2482_ADDRESS + AD2..AD0
+//! \param channels DS2482_100_CHANNELS or DS2482_800_CHANNELS
+//! \return true if the bridge answered
+//!
+bool onewire_ds2482_init(onewire_ds2482_t *bridge, const onewire_i2c_port_t *port,
+                        uint8_t address, uint8_t channels);
+
+
+//! \brief use a channel of a bridge as physical layer of a bus
+//! \param bus bus handle
+//! \param bridge bridge initialized with onewire_ds2482_init()
+//! \param channel channel number, below the number of channels
+//!
+void onewire_ds2482_busInit(onewire_bus_t *bus, onewire_ds2482_t *bridge, uint8_t channel);
+
+
+//! \brief initialize the I2C port of a Tiva C I2C master
+//! \param i2c I2C description, pass &i2c->port to onewire_ds2482_init()
+//!
+void tiva_onewire_i2cInit(tiva_i2c_t *i2c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,121 @@
+//! \file onewire_group.h
+//! \brief Up to 8 1-wire buses on one GPIO port driven in lockstep
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 13
+//!
+//! Every slot is generated on all buses of the group with port-wide mask
+//! writes and sampled with a single port read, so N buses cost the CPU the
+//! same as one. Per-bus data is bit-sliced: bit k of a port sample belongs
+//! to the bus on pin k. Buffers holding per-bus data are indexed by pin
+//! number (0..7), entries of pins outside the group are ignored.
+
+#ifndef __ONEWIRE_GROUP__
+#define __ONEWIRE_GROUP__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+//! \brief Group of buses on one GPIO port.
+//!
+typedef struct onewire_group {
+    onewire_port_t port;                //!< GPIO port
+    uint8_t mask;                       //!< pins of the group
+    const onewire_timing_t *timing;     //!< selected timing profile
+    onewire_timing_t delay;             //!< profile in platform delay units
+#ifdef ONEWIRE_STATS
+    onewire_stats_t stats;              //!< resets, presence failures, line timeouts
+#endif
+} onewire_group_t;
+
+
+//! \brief initialize a group of buses on an AVR port
+//! \param group bus group
+//! \param port GPIO port, pin field unused
+//! \param mask pins of the group
+//!
+void avr_onewire_groupInit(onewire_group_t *group, avr_PortPin_t port, uint8_t mask);
+
+
+//! \brief initialize a group of buses on a Tiva C port
+//! \param group bus group
+//! \param port GPIO port, pin field unused
+//! \param mask pins of the group, e.g. GPIO_PIN_0 | GPIO_PIN_1
+//!
+void tiva_onewire_groupInit(onewire_group_t *group, tiva_PortPin_t port, uint8_t mask);
+
+
+//! \brief select slot timing profile of a group
+//! \param group bus group
+//! \param timing timing profile, must stay valid while the group is used
+//!
+//! Write-1 and write-0 slots share their falling edge, a write-0 low time
+//! shorter than the write-1 one is extended to it.
+//!
+void onewire_group_setTiming(onewire_group_t *group, const onewire_timing_t *timing);
+
+
+//! \brief reset all buses of a group
+//! \param group bus group
+//! \return mask of buses where a slave answered
+//!
+//! Lines still held low after the release timeout are left out of the
+//! mask, as onewire_reset() fails on them.
+//!
+uint8_t onewire_group_reset(onewire_group_t *group);
+
+
+//! \brief select all slaves on all buses
+//! \param group bus group
+//! \return mask of buses where a slave answered
+//!
+uint8_t onewire_group_selectAll(onewire_group_t *group);
+
+
+//! \brief select one slave on each bus
+//! \param group bus group
+//! \param address slave's address for each pin
+//! \return mask of buses where a slave answered
+//!
+uint8_t onewire_group_select(onewire_group_t *group, const uint8_t address[8][8]);
+
+
+//! \brief send the same byte on all buses
+//! \param group bus group
+//! \param data 1 byte data
+//!
+void onewire_group_send(onewire_group_t *group, uint8_t data);
+
+
+//! \brief send one byte per bus
+//! \param group bus group
+//! \param data 1 byte data for each pin
+//!
+void onewire_group_sendEach(onewire_group_t *group, const uint8_t data[8]);
+
+
+//! \brief receive one byte per bus
+//! \param group bus group
+//! \param data 1 byte data for each pin
+//!
+void onewire_group_receive(onewire_group_t *group, uint8_t data[8]);
+
+
+//! \brief receive a buffer from every bus
+//! \param group bus group
+//! \param buffer 8 * len bytes, data of pin k starts at buffer + k * len
+//! \param len the size of data received on each bus
+//!
+void onewire_group_receiveBuffer(onewire_group_t *group, void *buffer, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
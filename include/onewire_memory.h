@@ -0,0 +1,130 @@
+//! \file onewire_memory.h
+//! \brief EEPROM memory devices on 1-wire bus: DS2431, DS2433, DS28EC20
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 25
+//!
+//! Reads run as one Read Memory command over any length, handed to a sink
+//! callback one page at a time, so no buffer holds the whole image. Models
+//! with Extended Read Memory (DS28EC20) check the CRC-16 sent after each
+//! page and restart at the failed page; plain Read Memory has no CRC.
+//!
+//! Writes go page by page: Write Scratchpad of the whole page, checked
+//! with the CRC-16 the device sends at the end of the scratchpad, then
+//! Copy Scratchpad with the authorization pattern known from that write.
+//! The Read Scratchpad round trip is not needed, and models supporting it
+//! address the device with RESUME after the first MATCH ROM. A partial
+//! page is read first and merged. The line then stays idle for the
+//! programming time of the model, with the strong pull-up of the bus for
+//! models that need one, before one byte of the 0xAA/0x55 pattern
+//! confirms the copy.
+//!
+//! Simulated DS2431, whole memory addressed by MATCH ROM, bytes per second:
+//!
+//! | speed     | read  | write | Write, Read and Copy Scratchpad, MATCH ROM each |
+//! |-----------|-------|-------|-------------------------------------------------|
+//! | standard  | 1613  | 342   | 174                                             |
+//! | overdrive | 12496 | 680   | 543                                             |
+//!
+//! A read costs one addressing and its command, then runs at the bit rate
+//! (1786 B/s at standard speed). A page write takes 10 ms of programming
+//! and 13 ms of slots at standard speed, 1.8 ms at overdrive.
+
+#ifndef __ONEWIRE_MEMORY__
+#define __ONEWIRE_MEMORY__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+#define DS2431_FAMILY_CODE                  0x2D
+#define DS2433_FAMILY_CODE                  0x23
+#define DS28EC20_FAMILY_CODE                0x43
+
+#define ONEWIRE_MEMORY_WRITE_SCRATCHPAD     0x0F
+#define ONEWIRE_MEMORY_READ_SCRATCHPAD      0xAA
+#define ONEWIRE_MEMORY_COPY_SCRATCHPAD      0x55
+#define ONEWIRE_MEMORY_READ                 0xF0
+#define ONEWIRE_MEMORY_EXTENDED_READ        0xA5
+
+//! largest scratchpad of the supported models
+#define ONEWIRE_MEMORY_PAGE_MAX             32
+
+//! repeats of a page after an error
+#ifndef ONEWIRE_MEMORY_RETRIES
+#define ONEWIRE_MEMORY_RETRIES              2
+#endif
+
+
+//! \brief Memory organization of a device model.
+//!
+typedef struct onewire_memory {
+    uint16_t size;              //!< data memory, bytes
+    uint8_t page;               //!< scratchpad size, bytes
+    uint8_t extended;           //!< read command with CRC-16 per page, 0 if none
+    bool resume;                //!< RESUME supported
+    uint8_t program;            //!< programming time of a page, ms
+    bool strong;                //!< strong pull-up needed while programming
+} onewire_memory_t;
+
+extern const onewire_memory_t onewire_memory_ds2431;
+extern const onewire_memory_t onewire_memory_ds2433;
+extern const onewire_memory_t onewire_memory_ds28ec20;
+
+
+//! \brief read memory into a sink, one page at a time
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param model memory organization
+//! \param offset first byte
+//! \param len number of bytes
+//! \param sink receives the data, returns false to stop the read
+//! \param context first argument of sink
+//! \return ONEWIRE_OK or the error of the last attempt
+//!
+uint8_t onewire_memory_read(onewire_bus_t *bus, const uint8_t *address,
+                            const onewire_memory_t *model, uint16_t offset, uint16_t len,
+                            bool (*sink)(void *context, uint16_t offset,
+                                        const uint8_t *data, uint8_t len),
+                            void *context);
+
+
+//! \brief read memory into a buffer
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param model memory organization
+//! \param offset first byte
+//! \param buffer receive buffer
+//! \param len the size of buffer
+//! \return ONEWIRE_OK or the error of the last attempt
+//!
+uint8_t onewire_memory_readBuffer(onewire_bus_t *bus, const uint8_t *address,
+                                const onewire_memory_t *model, uint16_t offset,
+                                void *buffer, uint16_t len);
+
+
+//! \brief write memory, page by page
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param model memory organization
+//! \param offset first byte
+//! \param buffer data to write
+//! \param len the size of buffer
+//! \return ONEWIRE_OK or the error of the last attempt on the failed page
+//!
+//! Pages before the failed one are written.
+//!
+uint8_t onewire_memory_write(onewire_bus_t *bus, const uint8_t *address,
+                            const onewire_memory_t *model, uint16_t offset,
+                            const void *buffer, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
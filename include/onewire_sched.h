@@ -0,0 +1,138 @@
+//! \file onewire_sched.h
+//! \brief Deadline-driven polling of many slaves across buses
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 18
+//!
+//! A task samples one slave periodically: it starts a conversion at its
+//! release time, reads the result once the conversion time has passed and
+//! must be done before the next release. While a conversion runs, the bus
+//! serves reads and conversions of other tasks.
+//!
+//! onewire_sched_run() does one bus operation per call, the one with the
+//! earliest deadline, so the main loop keeps control between them:
+//!
+//!     for (;;) {
+//!         uint32_t idle = onewire_sched_run(&sched);
+//!         // other work or sleep for up to idle ms
+//!     }
+//!
+//! On a bus where all tasks share the same convert command, conversions
+//! are started by SKIP ROM broadcasts, each one starting every task of the
+//! bus whose release falls within the batching window. A broadcast waits
+//! for the running conversions of its bus; results not read yet stay
+//! readable during the next conversion, as with DS18B20, and are read
+//! meanwhile.
+//! Other slaves of the bus see the command too. A window at least as long
+//! as the conversion time keeps every task in one batch per period.
+//!
+//! Samples keep the phase of their first release, a late one does not
+//! delay the next ones; samples whose whole period has passed are skipped.
+//!
+//! Times are in milliseconds from the clock given to onewire_sched_init(),
+//! compared modulo 2^32. Periods must stay below 2^31 ms.
+
+#ifndef __ONEWIRE_SCHED__
+#define __ONEWIRE_SCHED__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+//! \brief Periodic sampling of one slave.
+//!
+//! Fields up to arg are set by the application before onewire_sched_add().
+//!
+typedef struct onewire_sched_task {
+    onewire_bus_t *bus;                 //!< bus of the slave
+    const uint8_t *address;             //!< slave's address
+    uint8_t convert;                    //!< command starting a conversion, 0 if none
+    uint8_t read;                       //!< command reading the result
+    uint8_t len;                        //!< bytes read, including CRC
+    uint8_t check;                      //!< ONEWIRE_CHECK_xx of the result
+    uint8_t *data;                      //!< result buffer of len bytes
+    uint32_t period;                    //!< sampling period, ms
+    uint16_t conversion;                //!< conversion time, ms
+
+    //! called after each read with its onewire_transfer() status, optional
+    void (*done)(struct onewire_sched_task *task, uint8_t status);
+    void *arg;                          //!< application data
+
+    struct onewire_sched_task *next;    //!< scheduler list
+    uint32_t release;                   //!< time the next sample is due
+    uint32_t deadline;                  //!< end of the sample in progress
+    uint32_t ready;                     //!< end of the running conversion
+    uint32_t previous;                  //!< end of the sample of a pending result
+    bool converting;                    //!< a conversion is running or not read
+    bool pending;                       //!< previous result not read yet
+    uint16_t missed;                    //!< samples late or skipped
+    uint16_t jitter;                    //!< worst conversion start delay, ms
+} onewire_sched_task_t;
+
+
+//! \brief Counters of a scheduler.
+//!
+typedef struct onewire_sched_stats {
+    uint32_t conversions;               //!< conversions started
+    uint32_t broadcasts;                //!< broadcasts starting them
+    uint32_t reads;                     //!< results read
+    uint32_t failures;                  //!< reads or conversions that failed
+    uint32_t missed;                    //!< samples late or skipped
+    uint32_t jitter_sum;                //!< sum of conversion start delays, ms
+    uint16_t jitter_max;                //!< worst conversion start delay, ms
+} onewire_sched_stats_t;
+
+
+//! \brief Polling scheduler.
+//!
+typedef struct onewire_sched {
+    onewire_sched_task_t *tasks;        //!< list of tasks
+    uint32_t (*clock)(void *context);   //!< current time, ms
+    void *context;                      //!< argument of clock
+    uint16_t window;                    //!< batching window, ms
+    uint8_t retries;                    //!< retries of a failed read
+    onewire_sched_stats_t stats;        //!< counters
+} onewire_sched_t;
+
+
+//! \brief initialize a scheduler without tasks
+//! \param sched scheduler
+//! \param clock returns the current time in milliseconds
+//! \param context argument of clock
+//! \param window a broadcast also starts conversions due within window ms
+//!
+void onewire_sched_init(onewire_sched_t *sched, uint32_t (*clock)(void *context),
+                        void *context, uint16_t window);
+
+
+//! \brief add a task
+//! \param sched scheduler
+//! \param task task with its application fields set
+//! \param start time of the first sample
+//!
+void onewire_sched_add(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t start);
+
+
+//! \brief remove a task
+//! \param sched scheduler
+//! \param task task added to the scheduler
+//!
+void onewire_sched_remove(onewire_sched_t *sched, onewire_sched_task_t *task);
+
+
+//! \brief run the bus operation with the earliest deadline
+//! \param sched scheduler
+//! \return 0 if an operation was run, otherwise time until the next one, ms
+//!
+uint32_t onewire_sched_run(onewire_sched_t *sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
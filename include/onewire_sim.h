@@ -0,0 +1,458 @@
+//! \file onewire_sim.h
+//! \brief Host-side model of a 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 16
+//!
+//! The line is a wired-AND in virtual time: it is low while the master or
+//! any slave pulls it low. The host physical layer advances virtual time
+//! instead of busy-waiting, so whole transactions run in a few microseconds
+//! of real time. The UART port pushes every UART frame bit by bit through
+//! the same line, which makes it a loopback when no slave is attached.
+//!
+//! Slaves are virtual devices attached to a line. They decode the master's
+//! edges like real slaves do: a long low pulse is a reset answered by a
+//! presence pulse, a short one is a write-1 or read slot, a longer one a
+//! write-0 slot. Presence pulses last 60 us from 30 us after the release,
+//! the shortest a real slave sends; at overdrive a reset pulse longer than
+//! 80 us is taken for a standard-speed one. A slave sending a 0 holds the
+//! line low after the falling edge of the slot. The ROM layer (search,
+//! alarm search, match, skip, read ROM, resume, overdrive) is shared,
+//! function commands are handled by a device model. Models for DS18B20,
+//! DS2431 and DS2413 are provided; thousands of devices can be attached to
+//! one line, only the slaves still taking part in a transaction are visited
+//! on each slot.
+
+#ifndef __ONEWIRE_SIM__
+#define __ONEWIRE_SIM__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "onewire.h"
+#include "onewire_uart.h"
+#include "onewire_ds2482.h"
+#include "onewire_async.h"
+#include "onewire_group.h"
+
+
+struct onewire_sim_device;
+
+
+//! \brief Behaviour of a virtual device beyond the ROM layer.
+//!
+//! Every callback is optional. In function mode the device sends while
+//! its reading flag is set: bits queued with onewire_sim_reply() first,
+//! then refill() is called to queue more. If nothing is queued the slave
+//! leaves the line high, or takes the slot as a write if refill() cleared
+//! the reading flag.
+//!
+typedef struct onewire_sim_model {
+    bool overdrive;             //!< answers OVERDRIVE_SKIP and OVERDRIVE_MATCH
+    bool resume;                //!< answers RESUME
+    void (*reset)(struct onewire_sim_device *device, uint64_t now);
+    void (*command)(struct onewire_sim_device *device, uint8_t command, uint64_t now);
+    void (*receive)(struct onewire_sim_device *device, uint8_t data, uint64_t now);
+    void (*refill)(struct onewire_sim_device *device, uint64_t now);
+    bool (*alarm)(const struct onewire_sim_device *device);
+} onewire_sim_model_t;
+
+
+//! \brief Virtual slave, embedded as first member of a device model.
+//!
+typedef struct onewire_sim_device {
+    uint8_t ROM[8];                     //!< 64-bit address
+    const onewire_sim_model_t *model;   //!< device model
+    struct onewire_sim_device *next;    //!< next device on the line
+    struct onewire_sim_device *next_active; //!< next device taking part
+    uint8_t state;                      //!< ROM layer state
+    uint8_t bit_index;                  //!< bit of the ROM or of the byte
+    uint8_t shift;                      //!< bits received so far
+    bool overdrive;                     //!< runs at overdrive speed
+    bool resume;                        //!< selected by the last MATCH or search
+    bool reading;                       //!< function layer sends data
+    uint8_t reply[16];                  //!< bits queued for read slots
+    uint8_t reply_bits;                 //!< number of queued bits
+    uint8_t reply_index;                //!< next queued bit to send
+} onewire_sim_device_t;
+
+
+//! \brief Bus time spent on a simulated line.
+//!
+//! Slots are classified as a slave sees them, a short slot in which the
+//! master samples the line counts as a read slot.
+//!
+typedef struct onewire_sim_counter {
+    uint32_t resets;            //!< reset pulses
+    uint32_t write0;            //!< write-0 slots
+    uint32_t write1;            //!< write-1 slots
+    uint32_t read;              //!< read slots
+    uint32_t slot_low_max;      //!< longest low time of a slot, ns
+    uint64_t time;              //!< virtual time in nanoseconds
+} onewire_sim_counter_t;
+
+
+//! \brief Simulated 1-wire line.
+//!
+typedef struct onewire_sim {
+    uint64_t now;               //!< virtual time in nanoseconds
+    bool master_low;            //!< master pulls the line low
+    uint64_t fall;              //!< time of the last falling edge of master
+    uint64_t slave_low;         //!< slaves pull the line low from this time
+    uint64_t slave_release;     //!< ... until this time
+    onewire_sim_device_t *devices;  //!< all attached devices
+    onewire_sim_device_t *active;   //!< devices taking part in a transaction
+    uint16_t overdrive_count;   //!< number of devices at overdrive speed
+    bool short_slot;            //!< the current slot is a write-1 so far
+    uint64_t counter_start;     //!< time of the last onewire_sim_clearCounters()
+    onewire_sim_counter_t counter;  //!< bus time accounting
+} onewire_sim_t;
+
+
+//! \brief Virtual DS18B20 thermometer, externally powered.
+//!
+typedef struct onewire_sim_ds18b20 {
+    onewire_sim_device_t device;
+    int16_t temperature;        //!< measured temperature, 1/16 degree Celsius
+    uint8_t scratchpad[9];      //!< scratchpad, temperature 85 C at power-up
+    uint8_t eeprom[3];          //!< TH, TL, configuration
+    uint64_t ready;             //!< end of the running conversion
+    bool converting;            //!< a conversion is running
+    bool alarm;                 //!< alarm flag of the last conversion
+    uint8_t index;              //!< byte index of WRITE SCRATCHPAD
+} onewire_sim_ds18b20_t;
+
+
+//! \brief Virtual DS2431 1024-bit EEPROM.
+//!
+//! Memory protection and the copy authorization flags are kept but
+//! not enforced.
+//!
+typedef struct onewire_sim_ds2431 {
+    onewire_sim_device_t device;
+    uint8_t memory[144];        //!< 128 data bytes and 16 register bytes
+    uint8_t scratchpad[8];      //!< 8-byte scratchpad
+    uint8_t command;            //!< running function command
+    uint16_t address;           //!< target address TA2:TA1
+    uint8_t status;             //!< E/S byte
+    uint8_t index;              //!< byte index of the running command
+    uint8_t args[3];            //!< received TA1, TA2, E/S
+    uint16_t crc;               //!< CRC-16 of the running command
+    uint64_t ready;             //!< end of the running copy
+} onewire_sim_ds2431_t;
+
+
+//! \brief Virtual DS2413 dual-channel addressable switch.
+//!
+typedef struct onewire_sim_ds2413 {
+    onewire_sim_device_t device;
+    uint8_t latch;              //!< output latches, bit 0 PIOA, bit 1 PIOB
+    uint8_t input;              //!< external level of the pins
+    uint8_t command;            //!< running function command
+    uint8_t data;               //!< first byte of PIO ACCESS WRITE
+    uint8_t index;              //!< byte index of PIO ACCESS WRITE
+} onewire_sim_ds2413_t;
+
+
+//! serial number distributions of onewire_sim_serial()
+#define ONEWIRE_SIM_SEQUENTIAL      0
+#define ONEWIRE_SIM_RANDOM          1
+#define ONEWIRE_SIM_PREFIX          2
+
+//! output formats of onewire_sim_benchmark()
+#define ONEWIRE_SIM_CSV             0
+#define ONEWIRE_SIM_JSON            1
+
+#define DS2431_FAMILY_CODE          0x2D
+#define DS2413_FAMILY_CODE          0x3A
+
+
+//! \brief Simulated UART whose TX and RX are tied to a simulated line.
+//!
+typedef struct onewire_sim_uart {
+    onewire_sim_t *sim;         //!< line the UART is wired to
+    uint32_t baudrate;          //!< current baudrate
+    onewire_uart_port_t port;   //!< filled by onewire_sim_uartInit()
+    void (*complete)(void *arg);    //!< pending end of a started transfer
+    void *complete_arg;         //!< argument of complete
+} onewire_sim_uart_t;
+
+
+//! \brief Simulated DS2482 bridge, each channel wired to a simulated line.
+//!
+//! 1-wire operations run on the line at once with the slot timing of the
+//! speed selected in the configuration register, so the bridge is never
+//! busy when polled.
+//!
+typedef struct onewire_sim_ds2482 {
+    onewire_sim_t *lines[DS2482_800_CHANNELS];  //!< line of each channel, NULL if none
+    uint8_t address;            //!< 7-bit I2C address
+    uint8_t channels;           //!< 1 or 8
+    uint8_t channel;            //!< selected channel
+    uint8_t pointer;            //!< register read by the next I2C read
+    uint8_t status;             //!< status register
+    uint8_t data;               //!< read data register
+    uint8_t config;             //!< configuration register
+    uint32_t transactions;      //!< I2C transactions addressed to the bridge
+    onewire_i2c_port_t port;    //!< filled by onewire_sim_ds2482Init()
+} onewire_sim_ds2482_t;
+
+
+//! \brief Simulated one-shot timer running in the virtual time of a line.
+//!
+typedef struct onewire_sim_timer {
+    onewire_sim_t *sim;         //!< line whose virtual time is used
+    bool armed;                 //!< an interrupt is pending
+    uint64_t deadline;          //!< virtual time of the pending interrupt
+    void (*isr)(void *arg);     //!< interrupt handler
+    void *arg;                  //!< argument of the interrupt handler
+    onewire_timer_port_t port;  //!< filled by onewire_sim_timerInit()
+} onewire_sim_timer_t;
+
+
+//! \brief initialize a simulated line, released at time 0
+//! \param sim simulated line
+//!
+void onewire_sim_init(onewire_sim_t *sim);
+
+
+//! \brief drive the line from the master side
+//! \param sim simulated line
+//! \param low true to pull the line low, false to release it
+//!
+void onewire_sim_drive(onewire_sim_t *sim, bool low);
+
+
+//! \brief let virtual time pass
+//! \param sim simulated line
+//! \param ns duration in nanoseconds
+//!
+void onewire_sim_advance(onewire_sim_t *sim, uint32_t ns);
+
+
+//! \brief sample the line at current virtual time
+//! \param sim simulated line
+//! \return 1 if the line is high, 0 if low
+//!
+uint8_t onewire_sim_sample(onewire_sim_t *sim);
+
+
+//! \brief start bus time accounting over
+//! \param sim simulated line
+//!
+void onewire_sim_clearCounters(onewire_sim_t *sim);
+
+
+//! \brief read bus time spent since the last onewire_sim_clearCounters()
+//! \param sim simulated line
+//! \param counter output counters
+//!
+void onewire_sim_getCounters(const onewire_sim_t *sim, onewire_sim_counter_t *counter);
+
+
+//! \brief write counters as one CSV line
+//! \param file output stream
+//! \param label first column, e.g. scenario and API call
+//! \param counter counters
+//!
+//! Columns are label, resets, write0, write1, read, us.
+//!
+void onewire_sim_printCsv(FILE *file, const char *label, const onewire_sim_counter_t *counter);
+
+
+//! \brief write counters as one JSON object, without separator
+//! \param file output stream
+//! \param label value of the "label" member
+//! \param counter counters
+//!
+void onewire_sim_printJson(FILE *file, const char *label, const onewire_sim_counter_t *counter);
+
+
+//! \brief make a serial number for a scenario
+//! \param distribution ONEWIRE_SIM_SEQUENTIAL, ONEWIRE_SIM_RANDOM or ONEWIRE_SIM_PREFIX
+//! \param index device index
+//! \return 48-bit serial number
+//!
+//! Sequential serials differ in their first bits, random ones are a fixed
+//! pseudo-random sequence, prefix serials share their first 40 bits so
+//! that searches branch only near the end of the address.
+//!
+uint64_t onewire_sim_serial(uint8_t distribution, uint32_t index);
+
+
+//! \brief measure bus time of the core API on simulated DS18B20 lines
+//! \param file output stream
+//! \param format ONEWIRE_SIM_CSV or ONEWIRE_SIM_JSON
+//! \param counts device counts to sweep, each at most 255
+//! \param len number of device counts
+//! \return false if a search did not find every device
+//!
+//! For each distribution and device count, one row is written for
+//! onewire_search, onewire_select, onewire_sendBuffer (9 bytes) and
+//! onewire_receiveBuffer (9 bytes). Virtual time is deterministic, so
+//! rows can be compared with a stored baseline to catch regressions:
+//! the bench_sweep test does so with bench/bench_sweep.csv.
+//!
+bool onewire_sim_benchmark(FILE *file, uint8_t format, const uint16_t *counts, uint8_t len);
+
+
+//! \brief measure bus utilisation and jitter of the polling scheduler
+//! \param file output stream
+//! \param format ONEWIRE_SIM_CSV or ONEWIRE_SIM_JSON
+//! \param sensors number of simulated DS18B20
+//! \param lines number of buses, at most 8
+//! \param duration simulated time, ms
+//! \param window batching window of the scheduler, ms
+//! \return false if memory could not be allocated
+//!
+//! Sensors are spread over the lines with periods of 1, 2, 5 and 10 s and
+//! a 750 ms conversion time, one scheduler serves all lines. One row is
+//! written per line and one for all of them, with columns line, sensors,
+//! reads, failures, missed, jitter_max_ms and utilisation: nominal bus
+//! time of resets and slots over elapsed time, in percent. The sched test
+//! checks misses and bus time of these rows.
+//!
+bool onewire_sim_benchmarkScheduler(FILE *file, uint8_t format, uint16_t sensors,
+                                    uint8_t lines, uint32_t duration, uint16_t window);
+
+
+//! \brief attach a virtual device to a line
+//! \param sim simulated line
+//! \param device initialized virtual device, not attached to another line
+//!
+//! The device joins at the next reset.
+//!
+void onewire_sim_attach(onewire_sim_t *sim, onewire_sim_device_t *device);
+
+
+//! \brief detach a virtual device from a line
+//! \param sim simulated line
+//! \param device attached virtual device
+//!
+void onewire_sim_detach(onewire_sim_t *sim, onewire_sim_device_t *device);
+
+
+//! \brief initialize the ROM layer of a virtual device
+//! \param device virtual device
+//! \param model device model
+//! \param family family code
+//! \param serial 48-bit serial number
+//!
+//! The CRC byte of the address is computed.
+//!
+void onewire_sim_deviceInit(onewire_sim_device_t *device, const onewire_sim_model_t *model,
+                            uint8_t family, uint64_t serial);
+
+
+//! \brief queue bits sent by a device in the next read slots
+//! \param device virtual device
+//! \param data bits, LSB first
+//! \param bits number of bits, at most 128
+//!
+//! Sets the reading flag of the device.
+//!
+void onewire_sim_reply(onewire_sim_device_t *device, const uint8_t *data, uint8_t bits);
+
+
+//! \brief initialize a virtual DS18B20
+//! \param ds18b20 virtual thermometer
+//! \param serial 48-bit serial number
+//!
+void onewire_sim_ds18b20Init(onewire_sim_ds18b20_t *ds18b20, uint64_t serial);
+
+
+//! \brief initialize a virtual DS2431, memory erased to 0xFF
+//! \param ds2431 virtual EEPROM
+//! \param serial 48-bit serial number
+//!
+void onewire_sim_ds2431Init(onewire_sim_ds2431_t *ds2431, uint64_t serial);
+
+
+//! \brief initialize a virtual DS2413, latches off and pins pulled up
+//! \param ds2413 virtual switch
+//! \param serial 48-bit serial number
+//!
+void onewire_sim_ds2413Init(onewire_sim_ds2413_t *ds2413, uint64_t serial);
+
+
+//! \brief bit-bang a bus on a simulated line
+//! \param bus bus handle
+//! \param sim simulated line
+//!
+void host_onewire_init(onewire_bus_t *bus, onewire_sim_t *sim);
+
+
+//! \brief bit-bang a group of buses on simulated lines
+//! \param group bus group
+//! \param lines 8 simulated lines, one per pin, only those in mask are used
+//! \param mask pins of the group
+//!
+//! Lines of a group are driven in lockstep, their virtual times stay equal
+//! if they start equal.
+//!
+void host_onewire_groupInit(onewire_group_t *group, onewire_sim_t **lines, uint8_t mask);
+
+
+//! \brief initialize a simulated UART tied to a simulated line
+//! \param uart simulated UART
+//! \param sim simulated line
+//!
+//! Pass &uart->port to onewire_uart_init() to drive a bus with it.
+//!
+void onewire_sim_uartInit(onewire_sim_uart_t *uart, onewire_sim_t *sim);
+
+
+//! \brief raise the interrupt ending a started transfer
+//! \param uart simulated UART
+//! \return false if no transfer was pending
+//!
+//! A started transfer is already on the line when start returns; its
+//! completion is held until this call, as a real one waits for the UART
+//! interrupt.
+//!
+bool onewire_sim_uartInterrupt(onewire_sim_uart_t *uart);
+
+
+//! \brief initialize a simulated DS2482 bridge on an I2C bus of its own
+//! \param bridge simulated bridge
+//! \param lines simulated line of each channel, NULL entries are left open
+//! \param channels DS2482_100_CHANNELS or DS2482_800_CHANNELS
+//! \param address 7-bit I2C address the bridge answers
+//!
+//! Pass &bridge->port to onewire_ds2482_init().
+//!
+void onewire_sim_ds2482Init(onewire_sim_ds2482_t *bridge, onewire_sim_t **lines,
+                            uint8_t channels, uint8_t address);
+
+
+//! \brief initialize a simulated one-shot timer
+//! \param timer simulated timer
+//! \param sim simulated line
+//! \param isr interrupt handler, e.g. a wrapper of onewire_async_tick()
+//! \param arg argument of the interrupt handler
+//!
+//! Pass &timer->port to onewire_async_init().
+//!
+void onewire_sim_timerInit(onewire_sim_timer_t *timer, onewire_sim_t *sim,
+                            void (*isr)(void *arg), void *arg);
+
+
+//! \brief run the main loop for some virtual time
+//! \param timer simulated timer
+//! \param ns duration in nanoseconds
+//! \return number of interrupts fired in that time
+//!
+//! The interrupt handler is called at every deadline that falls in the
+//! window, time spent in the handler is added to the window.
+//!
+uint16_t onewire_sim_timerRun(onewire_sim_timer_t *timer, uint32_t ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+//! \file onewire_uart.h
+//! \brief UART driven physical layer for 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 16
+//!
+//! The UART TX pin (open-drain) and RX pin are tied to the 1-wire line.
+//! A reset is one 0xF0 byte at 9600 baud: slaves answering with a presence
+//! pulse corrupt the echoed byte. Every data slot is one byte at 115200 baud:
+//! 0xFF writes a '1' or reads a bit, 0x00 writes a '0'. The echoed byte is
+//! 0xFF only if no slave pulled the line low.
+//!
+//! Overdrive profiles, selected by onewire_overdriveSkip() and
+//! onewire_overdriveSelect(), switch the UART to faster rates: a reset is
+//! one 0xFC byte at 57600 baud, 52 us low with the presence pulse sampled
+//! at 61 us and 121 us of recovery, and every data slot one byte at
+//! 1 Mbaud, 1 us low for a '1' and 9 us for a '0'. The UART must reach
+//! 1 Mbaud.
+//!
+//! Whole onewire_sendBuffer()/onewire_receiveBuffer() calls are handed to
+//! the UART port in chunks of ONEWIRE_UART_CHUNK slots, so a port can move
+//! them with its FIFO or a DMA engine. These calls return once the data is
+//! on the line; onewire_uart_sendAsync()/onewire_uart_receiveAsync() return
+//! at once instead, the next chunk being started from the interrupt of the
+//! port, and report the end of the transfer through a callback.
+//!
+//! A reset echoed as 0x00 means the line stayed low during the whole frame,
+//! longer than any presence pulse: the line is shorted, no slave answered.
+
+#ifndef __ONEWIRE_UART__
+#define __ONEWIRE_UART__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+#define ONEWIRE_UART_RESET_BAUDRATE     9600
+#define ONEWIRE_UART_DATA_BAUDRATE      115200
+#define ONEWIRE_UART_OVERDRIVE_RESET_BAUDRATE   57600
+#define ONEWIRE_UART_OVERDRIVE_DATA_BAUDRATE    1000000
+
+//! number of slots (UART bytes) handed to the port at once
+#ifndef ONEWIRE_UART_CHUNK
+#define ONEWIRE_UART_CHUNK              64
+#endif
+
+
+//! \brief UART used as 1-wire master.
+//!
+typedef struct onewire_uart_port {
+    //! change baudrate, called between transfers only
+    void (*setBaudrate)(void *context, uint32_t baudrate);
+
+    //! send len bytes and receive the len bytes echoed by the line
+    void (*transfer)(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len);
+
+    //! start the same transfer and return, call complete(arg) from the
+    //! interrupt that ends it; NULL if the port only blocks
+    void (*start)(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                    void (*complete)(void *arg), void *arg);
+
+    //! wait ms milliseconds with TX idle, the line stays released
+    void (*delay)(void *context, uint16_t ms);
+
+    void *context;
+} onewire_uart_port_t;
+
+
+//! \brief Transfer running in the background on a UART bus.
+//!
+typedef struct onewire_uart_job {
+    const onewire_uart_port_t *port;    //!< port of the bus
+    const uint8_t *tx;                  //!< bytes left to send, NULL for a receive
+    uint8_t *rx;                        //!< bytes left to receive, NULL for a send
+    uint16_t len;                       //!< bytes left, running chunk included
+    uint16_t count;                     //!< bytes of the running chunk
+    volatile bool busy;                 //!< transfer not finished
+    void (*done)(struct onewire_uart_job *job); //!< called at the end, optional
+    void *arg;                          //!< application data
+    uint8_t slots_tx[ONEWIRE_UART_CHUNK];
+    uint8_t slots_rx[ONEWIRE_UART_CHUNK];
+} onewire_uart_job_t;
+
+
+//! \brief Tiva C UART, optionally moved by uDMA.
+//!
+//! UART and uDMA peripherals, pin muxing (TX as open-drain) and the uDMA
+//! control table must be set up by the application.
+//!
+typedef struct tiva_uart {
+    uint32_t base;                  //!< UART base address
+    bool use_udma;                  //!< move transfers with uDMA
+    uint32_t rx_channel;            //!< uDMA channel of UART RX, e.g. UDMA_CH8_UART0RX
+    uint32_t tx_channel;            //!< uDMA channel of UART TX, e.g. UDMA_CH9_UART0TX
+    onewire_uart_port_t port;       //!< filled by tiva_onewire_uart_init()
+    void (*complete)(void *arg);    //!< end of the started transfer
+    void *complete_arg;             //!< argument of complete
+} tiva_uart_t;
+
+
+//! \brief use a UART as physical layer of a bus
+//! \param bus bus handle
+//! \param port UART port, must stay valid while the bus is used
+//!
+void onewire_uart_init(onewire_bus_t *bus, const onewire_uart_port_t *port);
+
+
+//! \brief send a buffer in the background
+//! \param job transfer state, must stay valid until it is done
+//! \param bus bus handle of a UART bus, not used until the job is done
+//! \param buffer pointer to data buffer, must stay valid until the job is done
+//! \param len the size of data buffer
+//! \param done called from the interrupt at the end, optional
+//! \param arg stored in job->arg
+//!
+//! Ports without start run the transfer at once and call done before
+//! returning.
+//!
+void onewire_uart_sendAsync(onewire_uart_job_t *job, onewire_bus_t *bus,
+                            const void *buffer, uint16_t len,
+                            void (*done)(onewire_uart_job_t *job), void *arg);
+
+
+//! \brief receive a buffer in the background
+//! \param job transfer state, must stay valid until it is done
+//! \param bus bus handle of a UART bus, not used until the job is done
+//! \param buffer pointer to data buffer, filled when the job is done
+//! \param len the size of data buffer
+//! \param done called from the interrupt at the end, optional
+//! \param arg stored in job->arg
+//!
+void onewire_uart_receiveAsync(onewire_uart_job_t *job, onewire_bus_t *bus,
+                                void *buffer, uint16_t len,
+                                void (*done)(onewire_uart_job_t *job), void *arg);
+
+
+//! \brief use a Tiva C UART as physical layer of a bus
+//! \param bus bus handle
+//! \param uart UART description, must stay valid while the bus is used
+//!
+//! With uDMA, background transfers end in the UART interrupt: enable it
+//! and call tiva_onewire_uartIsr() from its handler.
+//!
+void tiva_onewire_uart_init(onewire_bus_t *bus, tiva_uart_t *uart);
+
+
+//! \brief UART interrupt handler of a Tiva C UART bus
+//! \param uart UART description
+//!
+void tiva_onewire_uartIsr(tiva_uart_t *uart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
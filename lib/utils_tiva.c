@@ -8,50 +8,52 @@
 #include <stdbool.h>
 
 #include "driverlib/sysctl.h"
-#include "driverlib/systick.h"
 
 
-volatile uint16_t counter = 0;
+// debug and trace registers of the Cortex-M4 core
+#define DEMCR           (*(volatile uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA    (1UL << 24)
+#define DWT_CTRL        (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNTENA   (1UL << 0)
 
 
-static void systick_isr();
+uint32_t timebase_us = 16;
 
-void systick_isr() {
-    if (counter > 0) {
-        counter--;
-    }
+
+void timebase_init(void) {
+    timebase_us = SysCtlClockGet() / 1000000;
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CYCCNTENA;
 }
 
 void delay_ms_init() {
-    SysTickPeriodSet(SysCtlClockGet()/1000); // period = 1 ms
-    SysTickIntRegister(systick_isr);
-    SysTickEnable();
+    timebase_init();
 }
 
 void delay_ms(uint16_t ms) {
-    counter = ms;
-
-    while (counter);
+    // 1 ms steps keep every wait far below the counter wrap-around
+    while (ms--) {
+        delay_cycles(1000 * timebase_us);
+    }
 }
 
 
 void delay_us_init() {
-    SysTickPeriodSet(SysCtlClockGet()/1000000); // period = 1 us
-    SysTickIntRegister(systick_isr);
-    SysTickEnable();
+    timebase_init();
 }
 
 void delay_us(uint16_t us) {
-    counter = us;
-
-    while (counter);
+    delay_cycles(us * timebase_us);
 }
 
 uint8_t timing(uint16_t us, uint8_t (*f)(void)) {
-    counter = us;
+    uint32_t start = timebase_now();
+    uint32_t cycles = us * timebase_us;
     uint8_t status = 1;
 
-    while (counter) {
+    while (timebase_now() - start < cycles) {
         status = f();
 
         if (status == 0) {
@@ -62,4 +64,4 @@ uint8_t timing(uint16_t us, uint8_t (*f)(void)) {
     return status;
 }
 
-/********************* End of File *******************************************/
\ No newline at end of file
+/********************* End of File *******************************************/
@@ -0,0 +1,864 @@
+//! \file onewire.c
+//! \brief Implementation for 1-wire protocol
+//! \author Nguyen Trong Phuong
+//! \date 2020 April 25
+
+#include "onewire.h"
+#include "onewire_crc.h"
+#include "onewire_phy.h"
+
+#include <stddef.h>
+
+
+const onewire_timing_t onewire_timing_standard = {
+    .write1_low         = ONEWIRE_US(6),
+    .write1_recovery    = ONEWIRE_US(64),
+    .write0_low         = ONEWIRE_US(60),
+    .write0_recovery    = ONEWIRE_US(10),
+    .read_sample        = ONEWIRE_US(9),
+    .read_recovery      = ONEWIRE_US(55),
+    .reset_delay        = ONEWIRE_US(0),
+    .reset_low          = ONEWIRE_US(480),
+    .presence_sample    = ONEWIRE_US(70),
+    .reset_recovery     = ONEWIRE_US(410),
+};
+
+const onewire_timing_t onewire_timing_overdrive = {
+    .write1_low         = ONEWIRE_US(1),
+    .write1_recovery    = ONEWIRE_US(7.5),
+    .write0_low         = ONEWIRE_US(7.5),
+    .write0_recovery    = ONEWIRE_US(2.5),
+    .read_sample        = ONEWIRE_US(1),
+    .read_recovery      = ONEWIRE_US(7),
+    .reset_delay        = ONEWIRE_US(2.5),
+    .reset_low          = ONEWIRE_US(70),
+    .presence_sample    = ONEWIRE_US(8.5),
+    .reset_recovery     = ONEWIRE_US(40),
+};
+
+const onewire_timing_t onewire_timing_longline = {
+    .write1_low         = ONEWIRE_US(6),
+    .write1_recovery    = ONEWIRE_US(74),
+    .write0_low         = ONEWIRE_US(60),
+    .write0_recovery    = ONEWIRE_US(20),
+    .read_sample        = ONEWIRE_US(12),
+    .read_recovery      = ONEWIRE_US(62),
+    .reset_delay        = ONEWIRE_US(0),
+    .reset_low          = ONEWIRE_US(500),
+    .presence_sample    = ONEWIRE_US(80),
+    .reset_recovery     = ONEWIRE_US(420),
+};
+
+
+static void writeBit0(onewire_bus_t *bus);
+static void writeBit1(onewire_bus_t *bus);
+static uint8_t readBit(onewire_bus_t *bus);
+
+static void onewire_initSearchRoutine(onewire_bus_t *bus);
+static uint8_t onewire_searchWith(onewire_bus_t *bus, uint8_t command,
+                                uint8_t address_box[][8], uint8_t number);
+static int8_t onewire_searchNextDevice(onewire_bus_t *bus, uint8_t command, uint8_t *address);
+static uint8_t onewire_checkTransfer(const uint8_t *command, uint8_t command_len,
+                                    const uint8_t *data, uint16_t len, uint8_t check);
+
+// bus windows, see windowTime()
+#define WINDOW_RESET    0
+#define WINDOW_WRITE0   1
+#define WINDOW_WRITE1   2
+#define WINDOW_READ     3
+
+static uint16_t windowTime(const onewire_timing_t *timing, uint8_t window, bool masked);
+
+#ifdef ONEWIRE_STATS
+static void stats_reset(onewire_bus_t *bus);
+static void stats_window(onewire_bus_t *bus, uint8_t window);
+static void stats_bytes(onewire_bus_t *bus, const uint8_t *data, uint16_t len);
+
+#define STATS_RESET(bus)                stats_reset(bus)
+#define STATS_WINDOW(bus, window)       stats_window(bus, window)
+#define STATS_BYTES(bus, data, len)     stats_bytes(bus, data, len)
+#else
+#define STATS_RESET(bus)
+#define STATS_WINDOW(bus, window)
+#define STATS_BYTES(bus, data, len)
+#endif
+
+
+//! \brief check the integrity of data with CRC-8
+//! \param data pointer to data buffer
+//! \param len the size of data buffer
+//! \return true or false
+//!
+bool onewire_checkData(const uint8_t *data, uint8_t len) {
+    return !crc8(0, data, len);
+}
+
+
+//! \brief select slot timing profile of a bus
+//! \param bus bus handle
+//! \param timing timing profile, must stay valid while the bus is used
+//!
+void onewire_setTiming(onewire_bus_t *bus, const onewire_timing_t *timing) {
+    bus->timing = timing;
+
+    convertTiming(&bus->delay, timing);
+
+    if (bus->driver && bus->driver->setTiming) {
+        bus->driver->setTiming(bus);
+    }
+}
+
+
+//! \brief reset 1-wire bus
+//! \param bus bus handle
+//!
+bool onewire_reset(onewire_bus_t *bus) {
+    bool status;
+    uint8_t timeout = 100;
+
+    STATS_RESET(bus);
+
+    if (bus->driver) {
+        status = bus->driver->reset(bus);
+        if (!status) {
+            ONEWIRE_STATS_COUNT(bus, presence_failures);
+        }
+        return status;
+    }
+
+    // wait until the line is released by slaves
+    while (!sampleBus(bus)) {
+        if (--timeout == 0) {
+            ONEWIRE_STATS_COUNT(bus, line_timeouts);
+            return false;
+        }
+        busDelay(bus, busTicks(ONEWIRE_US(2)));
+    }
+
+#ifdef ONEWIRE_SHORT_MASK
+    // interrupts may stretch a standard reset pulse, slaves accept it;
+    // only the presence sample point is timing-critical
+    bool mask_low = bus->timing->reset_low < ONEWIRE_STRETCH_RESET_LOW;
+
+    busDelay(bus, bus->delay.reset_delay);
+    if (mask_low) {
+        disableInterrupts();
+    }
+    holdBus(bus);
+    busDelay(bus, bus->delay.reset_low);
+    if (!mask_low) {
+        disableInterrupts();
+    }
+    releaseBus(bus);
+    busDelay(bus, bus->delay.presence_sample);
+    status = !sampleBus(bus);
+    enableInterrupts();
+    busDelay(bus, bus->delay.reset_recovery);
+#else
+    disableInterrupts();
+    busDelay(bus, bus->delay.reset_delay);
+    holdBus(bus);
+    busDelay(bus, bus->delay.reset_low);
+    releaseBus(bus);
+    busDelay(bus, bus->delay.presence_sample);
+    status = !sampleBus(bus);
+    busDelay(bus, bus->delay.reset_recovery);
+    enableInterrupts();
+#endif
+
+    if (!status) {
+        ONEWIRE_STATS_COUNT(bus, presence_failures);
+    }
+
+    return status;
+}
+
+
+//! \brief leave the line released while a slave draws power from it
+//! \param bus bus handle
+//! \param ms idle time in milliseconds
+//! \param strong switch the strong pull-up of the bus on during that time
+//!
+void onewire_idle(onewire_bus_t *bus, uint16_t ms, bool strong) {
+    bool pullup = strong && bus->pullup;
+
+    if (pullup) {
+        bus->pullup(bus, true);
+    }
+
+    if (bus->driver && bus->driver->idle) {
+        bus->driver->idle(bus, ms);
+    }
+    else {
+        // 100 us steps keep the ticks of busDelay() within 16 bits everywhere
+        for (uint32_t i = 0; i < (uint32_t)ms * 10; i++) {
+            busDelay(bus, busTicks(ONEWIRE_US(100)));
+        }
+    }
+
+    if (pullup) {
+        bus->pullup(bus, false);
+    }
+}
+
+
+//! \brief switch all slaves to overdrive speed
+//! \param bus bus handle
+//! \return true if a slave answered the reset
+//!
+bool onewire_overdriveSkip(onewire_bus_t *bus) {
+    if (!onewire_standardSpeed(bus)) {
+        return false;
+    }
+    onewire_send(bus, OVERDRIVE_SKIP);
+    onewire_setTiming(bus, &onewire_timing_overdrive);
+    return true;
+}
+
+
+//! \brief switch one slave to overdrive speed and select it
+//! \param bus bus handle
+//! \param address slave's address
+//! \return true if a slave answered the reset
+//!
+bool onewire_overdriveSelect(onewire_bus_t *bus, const uint8_t *address) {
+    if (!onewire_standardSpeed(bus)) {
+        return false;
+    }
+    onewire_send(bus, OVERDRIVE_MATCH);
+    onewire_setTiming(bus, &onewire_timing_overdrive);
+    onewire_sendBuffer(bus, address, 8);
+    return true;
+}
+
+
+//! \brief switch the bus and all slaves back to standard speed
+//! \param bus bus handle
+//! \return true if a slave answered the reset
+//!
+bool onewire_standardSpeed(onewire_bus_t *bus) {
+    // a reset at standard speed brings every slave back to standard speed
+    onewire_setTiming(bus, &onewire_timing_standard);
+    return onewire_reset(bus);
+}
+
+
+bool onewire_getSlaveAddress(onewire_bus_t *bus, uint8_t *address) {
+    if (!onewire_reset(bus)) {
+        return false;
+    }
+    onewire_send(bus, READ_ROM);
+    onewire_receiveBuffer(bus, address, 8);
+    return true;
+}
+
+
+uint8_t onewire_search(onewire_bus_t *bus, uint8_t address_box[][8], uint8_t number) {
+    return onewire_searchWith(bus, SEARCH_ROM, address_box, number);
+}
+
+
+uint8_t onewire_searchAlarm(onewire_bus_t *bus, uint8_t address_box[][8], uint8_t number) {
+    return onewire_searchWith(bus, ALARM_SEARCH, address_box, number);
+}
+
+
+uint8_t onewire_searchWith(onewire_bus_t *bus, uint8_t command,
+                            uint8_t address_box[][8], uint8_t number)
+{
+    uint8_t counter = 0;
+    int8_t status;
+
+    ONEWIRE_STATS_COUNT(bus, searches);
+    onewire_initSearchRoutine(bus);
+
+    for (uint8_t i = 0; i < number; i++) {
+        status = onewire_searchNextDevice(bus, command, address_box[counter]);
+
+        if (status == 0) {
+            break;
+        }
+
+        if (status == 1) {
+            counter++;
+        }
+    }
+
+    return counter;
+}
+
+
+uint8_t onewire_searchFamily(onewire_bus_t *bus, uint8_t family_code,
+                            uint8_t address_box[][8], uint8_t number)
+{
+    uint8_t counter = 0;
+    int8_t status;
+
+    ONEWIRE_STATS_COUNT(bus, searches);
+
+    // follow the family code, then all-zero bits up to the last one
+    onewire_initSearchRoutine(bus);
+    bus->ROM[0] = family_code;
+    bus->last_conflict_bit = 64;
+
+    for (uint8_t i = 0; i < number; i++) {
+        status = onewire_searchNextDevice(bus, SEARCH_ROM, address_box[counter]);
+
+        if (status == 0 || bus->ROM[0] != family_code) {
+            break;
+        }
+
+        if (status == 1) {
+            counter++;
+        }
+
+        // next pass would take the other branch inside the family code
+        if (bus->last_conflict_bit <= 8) {
+            break;
+        }
+    }
+
+    return counter;
+}
+
+
+void onewire_searchStart(onewire_bus_t *bus) {
+    ONEWIRE_STATS_COUNT(bus, searches);
+    onewire_initSearchRoutine(bus);
+}
+
+
+int8_t onewire_searchNext(onewire_bus_t *bus, uint8_t *address) {
+    return onewire_searchNextDevice(bus, SEARCH_ROM, address);
+}
+
+
+void onewire_initSearchRoutine(onewire_bus_t *bus) {
+    bus->last_conflict_bit = 0;
+    bus->is_last_device_found = false;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        bus->ROM[i] = 0;
+    }
+}
+
+//! \return 0: fail, 1: success, -1: invalid ROM
+int8_t onewire_searchNextDevice(onewire_bus_t *bus, uint8_t command, uint8_t *address) {
+    uint8_t bit_A, bit_B;
+    uint8_t direction;
+    uint8_t bit_index = 1;
+    uint8_t tmp_bit_index;
+    uint8_t *ROM = bus->ROM;
+
+    uint8_t conflict_marker = 0;
+
+    if (bus->is_last_device_found) {
+        bus->is_last_device_found = false;
+        return 0;
+    }
+
+    if (!onewire_reset(bus)) {
+        return 0;
+    }
+
+    onewire_send(bus, command);
+
+    while (bit_index <= 64) {
+        tmp_bit_index = bit_index - 1;
+
+        // branch taken if both of them are '0'
+        if (bit_index == bus->last_conflict_bit) {
+            direction = 1;
+        }
+        else if (bit_index > bus->last_conflict_bit) {
+            direction = 0;
+        }
+        else {
+            direction = (ROM[tmp_bit_index / 8] >> (tmp_bit_index % 8)) & 0x01;
+        }
+
+        if (bus->driver && bus->driver->triplet) {
+            uint8_t triplet = bus->driver->triplet(bus, direction);
+
+            STATS_WINDOW(bus, WINDOW_READ);
+            STATS_WINDOW(bus, WINDOW_READ);
+            bit_A = triplet & ONEWIRE_TRIPLET_ID;
+            bit_B = triplet & ONEWIRE_TRIPLET_COMPLEMENT;
+        }
+        else {
+            bit_A = readBit(bus);
+            bit_B = readBit(bus);
+        }
+
+        // if both of them are '1'
+        if (bit_A && bit_B) {
+            bus->last_conflict_bit = 0;
+            return 0;
+        }
+
+        // if either of them is '1'
+        if (bit_A || bit_B) {
+            direction = bit_A ? 1 : 0;
+        }
+        else if (direction == 0) {
+            conflict_marker = bit_index;
+        }
+
+        if (direction) {
+            ROM[tmp_bit_index / 8] |= (1 << (tmp_bit_index % 8));
+        }
+        else {
+            ROM[tmp_bit_index / 8] &= ~(1 << (tmp_bit_index % 8));
+        }
+
+        // the driver already wrote it
+        if (bus->driver && bus->driver->triplet) {
+            STATS_WINDOW(bus, direction ? WINDOW_WRITE1 : WINDOW_WRITE0);
+        }
+        else if (direction) {
+            writeBit1(bus);
+        }
+        else {
+            writeBit0(bus);
+        }
+        bit_index++;
+    }
+
+    bus->last_conflict_bit = conflict_marker;
+
+    if (bus->last_conflict_bit == 0) {
+        bus->is_last_device_found = true;
+    }
+
+    if (onewire_checkData(ROM, 8)) {
+        // copy ROM to address
+        for (uint8_t i = 0; i < 8; i++) {
+            address[i] = ROM[i];
+        }
+        return 1; 
+    }
+    else {
+        ONEWIRE_STATS_COUNT(bus, crc_failures);
+        return -1;
+    } 
+}
+
+
+//! \brief select slave with specific address
+//! \param bus bus handle
+//! \param address slave's address
+//!
+bool onewire_select(onewire_bus_t *bus, const uint8_t *address) {
+    if (!onewire_reset(bus)) {
+        return false;
+    }
+    onewire_send(bus, MATCH_ROM);
+    onewire_sendBuffer(bus, address, 8);
+    return true;
+}
+
+
+bool onewire_selectAll(onewire_bus_t *bus) {
+    if (!onewire_reset(bus)) {
+        return false;
+    }
+    onewire_send(bus, SKIP_ROM);
+    return true;
+}
+
+
+//! \brief send 1 byte to slave
+//! \param bus bus handle
+//! \param data 1 byte data
+//!
+void onewire_send(onewire_bus_t *bus, uint8_t data) {
+    if (bus->driver && bus->driver->sendBuffer) {
+        STATS_BYTES(bus, &data, 1);
+        bus->driver->sendBuffer(bus, &data, 1);
+        return;
+    }
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        if (data & (1 << bit)) {
+            writeBit1(bus);
+        }
+        else {
+            writeBit0(bus);
+        }
+    }
+}
+
+
+//! \brief send a buffer to slave
+//! \param bus bus handle
+//! \param buffer pointer to data buffer
+//! \param len the size of data buffer
+//!
+void onewire_sendBuffer(onewire_bus_t *bus, const void *buffer, uint16_t len) {
+    const uint8_t *data = (const uint8_t*)buffer;
+
+    if (bus->driver && bus->driver->sendBuffer) {
+        STATS_BYTES(bus, data, len);
+        bus->driver->sendBuffer(bus, data, len);
+        return;
+    }
+
+    for (int i = 0; i < len; i++) {
+        onewire_send(bus, data[i]);
+    }
+}
+
+
+//! \brief receive 1 byte from slave
+//! \param bus bus handle
+//! \return 1 byte
+//!
+uint8_t onewire_receive(onewire_bus_t *bus) {
+    uint8_t data = 0;
+
+    if (bus->driver && bus->driver->receiveBuffer) {
+        STATS_BYTES(bus, NULL, 1);
+        bus->driver->receiveBuffer(bus, &data, 1);
+        return data;
+    }
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        data |= (readBit(bus) << bit);
+    }
+
+    return data;
+}
+
+
+//! \brief receive a buffer from slave
+//! \param bus bus handle
+//! \param buffer pointer to data buffer
+//! \param len the size of data buffer
+//!
+void onewire_receiveBuffer(onewire_bus_t *bus, void *buffer, uint16_t len) {
+    uint8_t *data = (uint8_t*)buffer;
+
+    if (bus->driver && bus->driver->receiveBuffer) {
+        STATS_BYTES(bus, NULL, len);
+        bus->driver->receiveBuffer(bus, data, len);
+        return;
+    }
+
+    for (int i = 0; i < len; i++) {
+        data[i] = onewire_receive(bus);
+    }
+}
+
+
+//! \brief send 1 bit to slave
+//! \param bus bus handle
+//! \param bit '0' or '1'
+//!
+void onewire_sendBit(onewire_bus_t *bus, uint8_t bit) {
+    if (bit) {
+        writeBit1(bus);
+    }
+    else {
+        writeBit0(bus);
+    }
+}
+
+
+//! \brief receive 1 bit from slave
+//! \param bus bus handle
+//! \return '0' or '1'
+//!
+uint8_t onewire_receiveBit(onewire_bus_t *bus) {
+    return readBit(bus);
+}
+
+
+//! \brief run a command that reads checked data, repeat it on error
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param command command and its parameters
+//! \param command_len the size of command
+//! \param data receive buffer, including the CRC bytes
+//! \param len the size of data
+//! \param check ONEWIRE_CHECK_xx, optionally or'ed with ONEWIRE_CHECK_RESUME
+//! \param retries number of repeats allowed after the first attempt
+//! \return ONEWIRE_OK or the error of the last attempt
+//!
+uint8_t onewire_transfer(onewire_bus_t *bus, const uint8_t *address,
+                        const uint8_t *command, uint8_t command_len,
+                        uint8_t *data, uint16_t len, uint8_t check, uint8_t retries)
+{
+    uint8_t status;
+    bool matched = false;
+
+    for (;;) {
+        if (!onewire_reset(bus)) {
+            status = ONEWIRE_NO_PRESENCE;
+        }
+        else {
+            if (!address) {
+                onewire_send(bus, SKIP_ROM);
+            }
+            else if (matched && (check & ONEWIRE_CHECK_RESUME)) {
+                onewire_send(bus, RESUME);
+            }
+            else {
+                onewire_send(bus, MATCH_ROM);
+                onewire_sendBuffer(bus, address, 8);
+                matched = true;
+            }
+
+            onewire_sendBuffer(bus, command, command_len);
+            onewire_receiveBuffer(bus, data, len);
+
+            status = onewire_checkTransfer(command, command_len, data, len, check);
+            if (status == ONEWIRE_CRC_ERROR) {
+                ONEWIRE_STATS_COUNT(bus, crc_failures);
+            }
+        }
+
+        if (status == ONEWIRE_OK || retries == 0) {
+            return status;
+        }
+
+        retries--;
+        ONEWIRE_STATS_COUNT(bus, retries);
+    }
+}
+
+
+uint8_t onewire_checkTransfer(const uint8_t *command, uint8_t command_len,
+                            const uint8_t *data, uint16_t len, uint8_t check)
+{
+    uint16_t crc;
+    uint16_t ones = 0;
+
+    check &= ~ONEWIRE_CHECK_RESUME;
+
+    if (check == ONEWIRE_CHECK_NONE || len == 0) {
+        return ONEWIRE_OK;
+    }
+
+    while (ones < len && data[ones] == 0xFF) {
+        ones++;
+    }
+    if (ones == len) {
+        return ONEWIRE_NO_RESPONSE;
+    }
+
+    if (check == ONEWIRE_CHECK_CRC8) {
+        return onewire_checkData(data, len) ? ONEWIRE_OK : ONEWIRE_CRC_ERROR;
+    }
+
+    if (len < 2) {
+        return ONEWIRE_CRC_ERROR;
+    }
+
+    crc = crc16(0, command, command_len);
+    crc = crc16(crc, data, len - 2);
+
+    return crc16_check(crc, &data[len - 2]) ? ONEWIRE_OK : ONEWIRE_CRC_ERROR;
+}
+
+
+//! \brief worst-case time a bus keeps interrupts masked
+//! \param bus bus handle
+//! \return time in tenths of microsecond for the current timing profile
+//!
+uint16_t onewire_maskedTime(const onewire_bus_t *bus) {
+    uint16_t worst = 0;
+
+    for (uint8_t window = WINDOW_RESET; window <= WINDOW_READ; window++) {
+        uint16_t time = windowTime(bus->timing, window, true);
+
+        if (time > worst) {
+            worst = time;
+        }
+    }
+
+    return worst;
+}
+
+
+//! \brief duration of a bus window, or the part of it with interrupts masked
+//!
+uint16_t windowTime(const onewire_timing_t *timing, uint8_t window, bool masked) {
+    switch (window) {
+        case WINDOW_RESET:
+#ifdef ONEWIRE_SHORT_MASK
+            if (masked) {
+                return timing->presence_sample
+                    + (timing->reset_low < ONEWIRE_STRETCH_RESET_LOW ? timing->reset_low : 0);
+            }
+#endif
+            return timing->reset_delay + timing->reset_low
+                + timing->presence_sample + timing->reset_recovery;
+
+        case WINDOW_WRITE0:
+#ifdef ONEWIRE_SHORT_MASK
+            if (masked) {
+                return timing->write0_low;
+            }
+#endif
+            return timing->write0_low + timing->write0_recovery;
+
+        case WINDOW_WRITE1:
+#ifdef ONEWIRE_SHORT_MASK
+            if (masked) {
+                return timing->write1_low;
+            }
+#endif
+            return timing->write1_low + timing->write1_recovery;
+
+        default:
+#ifdef ONEWIRE_SHORT_MASK
+            if (masked) {
+                return timing->write1_low + timing->read_sample;
+            }
+#endif
+            return timing->write1_low + timing->read_sample + timing->read_recovery;
+    }
+}
+
+
+//! \brief write '0' bit
+//!
+void writeBit0(onewire_bus_t *bus) {
+    STATS_WINDOW(bus, WINDOW_WRITE0);
+
+    if (bus->driver) {
+        bus->driver->touchBit(bus, 0);
+        return;
+    }
+
+    disableInterrupts();
+    holdBus(bus);
+    busDelay(bus, bus->delay.write0_low);
+    releaseBus(bus);
+    criticalEnd();
+    busDelay(bus, bus->delay.write0_recovery);
+    slotEnd();
+}
+
+
+//! \brief write '1' bit
+//!
+void writeBit1(onewire_bus_t *bus) {
+    STATS_WINDOW(bus, WINDOW_WRITE1);
+
+    if (bus->driver) {
+        bus->driver->touchBit(bus, 1);
+        return;
+    }
+
+    disableInterrupts();
+    holdBus(bus);
+    busDelay(bus, bus->delay.write1_low);
+    releaseBus(bus);
+    criticalEnd();
+    busDelay(bus, bus->delay.write1_recovery);
+    slotEnd();
+}
+
+
+//! \brief read a bit from bus
+//!
+uint8_t readBit(onewire_bus_t *bus) {
+    STATS_WINDOW(bus, WINDOW_READ);
+
+    if (bus->driver) {
+        return bus->driver->touchBit(bus, 1);
+    }
+
+    disableInterrupts();
+    holdBus(bus);
+    busDelay(bus, bus->delay.write1_low);
+    releaseBus(bus);
+    busDelay(bus, bus->delay.read_sample);
+
+    uint8_t bit = sampleBus(bus);
+    criticalEnd();
+    busDelay(bus, bus->delay.read_recovery);
+    slotEnd();
+
+    return bit;
+}
+
+
+#ifdef ONEWIRE_STATS
+
+//! \brief copy the stats block of a bus
+//! \param bus bus handle
+//! \param stats output copy
+//!
+void onewire_stats_snapshot(const onewire_bus_t *bus, onewire_stats_t *stats) {
+    *stats = bus->stats;
+}
+
+
+//! \brief clear the stats block of a bus
+//! \param bus bus handle
+//!
+void onewire_stats_clear(onewire_bus_t *bus) {
+    bus->stats = (onewire_stats_t){0};
+}
+
+
+//! \brief log2 bucket of a time in tenths of microsecond
+//!
+static uint8_t stats_bucket(uint32_t time) {
+    uint8_t bucket = 0;
+
+    time /= 10;
+    while (time > 1 && bucket < ONEWIRE_STATS_BUCKETS - 1) {
+        time >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+
+//! \brief close the running transaction and account a reset pulse
+//!
+void stats_reset(onewire_bus_t *bus) {
+    if (bus->stats.transaction) {
+        bus->stats.duration[stats_bucket(bus->stats.transaction)]++;
+        bus->stats.transaction = 0;
+    }
+
+    bus->stats.resets++;
+    stats_window(bus, WINDOW_RESET);
+}
+
+
+//! \brief account a slot or reset, masked if the bus is bit-banged
+//!
+void stats_window(onewire_bus_t *bus, uint8_t window) {
+    bus->stats.transaction += windowTime(bus->timing, window, false);
+
+    if (!bus->driver) {
+        bus->stats.masked[stats_bucket(windowTime(bus->timing, window, true))]++;
+    }
+}
+
+
+//! \brief account bytes sent, or received if data is NULL, by a driver
+//!
+void stats_bytes(onewire_bus_t *bus, const uint8_t *data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (!data) {
+                stats_window(bus, WINDOW_READ);
+            }
+            else if (data[i] & (1 << bit)) {
+                stats_window(bus, WINDOW_WRITE1);
+            }
+            else {
+                stats_window(bus, WINDOW_WRITE0);
+            }
+        }
+    }
+}
+
+#endif
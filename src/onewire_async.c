@@ -0,0 +1,293 @@
+//! \file onewire_async.c
+//! \brief Non-blocking 1-wire transactions driven by a timer interrupt
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 23
+
+#include "onewire_async.h"
+#include "onewire_phy.h"
+
+#include <stddef.h>
+
+
+// states of the slot state machine
+#define ASYNC_RESET_LOW         0
+#define ASYNC_RESET_RELEASE     1
+#define ASYNC_RESET_RECOVERY    2
+#define ASYNC_SLOT              3
+#define ASYNC_FINISH            4
+
+// stages of a transaction
+#define STAGE_COMMAND           0
+#define STAGE_ADDRESS           1
+#define STAGE_WRITE             2
+#define STAGE_READ              3
+#define STAGE_END               4
+
+
+static bool async_loadByte(onewire_async_t *engine);
+static bool async_nextBit(onewire_async_t *engine);
+static void async_finish(onewire_async_t *engine, uint8_t status);
+
+
+//! \brief attach an asynchronous engine to a bus
+//! \param engine asynchronous engine
+//! \param bus GPIO bit-banged bus
+//! \param timer timer port, must stay valid while the engine is used
+//!
+void onewire_async_init(onewire_async_t *engine, onewire_bus_t *bus,
+                        const onewire_timer_port_t *timer)
+{
+    engine->bus = bus;
+    engine->timer = timer;
+    engine->transaction = NULL;
+}
+
+
+//! \brief start a transaction
+//! \param engine asynchronous engine
+//! \param transaction transaction, must stay valid until it ends
+//! \return false if another transaction is running
+//!
+bool onewire_async_submit(onewire_async_t *engine, onewire_transaction_t *transaction) {
+    if (engine->transaction) {
+        return false;
+    }
+
+    transaction->status = ONEWIRE_ASYNC_PENDING;
+
+    engine->stage = STAGE_COMMAND;
+    engine->index = 0;
+    engine->presence = true;
+
+    if (transaction->reset) {
+        engine->state = ASYNC_RESET_LOW;
+    }
+    else {
+        engine->state = ASYNC_SLOT;
+    }
+
+    engine->transaction = transaction;
+
+    if (engine->state == ASYNC_SLOT && !async_loadByte(engine)) {
+        async_finish(engine, ONEWIRE_ASYNC_DONE);
+        return true;
+    }
+
+    engine->timer->schedule(engine->timer->context,
+                            engine->bus->timing->reset_delay);
+
+    return true;
+}
+
+
+//! \brief check whether a transaction is running
+//! \param engine asynchronous engine
+//! \return true or false
+//!
+bool onewire_async_isBusy(const onewire_async_t *engine) {
+    return engine->transaction != NULL;
+}
+
+
+//! \brief run the next step of the current transaction
+//! \param engine asynchronous engine
+//!
+void onewire_async_tick(onewire_async_t *engine) {
+    onewire_bus_t *bus = engine->bus;
+    const onewire_timing_t *timing = bus->timing;
+    uint16_t next;
+
+    if (engine->transaction == NULL) {
+        engine->timer->stop(engine->timer->context);
+        return;
+    }
+
+    switch (engine->state) {
+    case ASYNC_RESET_LOW:
+        // a late interrupt would stretch an overdrive reset past its
+        // 80 us max, slaves would take it for a standard-speed one
+        if (timing->reset_low < ONEWIRE_US(100)) {
+            disableInterrupts();
+            holdBus(bus);
+            busDelay(bus, bus->delay.reset_low);
+            releaseBus(bus);
+            busDelay(bus, bus->delay.presence_sample);
+            engine->presence = !sampleBus(bus);
+            enableInterrupts();
+
+            engine->state = ASYNC_RESET_RECOVERY;
+            next = timing->reset_recovery;
+            break;
+        }
+
+        holdBus(bus);
+        engine->state = ASYNC_RESET_RELEASE;
+        next = timing->reset_low;
+        break;
+
+    case ASYNC_RESET_RELEASE:
+        // a presence pulse may end 75 us after the release, a sample
+        // served late would miss it
+        disableInterrupts();
+        releaseBus(bus);
+        busDelay(bus, bus->delay.presence_sample);
+        engine->presence = !sampleBus(bus);
+        enableInterrupts();
+
+        engine->state = ASYNC_RESET_RECOVERY;
+        next = timing->reset_recovery;
+        break;
+
+    case ASYNC_RESET_RECOVERY:
+        if (!engine->presence) {
+            async_finish(engine, ONEWIRE_ASYNC_NO_PRESENCE);
+            return;
+        }
+
+        if (!async_loadByte(engine)) {
+            async_finish(engine, ONEWIRE_ASYNC_DONE);
+            return;
+        }
+
+        engine->state = ASYNC_SLOT;
+        // fall through
+
+    case ASYNC_SLOT:
+        if (engine->stage == STAGE_READ) {
+            disableInterrupts();
+            holdBus(bus);
+            busDelay(bus, bus->delay.write1_low);
+            releaseBus(bus);
+            busDelay(bus, bus->delay.read_sample);
+
+            if (sampleBus(bus)) {
+                engine->data |= engine->mask;
+            }
+            enableInterrupts();
+
+            next = timing->read_recovery;
+        }
+        else if (engine->data & engine->mask) {
+            disableInterrupts();
+            holdBus(bus);
+            busDelay(bus, bus->delay.write1_low);
+            releaseBus(bus);
+            enableInterrupts();
+
+            next = timing->write1_recovery;
+        }
+        else {
+            // busy-waited too: a timer interrupt served late would stretch
+            // the low time past tLOW0 max, or into a reset at overdrive
+            disableInterrupts();
+            holdBus(bus);
+            busDelay(bus, bus->delay.write0_low);
+            releaseBus(bus);
+            enableInterrupts();
+
+            next = timing->write0_recovery;
+        }
+
+        if (!async_nextBit(engine)) {
+            engine->state = ASYNC_FINISH;
+        }
+        break;
+
+    default:
+        async_finish(engine, ONEWIRE_ASYNC_DONE);
+        return;
+    }
+
+    engine->timer->schedule(engine->timer->context, next);
+}
+
+
+//! \brief move to the first byte of the next non-empty stage
+//! \return false if there is nothing left to transfer
+//!
+bool async_loadByte(onewire_async_t *engine) {
+    onewire_transaction_t *transaction = engine->transaction;
+
+    while (engine->stage < STAGE_END) {
+        uint16_t len = 0;
+
+        switch (engine->stage) {
+        case STAGE_COMMAND:
+            len = transaction->rom_command ? 1 : 0;
+            break;
+
+        case STAGE_ADDRESS:
+            len = (transaction->rom_command == MATCH_ROM && transaction->address) ? 8 : 0;
+            break;
+
+        case STAGE_WRITE:
+            len = transaction->tx_len;
+            break;
+
+        case STAGE_READ:
+            len = transaction->rx_len;
+            break;
+        }
+
+        if (engine->index < len) {
+            engine->mask = 0x01;
+
+            switch (engine->stage) {
+            case STAGE_COMMAND:
+                engine->data = transaction->rom_command;
+                break;
+
+            case STAGE_ADDRESS:
+                engine->data = transaction->address[engine->index];
+                break;
+
+            case STAGE_WRITE:
+                engine->data = transaction->tx[engine->index];
+                break;
+
+            default:
+                engine->data = 0;
+                break;
+            }
+            return true;
+        }
+
+        engine->stage++;
+        engine->index = 0;
+    }
+
+    return false;
+}
+
+
+//! \brief move to the next bit, storing the byte read when it is complete
+//! \return false if the transaction has no slot left
+//!
+bool async_nextBit(onewire_async_t *engine) {
+    engine->mask <<= 1;
+
+    if (engine->mask) {
+        return true;
+    }
+
+    if (engine->stage == STAGE_READ) {
+        engine->transaction->rx[engine->index] = engine->data;
+    }
+    engine->index++;
+
+    return async_loadByte(engine);
+}
+
+
+void async_finish(onewire_async_t *engine, uint8_t status) {
+    onewire_transaction_t *transaction = engine->transaction;
+
+    engine->timer->stop(engine->timer->context);
+    engine->transaction = NULL;
+
+    transaction->status = status;
+
+    if (transaction->callback) {
+        transaction->callback(transaction);
+    }
+}
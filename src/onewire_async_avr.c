@@ -0,0 +1,44 @@
+//! \file onewire_async_avr.c
+//! \brief Non-blocking 1-wire transactions, AVR Timer1 port
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 23
+
+#include "onewire_async.h"
+
+#include <stddef.h>
+
+#include <avr/io.h>
+
+
+static void avr_timer_schedule(void *context, uint16_t time);
+static void avr_timer_stop(void *context);
+
+
+//! \brief use Timer1 compare A of AVR as one-shot timer
+//! \param port timer port to fill
+//!
+void avr_onewire_timerInit(onewire_timer_port_t *port) {
+    port->schedule = avr_timer_schedule;
+    port->stop = avr_timer_stop;
+    port->context = NULL;
+
+    // normal mode, prescaler 8
+    TCCR1A = 0;
+    TCCR1B = (1 << CS11);
+    TIMSK1 &= ~(1 << OCIE1A);
+}
+
+
+void avr_timer_schedule(void *context, uint16_t time) {
+    // Timer1 counts F_CPU/8 per second, time is in tenths of microsecond
+    uint16_t ticks = ((uint32_t)time * (F_CPU / 80000UL)) / 1000;
+
+    OCR1A = TCNT1 + (ticks ? ticks : 1);
+    TIFR1 = (1 << OCF1A);
+    TIMSK1 |= (1 << OCIE1A);
+}
+
+
+void avr_timer_stop(void *context) {
+    TIMSK1 &= ~(1 << OCIE1A);
+}
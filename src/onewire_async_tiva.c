@@ -0,0 +1,54 @@
+//! \file onewire_async_tiva.c
+//! \brief Non-blocking 1-wire transactions, Tiva C timer port
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 23
+
+#include "onewire_async.h"
+
+#include <driverlib/sysctl.h>
+#include <driverlib/timer.h>
+
+
+static void tiva_timer_schedule(void *context, uint16_t time);
+static void tiva_timer_stop(void *context);
+
+
+//! \brief use a Tiva C timer as one-shot timer
+//! \param timer timer description
+//!
+void tiva_onewire_timerInit(tiva_timer_t *timer) {
+    timer->ticks_per_us = SysCtlClockGet() / 1000000;
+    timer->port.schedule = tiva_timer_schedule;
+    timer->port.stop = tiva_timer_stop;
+    timer->port.context = timer;
+
+    TimerDisable(timer->base, TIMER_A);
+    TimerConfigure(timer->base, TIMER_CFG_ONE_SHOT);
+    TimerIntEnable(timer->base, TIMER_TIMA_TIMEOUT);
+}
+
+
+//! \brief handle a Tiva C timer interrupt
+//! \param timer timer description
+//! \param engine asynchronous engine driven by this timer
+//!
+void tiva_onewire_timerISR(tiva_timer_t *timer, onewire_async_t *engine) {
+    TimerIntClear(timer->base, TIMER_TIMA_TIMEOUT);
+    onewire_async_tick(engine);
+}
+
+
+void tiva_timer_schedule(void *context, uint16_t time) {
+    tiva_timer_t *timer = (tiva_timer_t*)context;
+    uint32_t ticks = (time * timer->ticks_per_us) / 10;
+
+    TimerLoadSet(timer->base, TIMER_A, ticks ? ticks : 1);
+    TimerEnable(timer->base, TIMER_A);
+}
+
+
+void tiva_timer_stop(void *context) {
+    tiva_timer_t *timer = (tiva_timer_t*)context;
+
+    TimerDisable(timer->base, TIMER_A);
+}
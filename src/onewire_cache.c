@@ -0,0 +1,486 @@
+//! \file onewire_cache.c
+//! \brief Persistent cache of slave addresses with fast verification
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 20
+
+#include "onewire_cache.h"
+#include "onewire_crc.h"
+
+
+//! cache_checkPath() found no change
+#define CACHE_PATH_OK       0xFF
+
+
+static uint8_t romBit(const uint8_t *rom, uint8_t index) {
+    return (rom[index / 8] >> (index % 8)) & 0x01;
+}
+
+
+//! \brief number of leading bits, in search order, shared by 2 addresses
+//!
+static uint8_t commonPrefix(const uint8_t *a, const uint8_t *b) {
+    for (uint8_t i = 0; i < 8; i++) {
+        uint8_t diff = a[i] ^ b[i];
+
+        if (diff) {
+            uint8_t bit = 0;
+
+            while (!(diff & 0x01)) {
+                diff >>= 1;
+                bit++;
+            }
+            return i * 8 + bit;
+        }
+    }
+    return 64;
+}
+
+
+//! \brief sort addresses in the order a search finds them
+//!
+static void cache_sort(onewire_cache_t *cache) {
+    uint8_t (*box)[8] = cache->address_box;
+
+    for (uint8_t i = 1; i < cache->count; i++) {
+        for (uint8_t k = i; k > 0; k--) {
+            uint8_t prefix = commonPrefix(box[k - 1], box[k]);
+
+            if (prefix == 64 || !romBit(box[k - 1], prefix)) {
+                break;
+            }
+
+            for (uint8_t j = 0; j < 8; j++) {
+                uint8_t tmp = box[k][j];
+                box[k][j] = box[k - 1][j];
+                box[k - 1][j] = tmp;
+            }
+        }
+    }
+}
+
+
+//! \brief address a comes before address b in search order
+//!
+static bool searchBefore(const uint8_t *a, const uint8_t *b) {
+    uint8_t prefix = commonPrefix(a, b);
+
+    return prefix < 64 && !romBit(a, prefix);
+}
+
+
+//! \brief open (shift 1) or close (shift -1) a slot at index of the cache
+//!
+static void cache_move(onewire_cache_t *cache, uint8_t index, int8_t shift) {
+    uint8_t (*box)[8] = cache->address_box;
+
+    if (shift > 0) {
+        for (uint8_t i = cache->count; i > index; i--) {
+            for (uint8_t j = 0; j < 8; j++) {
+                box[i][j] = box[i - 1][j];
+            }
+        }
+        cache->count++;
+    }
+    else {
+        cache->count--;
+        for (uint8_t i = index; i < cache->count; i++) {
+            for (uint8_t j = 0; j < 8; j++) {
+                box[i][j] = box[i + 1][j];
+            }
+        }
+    }
+}
+
+
+//! \brief follow the search path of one cached address
+//! \param leaf bits checked past the last branch of the path
+//! \param subtree set to the path of the subtree that changed, if any
+//! \return depth of that subtree, CACHE_PATH_OK if the bus branches as the
+//! cache predicts
+//!
+static uint8_t cache_checkPath(onewire_bus_t *bus, const onewire_cache_t *cache,
+                                uint8_t index, bool strict, uint8_t leaf,
+                                uint8_t *subtree)
+{
+    uint8_t (*box)[8] = cache->address_box;
+    const uint8_t *rom = box[index];
+    uint8_t branch[8] = {0};
+    uint8_t depth = ONEWIRE_CACHE_MIN_DEPTH;
+    uint8_t prefix;
+
+    // the path branches where it leaves any other address, which in a
+    // sorted list is the running minimum of neighbour prefixes
+    prefix = 64;
+    for (uint8_t k = index; k > 0; k--) {
+        uint8_t common = commonPrefix(box[k - 1], box[k]);
+
+        if (common < prefix) {
+            prefix = common;
+            branch[prefix / 8] |= (1 << (prefix % 8));
+        }
+
+        if (k == index && prefix + 1 + leaf > depth) {
+            depth = prefix + 1 + leaf;
+        }
+    }
+
+    prefix = 64;
+    for (uint8_t k = index + 1; k < cache->count; k++) {
+        uint8_t common = commonPrefix(box[k - 1], box[k]);
+
+        if (common < prefix) {
+            prefix = common;
+            branch[prefix / 8] |= (1 << (prefix % 8));
+        }
+
+        if (k == index + 1 && prefix + 1 + leaf > depth) {
+            depth = prefix + 1 + leaf;
+        }
+    }
+
+    if (strict || depth > 64) {
+        depth = 64;
+    }
+
+    for (uint8_t j = 0; j < 8; j++) {
+        subtree[j] = rom[j];
+    }
+
+    if (!onewire_reset(bus)) {
+        return 0;
+    }
+    onewire_send(bus, SEARCH_ROM);
+
+    for (uint8_t i = 0; i < depth; i++) {
+        uint8_t bit_A = onewire_receiveBit(bus);
+        uint8_t bit_B = onewire_receiveBit(bus);
+        uint8_t bit = romBit(rom, i);
+
+        // no slave left on the path
+        if (bit_A && bit_B) {
+            return i;
+        }
+
+        if (romBit(branch, i)) {
+            // one side of the branch is empty
+            if (bit_A || bit_B) {
+                if (bit_A == bit) {
+                    subtree[i / 8] ^= (1 << (i % 8));
+                }
+                return i + 1;
+            }
+        }
+        else if (!bit_A && !bit_B) {
+            // new slaves on the other side
+            subtree[i / 8] ^= (1 << (i % 8));
+            return i + 1;
+        }
+        else if (bit_A != bit) {
+            // slaves of the path replaced by others
+            return i;
+        }
+
+        onewire_sendBit(bus, bit);
+    }
+
+    return CACHE_PATH_OK;
+}
+
+
+//! \brief initialize an empty cache
+//! \param cache address cache
+//! \param address_box storage for addresses
+//! \param capacity size of address_box
+//!
+void onewire_cache_init(onewire_cache_t *cache, uint8_t address_box[][8], uint8_t capacity) {
+    cache->address_box = address_box;
+    cache->count = 0;
+    cache->capacity = capacity;
+}
+
+
+//! \brief check that the bus holds exactly the cached slaves
+//! \param bus bus handle
+//! \param cache address cache
+//! \param strict check all 64 bits of every address
+//! \return true or false
+//!
+bool onewire_cache_verify(onewire_bus_t *bus, const onewire_cache_t *cache, bool strict) {
+    if (cache->count == 0) {
+        return !onewire_reset(bus);
+    }
+
+    for (uint8_t i = 0; i < cache->count; i++) {
+        uint8_t subtree[8];
+
+        if (cache_checkPath(bus, cache, i, strict, ONEWIRE_CACHE_LEAF_DEPTH, subtree) != CACHE_PATH_OK) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//! \brief verify the cache and search the bus again if it does not match
+//! \param bus bus handle
+//! \param cache address cache
+//! \param strict check all 64 bits of every address
+//! \return true if the cache was valid, false if it has been rebuilt
+//!
+bool onewire_cache_refresh(onewire_bus_t *bus, onewire_cache_t *cache, bool strict) {
+    if (onewire_cache_verify(bus, cache, strict)) {
+        return true;
+    }
+
+    cache->count = onewire_search(bus, cache->address_box, cache->capacity);
+    cache_sort(cache);
+
+    return false;
+}
+
+
+//! \brief merge one address found in a subtree, in search order
+//! \param lo first cached address of the subtree not merged yet
+//! \param hi index after the last cached address of the subtree
+//! \return number of addresses added or removed
+//!
+static uint8_t cache_merge(onewire_cache_t *cache, const uint8_t *address,
+                            uint8_t *lo, uint8_t *hi,
+                            void (*changed)(void *context, const uint8_t *address, bool present),
+                            void *context)
+{
+    uint8_t (*box)[8] = cache->address_box;
+    uint8_t changes = 0;
+
+    // cached addresses the search went past are gone
+    while (*lo < *hi && searchBefore(box[*lo], address)) {
+        if (changed) {
+            changed(context, box[*lo], false);
+        }
+        cache_move(cache, *lo, -1);
+        (*hi)--;
+        changes++;
+    }
+
+    if (*lo < *hi && commonPrefix(box[*lo], address) == 64) {
+        (*lo)++;
+        return changes;
+    }
+
+    if (cache->count == cache->capacity) {
+        return changes;
+    }
+
+    cache_move(cache, *lo, 1);
+    for (uint8_t j = 0; j < 8; j++) {
+        box[*lo][j] = address[j];
+    }
+    (*lo)++;
+    (*hi)++;
+
+    if (changed) {
+        changed(context, address, true);
+    }
+
+    return changes + 1;
+}
+
+
+//! \brief search one subtree again and merge what it holds into the cache
+//! \param subtree path of the subtree, bits from depth on are ignored
+//! \param depth number of leading bits shared by the subtree
+//! \param end set to the index after its last cached address
+//! \return number of addresses added or removed
+//!
+static uint8_t cache_rescan(onewire_bus_t *bus, onewire_cache_t *cache,
+                            const uint8_t *subtree, uint8_t depth,
+                            uint8_t *end,
+                            void (*changed)(void *context, const uint8_t *address, bool present),
+                            void *context)
+{
+    uint8_t (*box)[8] = cache->address_box;
+    uint8_t address[8];
+    uint8_t changes = 0;
+    uint8_t lo = 0;
+    uint8_t hi;
+
+    // cached addresses of the subtree are contiguous
+    while (lo < cache->count && commonPrefix(box[lo], subtree) < depth) {
+        if (!searchBefore(box[lo], subtree)) {
+            break;
+        }
+        lo++;
+    }
+
+    hi = lo;
+    while (hi < cache->count && commonPrefix(box[hi], subtree) >= depth) {
+        hi++;
+    }
+
+    // follow the subtree path, then all-zero bits, as onewire_searchFamily()
+    onewire_searchStart(bus);
+    for (uint8_t i = 0; i < depth; i++) {
+        bus->ROM[i / 8] |= romBit(subtree, i) << (i % 8);
+    }
+    bus->last_conflict_bit = 64;
+
+    for (uint16_t pass = 0; pass <= cache->capacity; pass++) {
+        int8_t status = onewire_searchNext(bus, address);
+
+        // an empty subtree makes the search leave it
+        if (status == 0 || commonPrefix(bus->ROM, subtree) < depth) {
+            break;
+        }
+
+        // CRC errors are skipped, the next pass moves on
+        if (status == 1) {
+            changes += cache_merge(cache, address, &lo, &hi, changed, context);
+        }
+
+        // next pass would branch out of the subtree
+        if (bus->last_conflict_bit <= depth) {
+            break;
+        }
+    }
+
+    // addresses left were not found
+    while (lo < hi) {
+        if (changed) {
+            changed(context, box[lo], false);
+        }
+        cache_move(cache, lo, -1);
+        hi--;
+        changes++;
+    }
+
+    *end = hi;
+
+    return changes;
+}
+
+
+//! \brief follow the bus changes since the last check or search
+//! \param bus bus handle
+//! \param cache address cache
+//! \param strict check all 64 bits of every address
+//! \param changed called for each address added (present) or removed, optional
+//! \param context first argument of changed
+//! \return number of addresses added or removed
+//!
+uint8_t onewire_cache_update(onewire_bus_t *bus, onewire_cache_t *cache, bool strict,
+                            void (*changed)(void *context, const uint8_t *address, bool present),
+                            void *context)
+{
+    const uint8_t root[8] = {0};
+    uint8_t subtree[8];
+    uint8_t changes = 0;
+    uint8_t end;
+    uint8_t i = 0;
+
+    if (cache->count == 0) {
+        return cache_rescan(bus, cache, root, 0, &end, changed, context);
+    }
+
+    // a flaky bus could report changes forever
+    for (uint16_t pass = 0; i < cache->count && pass < 2 * cache->capacity + 2; pass++) {
+        uint8_t depth = cache_checkPath(bus, cache, i, strict, ONEWIRE_CACHE_LEAF_DEPTH,
+                                        subtree);
+        uint8_t count = cache->count;
+        uint8_t found;
+        bool inside;
+        bool before;
+
+        if (depth == CACHE_PATH_OK) {
+            i++;
+            continue;
+        }
+
+        inside = commonPrefix(cache->address_box[i], subtree) >= depth;
+        before = searchBefore(subtree, cache->address_box[i]);
+
+        found = cache_rescan(bus, cache, subtree, depth, &end, changed, context);
+        changes += found;
+
+        // the path of address i is checked again unless it was searched or
+        // the change did not fit in the cache
+        if (inside) {
+            i = end;
+        }
+        else if (!found) {
+            i++;
+        }
+        else if (before) {
+            i += cache->count - count;
+        }
+    }
+
+    return changes;
+}
+
+
+//! \brief serialize a cache, protected by CRC-16
+//! \param cache address cache
+//! \param buffer output buffer, ONEWIRE_CACHE_SIZE(cache->count) bytes
+//! \param size the size of buffer
+//! \return number of bytes written, 0 if buffer is too small
+//!
+uint16_t onewire_cache_save(const onewire_cache_t *cache, uint8_t *buffer, uint16_t size) {
+    uint16_t len = ONEWIRE_CACHE_SIZE(cache->count);
+    uint16_t crc;
+
+    if (size < len) {
+        return 0;
+    }
+
+    buffer[0] = cache->count;
+    for (uint8_t i = 0; i < cache->count; i++) {
+        for (uint8_t j = 0; j < 8; j++) {
+            buffer[1 + i*8 + j] = cache->address_box[i][j];
+        }
+    }
+
+    crc = crc16(0, buffer, len - 2);
+    buffer[len - 2] = crc & 0xFF;
+    buffer[len - 1] = crc >> 8;
+
+    return len;
+}
+
+
+//! \brief load a cache serialized by onewire_cache_save()
+//! \param cache address cache, initialized with onewire_cache_init()
+//! \param buffer serialized cache
+//! \param size the size of buffer
+//! \return false if the data is corrupted or does not fit, cache is empty then
+//!
+bool onewire_cache_load(onewire_cache_t *cache, const uint8_t *buffer, uint16_t size) {
+    uint16_t len;
+    uint16_t crc;
+
+    cache->count = 0;
+
+    if (size < ONEWIRE_CACHE_SIZE(0) || buffer[0] > cache->capacity) {
+        return false;
+    }
+
+    len = ONEWIRE_CACHE_SIZE(buffer[0]);
+    if (size < len) {
+        return false;
+    }
+
+    crc = crc16(0, buffer, len - 2);
+    if (buffer[len - 2] != (crc & 0xFF) || buffer[len - 1] != (crc >> 8)) {
+        return false;
+    }
+
+    cache->count = buffer[0];
+    for (uint8_t i = 0; i < cache->count; i++) {
+        for (uint8_t j = 0; j < 8; j++) {
+            cache->address_box[i][j] = buffer[1 + i*8 + j];
+        }
+    }
+    cache_sort(cache);
+
+    return true;
+}
@@ -0,0 +1,67 @@
+//! \file onewire_crc.c
+//! \brief CRC-8 and CRC-16 used by 1-wire devices, bitwise method
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 2
+
+#include "onewire_crc.h"
+
+
+uint8_t crc8_update_bitwise(uint8_t crc, uint8_t data) {
+    crc ^= data;
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        if (crc & 0x01) {
+            crc = (crc >> 1) ^ 0x8C;
+        }
+        else {
+            crc >>= 1;
+        }
+    }
+
+    return crc;
+}
+
+
+uint16_t crc16_update_bitwise(uint16_t crc, uint8_t data) {
+    crc ^= data;
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        if (crc & 0x0001) {
+            crc = (crc >> 1) ^ 0xA001;
+        }
+        else {
+            crc >>= 1;
+        }
+    }
+
+    return crc;
+}
+
+
+uint8_t crc8(uint8_t crc, const void *buffer, uint16_t len) {
+    const uint8_t *data = (const uint8_t*)buffer;
+
+    while (len--) {
+        crc = crc8_update(crc, *data++);
+    }
+
+    return crc;
+}
+
+
+uint16_t crc16(uint16_t crc, const void *buffer, uint16_t len) {
+    const uint8_t *data = (const uint8_t*)buffer;
+
+    while (len--) {
+        crc = crc16_update(crc, *data++);
+    }
+
+    return crc;
+}
+
+
+bool crc16_check(uint16_t crc, const uint8_t *received) {
+    uint16_t value = received[0] | ((uint16_t)received[1] << 8);
+
+    return (uint16_t)~crc == value;
+}
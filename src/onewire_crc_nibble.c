@@ -0,0 +1,49 @@
+//! \file onewire_crc_nibble.c
+//! \brief CRC-8 and CRC-16 used by 1-wire devices, nibble table method
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 2
+
+#include "onewire_crc.h"
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+
+#define CRC_TABLE           PROGMEM
+#define readTable8(x)       pgm_read_byte(&(x))
+#define readTable16(x)      pgm_read_word(&(x))
+#else
+#define CRC_TABLE
+#define readTable8(x)       (x)
+#define readTable16(x)      (x)
+#endif
+
+
+//! CRC-8 of every 4-bit value, shifted 4 times
+static const uint8_t crc8_nibble_table[16] CRC_TABLE = {
+    0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8,
+    0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74,
+};
+
+//! CRC-16 of every 4-bit value, shifted 4 times
+static const uint16_t crc16_nibble_table[16] CRC_TABLE = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400,
+};
+
+
+uint8_t crc8_update_nibble(uint8_t crc, uint8_t data) {
+    crc ^= data;
+    crc = (crc >> 4) ^ readTable8(crc8_nibble_table[crc & 0x0F]);
+    crc = (crc >> 4) ^ readTable8(crc8_nibble_table[crc & 0x0F]);
+
+    return crc;
+}
+
+
+uint16_t crc16_update_nibble(uint16_t crc, uint8_t data) {
+    crc ^= data;
+    crc = (crc >> 4) ^ readTable16(crc16_nibble_table[crc & 0x0F]);
+    crc = (crc >> 4) ^ readTable16(crc16_nibble_table[crc & 0x0F]);
+
+    return crc;
+}
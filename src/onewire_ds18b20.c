@@ -0,0 +1,241 @@
+//! \file onewire_ds18b20.c
+//! \brief DS18B20 digital thermometer on 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 6
+
+#include "onewire_ds18b20.h"
+
+#include <stddef.h>
+
+
+static bool ds18b20_select(onewire_bus_t *bus, const uint8_t *address) {
+    if (address) {
+        return onewire_select(bus, address);
+    }
+    return onewire_selectAll(bus);
+}
+
+
+//! \brief set alarm thresholds and resolution of a thermometer
+//! \param bus bus handle
+//! \param address slave's address, NULL for all slaves
+//! \param low alarm when temperature is below, in degree Celsius
+//! \param high alarm when temperature is above, in degree Celsius
+//! \param resolution DS18B20_RESOLUTION_xx
+//! \return true or false
+//!
+bool ds18b20_configure(onewire_bus_t *bus, const uint8_t *address,
+                        int8_t low, int8_t high, uint8_t resolution)
+{
+    uint8_t data[4] = {DS18B20_WRITE_SCRATCHPAD, (uint8_t)high, (uint8_t)low, resolution};
+
+    if (!ds18b20_select(bus, address)) {
+        return false;
+    }
+    onewire_sendBuffer(bus, data, sizeof(data));
+    return true;
+}
+
+
+//! \brief start temperature conversion on all thermometers
+//! \param bus bus handle
+//! \return true or false
+//!
+bool ds18b20_convertAll(onewire_bus_t *bus) {
+    if (!onewire_selectAll(bus)) {
+        return false;
+    }
+    onewire_send(bus, DS18B20_CONVERT_T);
+    return true;
+}
+
+
+//! \brief check whether the running conversion has finished
+//! \param bus bus handle
+//! \return true or false
+//!
+bool ds18b20_isConversionDone(onewire_bus_t *bus) {
+    // slaves answer read slots with '0' while converting
+    return onewire_receive(bus) != 0;
+}
+
+
+//! \brief wait until the running conversion has finished
+//! \param bus bus handle
+//! \return false on timeout
+//!
+bool ds18b20_waitConversion(onewire_bus_t *bus) {
+    for (uint16_t i = 0; i < DS18B20_CONVERSION_TIMEOUT; i++) {
+        if (ds18b20_isConversionDone(bus)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+//! \brief read temperature of a thermometer
+//! \param bus bus handle
+//! \param address slave's address
+//! \param temperature temperature in 1/16 degree Celsius
+//! \return false if the slave is absent or the scratchpad is corrupted
+//!
+bool ds18b20_readTemperature(onewire_bus_t *bus, const uint8_t *address,
+                            int16_t *temperature)
+{
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_SIZE];
+    uint8_t command = DS18B20_READ_SCRATCHPAD;
+    uint8_t status;
+
+    status = onewire_transfer(bus, address, &command, 1,
+                            scratchpad, sizeof(scratchpad), ONEWIRE_CHECK_CRC8, 0);
+    if (status != ONEWIRE_OK) {
+        return false;
+    }
+
+    *temperature = (int16_t)(scratchpad[0] | ((uint16_t)scratchpad[1] << 8));
+    return true;
+}
+
+
+//! \brief read many thermometers with a single conversion
+//! \param bus bus handle
+//! \param address_box addresses of thermometers
+//! \param temperature array filled with temperatures
+//! \param number size of both arrays
+//! \param verify read the whole scratchpad and check its CRC, otherwise
+//!               0xFFFF is taken for an absent thermometer
+//! \return number of thermometers read
+//!
+uint8_t ds18b20_readAll(onewire_bus_t *bus, const uint8_t address_box[][8],
+                        int16_t *temperature, uint8_t number, bool verify)
+{
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_SIZE];
+    uint8_t command = DS18B20_READ_SCRATCHPAD;
+    uint8_t counter = 0;
+
+    for (uint8_t i = 0; i < number; i++) {
+        temperature[i] = DS18B20_NO_READING;
+    }
+
+    if (!ds18b20_convertAll(bus) || !ds18b20_waitConversion(bus)) {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < number; i++) {
+        uint8_t status;
+
+        if (verify) {
+            status = onewire_transfer(bus, address_box[i], &command, 1,
+                                    scratchpad, DS18B20_SCRATCHPAD_SIZE, ONEWIRE_CHECK_CRC8, 0);
+        }
+        else {
+            // the next reset ends the scratchpad read
+            status = onewire_transfer(bus, address_box[i], &command, 1,
+                                    scratchpad, 2, ONEWIRE_CHECK_NONE, 0);
+
+            // a slave gone after the presence pulse reads as all ones
+            if (scratchpad[0] == 0xFF && scratchpad[1] == 0xFF) {
+                status = ONEWIRE_NO_RESPONSE;
+            }
+        }
+
+        if (status != ONEWIRE_OK) {
+            continue;
+        }
+
+        temperature[i] = (int16_t)(scratchpad[0] | ((uint16_t)scratchpad[1] << 8));
+        counter++;
+    }
+
+    return counter;
+}
+
+
+//! \brief poll cycle reading only out-of-range thermometers
+//! \param bus bus handle
+//! \param address_box array filled with addresses of alarming slaves
+//! \param temperature array filled with their temperatures
+//! \param number size of both arrays
+//! \return number of alarming slaves read
+//!
+uint8_t ds18b20_monitor(onewire_bus_t *bus, uint8_t address_box[][8],
+                        int16_t *temperature, uint8_t number)
+{
+    uint8_t found;
+    uint8_t counter = 0;
+
+    if (!ds18b20_convertAll(bus) || !ds18b20_waitConversion(bus)) {
+        return 0;
+    }
+
+    found = onewire_searchAlarm(bus, address_box, number);
+
+    for (uint8_t i = 0; i < found; i++) {
+        if (!ds18b20_readTemperature(bus, address_box[i], &temperature[counter])) {
+            continue;
+        }
+
+        // keep both arrays aligned when a read fails
+        if (counter != i) {
+            for (uint8_t j = 0; j < 8; j++) {
+                address_box[counter][j] = address_box[i][j];
+            }
+        }
+        counter++;
+    }
+
+    return counter;
+}
+
+
+//! \brief start temperature conversion on all buses of a group
+//! \param group bus group
+//! \return mask of buses where a slave answered
+//!
+uint8_t ds18b20_groupConvertAll(onewire_group_t *group) {
+    uint8_t presence = onewire_group_selectAll(group);
+
+    onewire_group_send(group, DS18B20_CONVERT_T);
+
+    return presence;
+}
+
+
+//! \brief read one thermometer on each bus of a group
+//! \param group bus group
+//! \param address slave's address for each pin, NULL for single-drop buses
+//! \param temperature temperature for each pin, in 1/16 degree Celsius
+//! \return mask of buses where the temperature was read correctly
+//!
+uint8_t ds18b20_groupReadTemperature(onewire_group_t *group, const uint8_t address[8][8],
+                                    int16_t temperature[8])
+{
+    uint8_t scratchpad[8][DS18B20_SCRATCHPAD_SIZE];
+    uint8_t valid;
+
+    if (address) {
+        valid = onewire_group_select(group, address);
+    }
+    else {
+        valid = onewire_group_selectAll(group);
+    }
+
+    onewire_group_send(group, DS18B20_READ_SCRATCHPAD);
+    onewire_group_receiveBuffer(group, scratchpad, DS18B20_SCRATCHPAD_SIZE);
+
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        if (!(valid & (1 << pin))) {
+            continue;
+        }
+
+        if (!onewire_checkData(scratchpad[pin], DS18B20_SCRATCHPAD_SIZE)) {
+            valid &= ~(1 << pin);
+            continue;
+        }
+
+        temperature[pin] = (int16_t)(scratchpad[pin][0] | ((uint16_t)scratchpad[pin][1] << 8));
+    }
+
+    return valid;
+}
@@ -0,0 +1,285 @@
+//! \file onewire_ds2482.c
+//! \brief DS2482 I2C to 1-wire bridge as physical layer of a bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 15
+
+#include "onewire_ds2482.h"
+
+#include <stddef.h>
+
+
+static bool ds2482_reset(onewire_bus_t *bus);
+static uint8_t ds2482_touchBit(onewire_bus_t *bus, uint8_t bit);
+static void ds2482_sendBuffer(onewire_bus_t *bus, const uint8_t *data, uint16_t len);
+static void ds2482_receiveBuffer(onewire_bus_t *bus, uint8_t *data, uint16_t len);
+static uint8_t ds2482_triplet(onewire_bus_t *bus, uint8_t direction);
+static void ds2482_idle(onewire_bus_t *bus, uint16_t ms);
+
+static const onewire_driver_t ds2482_driver = {
+    .reset = ds2482_reset,
+    .touchBit = ds2482_touchBit,
+    .sendBuffer = ds2482_sendBuffer,
+    .receiveBuffer = ds2482_receiveBuffer,
+    .triplet = ds2482_triplet,
+    .idle = ds2482_idle,
+};
+
+//! channel select codes, and the values read back once selected
+static const uint8_t channel_code[DS2482_800_CHANNELS] = {
+    0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87
+};
+static const uint8_t channel_check[DS2482_800_CHANNELS] = {
+    0xB8, 0xB1, 0xAA, 0xA3, 0x9C, 0x95, 0x8E, 0x87
+};
+
+
+//! \brief send a command with an optional parameter byte
+//!
+static bool ds2482_command(onewire_ds2482_t *bridge, uint8_t command,
+                            const uint8_t *param)
+{
+    uint8_t data[2] = {command, param ? *param : 0};
+
+    return bridge->port->write(bridge->port->context, bridge->address, data, param ? 2 : 1);
+}
+
+
+//! \brief read the register selected by the read pointer
+//!
+static bool ds2482_read(onewire_ds2482_t *bridge, uint8_t *value) {
+    return bridge->port->read(bridge->port->context, bridge->address, value, 1);
+}
+
+
+//! \brief poll the status register until the 1-wire line is idle
+//! \return false if the bridge did not answer or stayed busy
+//!
+static bool ds2482_wait(onewire_ds2482_t *bridge, uint8_t *status) {
+    for (uint16_t poll = 0; poll < DS2482_POLL_LIMIT; poll++) {
+        if (!ds2482_read(bridge, status)) {
+            return false;
+        }
+
+        if (!(*status & DS2482_STATUS_1WB)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//! \brief write the configuration register, upper nibble is the complement
+//!
+static bool ds2482_writeConfig(onewire_ds2482_t *bridge, uint8_t config) {
+    uint8_t param = config | (~config << 4);
+    uint8_t check;
+
+    if (!ds2482_command(bridge, DS2482_WRITE_CONFIG, &param)) {
+        return false;
+    }
+
+    if (!ds2482_read(bridge, &check) || check != config) {
+        return false;
+    }
+
+    bridge->config = config;
+    return true;
+}
+
+
+//! \brief select the channel of a bus and the speed of its timing profile
+//! \return bridge of the bus, its channel may be left unselected on error
+//!
+static onewire_ds2482_t* ds2482_prepare(onewire_bus_t *bus) {
+    const onewire_ds2482_channel_t *channel = (const onewire_ds2482_channel_t*)bus->context;
+    onewire_ds2482_t *bridge = channel->bridge;
+    uint8_t config = bridge->config & ~DS2482_CONFIG_1WS;
+    uint8_t check;
+
+    if (bridge->channel != channel->index) {
+        bridge->channel = channel->index;
+
+        ds2482_command(bridge, DS2482_CHANNEL_SELECT, &channel_code[channel->index]);
+
+        if (!ds2482_read(bridge, &check) || check != channel_check[channel->index]) {
+            // selected again on the next operation
+            bridge->channel = DS2482_800_CHANNELS;
+        }
+    }
+
+    // overdrive profiles have reset pulses of 70 us, standard ones 480 us
+    if (bus->timing->reset_low < ONEWIRE_US(100)) {
+        config |= DS2482_CONFIG_1WS;
+    }
+
+    if (config != bridge->config) {
+        ds2482_writeConfig(bridge, config);
+    }
+
+    return bridge;
+}
+
+
+//! \brief reset a bridge and enable its active pull-up
+//! \param bridge bridge handle
+//! \param port I2C master, must stay valid while the bridge is used
+//! \param address 7-bit I2C address, DS2482_ADDRESS + AD2..AD0
+//! \param channels DS2482_100_CHANNELS or DS2482_800_CHANNELS
+//! \return true if the bridge answered
+//!
+bool onewire_ds2482_init(onewire_ds2482_t *bridge, const onewire_i2c_port_t *port,
+                        uint8_t address, uint8_t channels)
+{
+    uint8_t status;
+
+    bridge->port = port;
+    bridge->address = address;
+    bridge->channels = channels;
+    bridge->channel = 0;
+    bridge->config = 0;
+
+    for (uint8_t i = 0; i < DS2482_800_CHANNELS; i++) {
+        bridge->channel_list[i].bridge = bridge;
+        bridge->channel_list[i].index = i;
+    }
+
+    if (!ds2482_command(bridge, DS2482_DEVICE_RESET, NULL)) {
+        return false;
+    }
+
+    if (!ds2482_wait(bridge, &status) || !(status & DS2482_STATUS_RST)) {
+        return false;
+    }
+
+    return ds2482_writeConfig(bridge, DS2482_CONFIG_APU);
+}
+
+
+//! \brief use a channel of a bridge as physical layer of a bus
+//! \param bus bus handle
+//! \param bridge bridge initialized with onewire_ds2482_init()
+//! \param channel channel number, below the number of channels
+//!
+void onewire_ds2482_busInit(onewire_bus_t *bus, onewire_ds2482_t *bridge, uint8_t channel) {
+    bus->driver = &ds2482_driver;
+    bus->context = &bridge->channel_list[channel];
+    bus->pullup = NULL;
+    bus->last_conflict_bit = 0;
+    bus->is_last_device_found = false;
+#ifdef ONEWIRE_STATS
+    onewire_stats_clear(bus);
+#endif
+
+    onewire_setTiming(bus, &onewire_timing_standard);
+}
+
+
+bool ds2482_reset(onewire_bus_t *bus) {
+    onewire_ds2482_t *bridge = ds2482_prepare(bus);
+    uint8_t status;
+
+    if (!ds2482_command(bridge, DS2482_1WIRE_RESET, NULL)) {
+        return false;
+    }
+
+    if (!ds2482_wait(bridge, &status)) {
+        return false;
+    }
+
+    // a shorted line looks like a presence pulse
+    return (status & (DS2482_STATUS_PPD | DS2482_STATUS_SD)) == DS2482_STATUS_PPD;
+}
+
+
+uint8_t ds2482_touchBit(onewire_bus_t *bus, uint8_t bit) {
+    onewire_ds2482_t *bridge = ds2482_prepare(bus);
+    uint8_t param = bit ? 0x80 : 0x00;
+    uint8_t status;
+
+    // a failed slot reads as an idle line
+    if (!ds2482_command(bridge, DS2482_1WIRE_BIT, &param)) {
+        return 1;
+    }
+
+    if (!ds2482_wait(bridge, &status)) {
+        return 1;
+    }
+
+    return (status & DS2482_STATUS_SBR) ? 1 : 0;
+}
+
+
+void ds2482_sendBuffer(onewire_bus_t *bus, const uint8_t *data, uint16_t len) {
+    onewire_ds2482_t *bridge = ds2482_prepare(bus);
+    uint8_t status;
+
+    for (uint16_t i = 0; i < len; i++) {
+        if (!ds2482_command(bridge, DS2482_1WIRE_WRITE, &data[i])) {
+            return;
+        }
+
+        if (!ds2482_wait(bridge, &status)) {
+            return;
+        }
+    }
+}
+
+
+void ds2482_receiveBuffer(onewire_bus_t *bus, uint8_t *data, uint16_t len) {
+    onewire_ds2482_t *bridge = ds2482_prepare(bus);
+    const uint8_t pointer = DS2482_DATA_REGISTER;
+    uint8_t status;
+
+    for (uint16_t i = 0; i < len; i++) {
+        // a failed read reads as an idle line
+        data[i] = 0xFF;
+
+        if (!ds2482_command(bridge, DS2482_1WIRE_READ, NULL)) {
+            continue;
+        }
+
+        if (!ds2482_wait(bridge, &status)) {
+            continue;
+        }
+
+        if (ds2482_command(bridge, DS2482_SET_POINTER, &pointer)) {
+            ds2482_read(bridge, &data[i]);
+        }
+    }
+}
+
+
+//! \brief two read slots, then the write of the branch taken
+//!
+uint8_t ds2482_triplet(onewire_bus_t *bus, uint8_t direction) {
+    onewire_ds2482_t *bridge = ds2482_prepare(bus);
+    uint8_t param = direction ? 0x80 : 0x00;
+    uint8_t status;
+
+    // a failed triplet reads as no device answering
+    if (!ds2482_command(bridge, DS2482_1WIRE_TRIPLET, &param)) {
+        return ONEWIRE_TRIPLET_ID | ONEWIRE_TRIPLET_COMPLEMENT;
+    }
+
+    if (!ds2482_wait(bridge, &status)) {
+        return ONEWIRE_TRIPLET_ID | ONEWIRE_TRIPLET_COMPLEMENT;
+    }
+
+    return ((status & DS2482_STATUS_SBR) ? ONEWIRE_TRIPLET_ID : 0)
+        | ((status & DS2482_STATUS_TSB) ? ONEWIRE_TRIPLET_COMPLEMENT : 0);
+}
+
+
+//! \brief wait with the line held high by the active pull-up
+//!
+//! The strong pull-up (SPU) of the bridge only starts after a byte or bit
+//! written once it is set, too late here; parasite-powered slaves behind
+//! a bridge are left to the active pull-up.
+//!
+void ds2482_idle(onewire_bus_t *bus, uint16_t ms) {
+    const onewire_ds2482_channel_t *channel = (const onewire_ds2482_channel_t*)bus->context;
+    const onewire_i2c_port_t *port = channel->bridge->port;
+
+    port->delay(port->context, ms);
+}
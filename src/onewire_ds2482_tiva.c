@@ -0,0 +1,116 @@
+//! \file onewire_ds2482_tiva.c
+//! \brief DS2482 I2C to 1-wire bridge, Tiva C I2C master port
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 15
+
+#include "onewire_ds2482.h"
+
+#include <inc/hw_memmap.h>
+#include <inc/hw_types.h>
+#include <driverlib/i2c.h>
+
+
+static bool tiva_i2c_write(void *context, uint8_t address, const uint8_t *data, uint8_t len);
+static bool tiva_i2c_read(void *context, uint8_t address, uint8_t *data, uint8_t len);
+static void tiva_i2c_delay(void *context, uint16_t ms);
+
+
+//! \brief initialize the I2C port of a Tiva C I2C master
+//! \param i2c I2C description, pass &i2c->port to onewire_ds2482_init()
+//!
+void tiva_onewire_i2cInit(tiva_i2c_t *i2c) {
+    i2c->port.write = tiva_i2c_write;
+    i2c->port.read = tiva_i2c_read;
+    i2c->port.delay = tiva_i2c_delay;
+    i2c->port.context = i2c;
+
+    // idle times are counted by the cycle counter, no GPIO bus starts it
+    timebase_init();
+}
+
+
+//! \brief run one step of a transfer and wait for it
+//! \return false if a byte was not acknowledged
+//!
+static bool tiva_i2c_step(uint32_t base, uint32_t command) {
+    I2CMasterControl(base, command);
+    while (I2CMasterBusy(base));
+
+    if (I2CMasterErr(base) != I2C_MASTER_ERR_NONE) {
+        I2CMasterControl(base, I2C_MASTER_CMD_BURST_SEND_ERROR_STOP);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool tiva_i2c_write(void *context, uint8_t address, const uint8_t *data, uint8_t len) {
+    tiva_i2c_t *i2c = (tiva_i2c_t*)context;
+
+    I2CMasterSlaveAddrSet(i2c->base, address, false);
+
+    for (uint8_t i = 0; i < len; i++) {
+        uint32_t command;
+
+        if (len == 1) {
+            command = I2C_MASTER_CMD_SINGLE_SEND;
+        }
+        else if (i == 0) {
+            command = I2C_MASTER_CMD_BURST_SEND_START;
+        }
+        else if (i == len - 1) {
+            command = I2C_MASTER_CMD_BURST_SEND_FINISH;
+        }
+        else {
+            command = I2C_MASTER_CMD_BURST_SEND_CONT;
+        }
+
+        I2CMasterDataPut(i2c->base, data[i]);
+
+        if (!tiva_i2c_step(i2c->base, command)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool tiva_i2c_read(void *context, uint8_t address, uint8_t *data, uint8_t len) {
+    tiva_i2c_t *i2c = (tiva_i2c_t*)context;
+
+    I2CMasterSlaveAddrSet(i2c->base, address, true);
+
+    for (uint8_t i = 0; i < len; i++) {
+        uint32_t command;
+
+        if (len == 1) {
+            command = I2C_MASTER_CMD_SINGLE_RECEIVE;
+        }
+        else if (i == 0) {
+            command = I2C_MASTER_CMD_BURST_RECEIVE_START;
+        }
+        else if (i == len - 1) {
+            command = I2C_MASTER_CMD_BURST_RECEIVE_FINISH;
+        }
+        else {
+            command = I2C_MASTER_CMD_BURST_RECEIVE_CONT;
+        }
+
+        if (!tiva_i2c_step(i2c->base, command)) {
+            return false;
+        }
+
+        data[i] = I2CMasterDataGet(i2c->base);
+    }
+
+    return true;
+}
+
+
+void tiva_i2c_delay(void *context, uint16_t ms) {
+    (void)context;
+
+    delay_ms(ms);
+}
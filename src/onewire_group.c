@@ -0,0 +1,218 @@
+//! \file onewire_group.c
+//! \brief Up to 8 1-wire buses on one GPIO port driven in lockstep
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 13
+
+#include "onewire_group.h"
+#include "onewire_phy.h"
+
+
+#ifdef ONEWIRE_STATS
+#define STATS_GROUP_COUNT(group, counter, n)    ((group)->stats.counter += (n))
+#else
+#define STATS_GROUP_COUNT(group, counter, n)
+#endif
+
+
+//! \brief number of pins in a mask
+//!
+static inline uint8_t countPins(uint8_t mask) {
+    uint8_t count = 0;
+
+    for (; mask; mask &= mask - 1) {
+        count++;
+    }
+
+    return count;
+}
+
+
+//! \brief select slot timing profile of a group
+//! \param group bus group
+//! \param timing timing profile, must stay valid while the group is used
+//!
+void onewire_group_setTiming(onewire_group_t *group, const onewire_timing_t *timing) {
+    group->timing = timing;
+
+    convertTiming(&group->delay, timing);
+
+    // group_writeSlot() releases '1' pins first, then '0' pins
+    if (group->delay.write0_low < group->delay.write1_low) {
+        group->delay.write0_low = group->delay.write1_low;
+    }
+}
+
+
+//! \brief reset all buses of a group
+//! \param group bus group
+//! \return mask of buses where a slave answered
+//!
+uint8_t onewire_group_reset(onewire_group_t *group) {
+    uint8_t presence;
+    uint8_t stuck;
+    uint8_t timeout = 100;
+
+    STATS_GROUP_COUNT(group, resets, 1);
+
+    // wait until every line is released by slaves
+    while ((samplePins(group) & group->mask) != group->mask) {
+        if (--timeout == 0) {
+            break;
+        }
+        groupDelay(group, busTicks(ONEWIRE_US(2)));
+    }
+
+    // a shorted line would read as a presence pulse
+    stuck = ~samplePins(group) & group->mask;
+    STATS_GROUP_COUNT(group, line_timeouts, countPins(stuck));
+
+#ifdef ONEWIRE_SHORT_MASK
+    bool mask_low = group->timing->reset_low < ONEWIRE_STRETCH_RESET_LOW;
+
+    groupDelay(group, group->delay.reset_delay);
+    if (mask_low) {
+        disableInterrupts();
+    }
+    holdPins(group, group->mask);
+    groupDelay(group, group->delay.reset_low);
+    if (!mask_low) {
+        disableInterrupts();
+    }
+    releasePins(group, group->mask);
+    groupDelay(group, group->delay.presence_sample);
+    presence = ~samplePins(group) & group->mask;
+    enableInterrupts();
+    groupDelay(group, group->delay.reset_recovery);
+#else
+    disableInterrupts();
+    groupDelay(group, group->delay.reset_delay);
+    holdPins(group, group->mask);
+    groupDelay(group, group->delay.reset_low);
+    releasePins(group, group->mask);
+    groupDelay(group, group->delay.presence_sample);
+    presence = ~samplePins(group) & group->mask;
+    groupDelay(group, group->delay.reset_recovery);
+    enableInterrupts();
+#endif
+
+    presence &= ~stuck;
+    STATS_GROUP_COUNT(group, presence_failures, countPins(group->mask & ~presence & ~stuck));
+
+    return presence;
+}
+
+
+uint8_t onewire_group_selectAll(onewire_group_t *group) {
+    uint8_t presence = onewire_group_reset(group);
+
+    onewire_group_send(group, SKIP_ROM);
+
+    return presence;
+}
+
+
+uint8_t onewire_group_select(onewire_group_t *group, const uint8_t address[8][8]) {
+    uint8_t presence = onewire_group_reset(group);
+    uint8_t data[8];
+
+    onewire_group_send(group, MATCH_ROM);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        for (uint8_t pin = 0; pin < 8; pin++) {
+            data[pin] = address[pin][i];
+        }
+        onewire_group_sendEach(group, data);
+    }
+
+    return presence;
+}
+
+
+//! \brief write slot with '1' on pins of ones, '0' on the others
+//!
+static void group_writeSlot(onewire_group_t *group, uint8_t ones) {
+    uint8_t zeros = group->mask & ~ones;
+
+    disableInterrupts();
+    holdPins(group, group->mask);
+    groupDelay(group, group->delay.write1_low);
+    releasePins(group, ones);
+    groupDelay(group, group->delay.write0_low - group->delay.write1_low);
+    releasePins(group, zeros);
+    criticalEnd();
+    groupDelay(group, group->delay.write0_recovery);
+    slotEnd();
+}
+
+
+//! \brief read slot on all pins
+//!
+static uint8_t group_readSlot(onewire_group_t *group) {
+    uint8_t sample;
+
+    disableInterrupts();
+    holdPins(group, group->mask);
+    groupDelay(group, group->delay.write1_low);
+    releasePins(group, group->mask);
+    groupDelay(group, group->delay.read_sample);
+    sample = samplePins(group);
+    criticalEnd();
+    groupDelay(group, group->delay.read_recovery);
+    slotEnd();
+
+    return sample;
+}
+
+
+void onewire_group_send(onewire_group_t *group, uint8_t data) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        group_writeSlot(group, (data & (1 << bit)) ? group->mask : 0);
+    }
+}
+
+
+void onewire_group_sendEach(onewire_group_t *group, const uint8_t data[8]) {
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        uint8_t ones = 0;
+
+        for (uint8_t pin = 0; pin < 8; pin++) {
+            if (data[pin] & (1 << bit)) {
+                ones |= (1 << pin);
+            }
+        }
+        group_writeSlot(group, ones & group->mask);
+    }
+}
+
+
+void onewire_group_receive(onewire_group_t *group, uint8_t data[8]) {
+    uint8_t sample[8];
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        sample[bit] = group_readSlot(group);
+    }
+
+    // transpose 8 port samples into 8 bytes, one per pin
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        uint8_t byte = 0;
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            byte |= ((sample[bit] >> pin) & 0x01) << bit;
+        }
+        data[pin] = byte;
+    }
+}
+
+
+void onewire_group_receiveBuffer(onewire_group_t *group, void *buffer, uint16_t len) {
+    uint8_t *data = (uint8_t*)buffer;
+    uint8_t byte[8];
+
+    for (uint16_t i = 0; i < len; i++) {
+        onewire_group_receive(group, byte);
+
+        for (uint8_t pin = 0; pin < 8; pin++) {
+            data[pin * len + i] = byte[pin];
+        }
+    }
+}
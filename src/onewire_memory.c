@@ -0,0 +1,346 @@
+//! \file onewire_memory.c
+//! \brief EEPROM memory devices on 1-wire bus: DS2431, DS2433, DS28EC20
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 25
+
+#include "onewire_memory.h"
+#include "onewire_crc.h"
+
+
+const onewire_memory_t onewire_memory_ds2431 = {
+    .size       = 128,
+    .page       = 8,
+    .extended   = 0,
+    .resume     = true,
+    .program    = 10,
+    .strong     = false,
+};
+
+const onewire_memory_t onewire_memory_ds2433 = {
+    .size       = 512,
+    .page       = 32,
+    .extended   = 0,
+    .resume     = false,
+    .program    = 5,
+    .strong     = true,
+};
+
+const onewire_memory_t onewire_memory_ds28ec20 = {
+    .size       = 2560,
+    .page       = 32,
+    .extended   = ONEWIRE_MEMORY_EXTENDED_READ,
+    .resume     = true,
+    .program    = 10,
+    .strong     = true,
+};
+
+
+//! destination of onewire_memory_readBuffer()
+typedef struct memory_buffer {
+    uint8_t *data;
+    uint16_t offset;
+} memory_buffer_t;
+
+
+static bool memory_select(onewire_bus_t *bus, const uint8_t *address,
+                        const onewire_memory_t *model, bool *matched);
+static uint8_t memory_stream(onewire_bus_t *bus, const uint8_t *address,
+                            const onewire_memory_t *model, uint16_t *offset, uint16_t *len,
+                            bool (*sink)(void *context, uint16_t offset,
+                                        const uint8_t *data, uint8_t len),
+                            void *context, bool *matched);
+static bool memory_store(void *context, uint16_t offset, const uint8_t *data, uint8_t len);
+static uint8_t memory_writePage(onewire_bus_t *bus, const uint8_t *address,
+                                const onewire_memory_t *model, uint16_t start,
+                                const uint8_t *page, bool *matched);
+static uint8_t memory_copyPage(onewire_bus_t *bus, const uint8_t *address,
+                                const onewire_memory_t *model, uint16_t start, bool *matched);
+
+
+//! \brief read memory into a sink, one page at a time
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param model memory organization
+//! \param offset first byte
+//! \param len number of bytes
+//! \param sink receives the data, returns false to stop the read
+//! \param context first argument of sink
+//! \return ONEWIRE_OK or the error of the last attempt
+//!
+uint8_t onewire_memory_read(onewire_bus_t *bus, const uint8_t *address,
+                            const onewire_memory_t *model, uint16_t offset, uint16_t len,
+                            bool (*sink)(void *context, uint16_t offset,
+                                        const uint8_t *data, uint8_t len),
+                            void *context)
+{
+    uint8_t retries = ONEWIRE_MEMORY_RETRIES;
+    bool matched = false;
+    uint8_t status;
+
+    if (len > model->size || offset > model->size - len) {
+        return ONEWIRE_RANGE_ERROR;
+    }
+
+    // an error restarts the read at the page that failed
+    for (;;) {
+        status = memory_stream(bus, address, model, &offset, &len, sink, context, &matched);
+
+        if (status == ONEWIRE_OK || retries == 0) {
+            return status;
+        }
+
+        retries--;
+        ONEWIRE_STATS_COUNT(bus, retries);
+    }
+}
+
+
+//! \brief read memory into a buffer
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param model memory organization
+//! \param offset first byte
+//! \param buffer receive buffer
+//! \param len the size of buffer
+//! \return ONEWIRE_OK or the error of the last attempt
+//!
+uint8_t onewire_memory_readBuffer(onewire_bus_t *bus, const uint8_t *address,
+                                const onewire_memory_t *model, uint16_t offset,
+                                void *buffer, uint16_t len)
+{
+    memory_buffer_t destination = {(uint8_t*)buffer, offset};
+
+    return onewire_memory_read(bus, address, model, offset, len, memory_store, &destination);
+}
+
+
+//! \brief write memory, page by page
+//! \param bus bus handle
+//! \param address slave's address, NULL for SKIP ROM
+//! \param model memory organization
+//! \param offset first byte
+//! \param buffer data to write
+//! \param len the size of buffer
+//! \return ONEWIRE_OK or the error of the last attempt on the failed page
+//!
+uint8_t onewire_memory_write(onewire_bus_t *bus, const uint8_t *address,
+                            const onewire_memory_t *model, uint16_t offset,
+                            const void *buffer, uint16_t len)
+{
+    const uint8_t *data = (const uint8_t*)buffer;
+    uint8_t page[ONEWIRE_MEMORY_PAGE_MAX];
+    bool matched = false;
+    uint8_t status;
+
+    if (len > model->size || offset > model->size - len) {
+        return ONEWIRE_RANGE_ERROR;
+    }
+
+    while (len > 0) {
+        uint16_t start = offset - offset % model->page;
+        uint8_t first = offset - start;
+        uint8_t count = model->page - first;
+
+        if (count > len) {
+            count = len;
+        }
+
+        // the scratchpad CRC only comes at its end, keep the rest of the page
+        if (count < model->page) {
+            status = onewire_memory_readBuffer(bus, address, model, start, page, model->page);
+            if (status != ONEWIRE_OK) {
+                return status;
+            }
+        }
+
+        for (uint8_t i = 0; i < count; i++) {
+            page[first + i] = data[i];
+        }
+
+        status = memory_writePage(bus, address, model, start, page, &matched);
+        if (status != ONEWIRE_OK) {
+            return status;
+        }
+
+        offset += count;
+        data += count;
+        len -= count;
+    }
+
+    return ONEWIRE_OK;
+}
+
+
+//! \brief reset and address the device, RESUME once it has been matched
+//! \return false if no slave answered the reset
+//!
+bool memory_select(onewire_bus_t *bus, const uint8_t *address,
+                    const onewire_memory_t *model, bool *matched)
+{
+    if (!onewire_reset(bus)) {
+        return false;
+    }
+
+    if (!address) {
+        onewire_send(bus, SKIP_ROM);
+    }
+    else if (*matched && model->resume) {
+        onewire_send(bus, RESUME);
+    }
+    else {
+        onewire_send(bus, MATCH_ROM);
+        onewire_sendBuffer(bus, address, 8);
+        *matched = true;
+    }
+
+    return true;
+}
+
+
+//! \brief one Read Memory command from offset, as far as it goes right
+//! \param offset advanced past the data handed to sink
+//! \param len decreased by the data handed to sink
+//!
+uint8_t memory_stream(onewire_bus_t *bus, const uint8_t *address,
+                    const onewire_memory_t *model, uint16_t *offset, uint16_t *len,
+                    bool (*sink)(void *context, uint16_t offset,
+                                const uint8_t *data, uint8_t len),
+                    void *context, bool *matched)
+{
+    uint8_t command[3];
+    uint8_t chunk[ONEWIRE_MEMORY_PAGE_MAX + 2];
+    uint16_t crc;
+
+    command[0] = model->extended ? model->extended : ONEWIRE_MEMORY_READ;
+    command[1] = *offset & 0xFF;
+    command[2] = *offset >> 8;
+
+    if (!memory_select(bus, address, model, matched)) {
+        return ONEWIRE_NO_PRESENCE;
+    }
+
+    onewire_sendBuffer(bus, command, 3);
+    crc = crc16(0, command, 3);
+
+    while (*len > 0) {
+        uint8_t count = model->page - *offset % model->page;
+        uint8_t used = count;
+
+        if (used > *len) {
+            used = *len;
+        }
+
+        if (model->extended) {
+            // the CRC-16 follows the end of each page
+            onewire_receiveBuffer(bus, chunk, count + 2);
+            crc = crc16(crc, chunk, count);
+
+            if (!crc16_check(crc, &chunk[count])) {
+                ONEWIRE_STATS_COUNT(bus, crc_failures);
+                return ONEWIRE_CRC_ERROR;
+            }
+            crc = 0;
+        }
+        else {
+            onewire_receiveBuffer(bus, chunk, used);
+        }
+
+        if (!sink(context, *offset, chunk, used)) {
+            *len = 0;
+            break;
+        }
+
+        *offset += used;
+        *len -= used;
+    }
+
+    return ONEWIRE_OK;
+}
+
+
+bool memory_store(void *context, uint16_t offset, const uint8_t *data, uint8_t len) {
+    memory_buffer_t *destination = (memory_buffer_t*)context;
+
+    for (uint8_t i = 0; i < len; i++) {
+        destination->data[offset - destination->offset + i] = data[i];
+    }
+
+    return true;
+}
+
+
+//! \brief write a whole page through the scratchpad
+//!
+uint8_t memory_writePage(onewire_bus_t *bus, const uint8_t *address,
+                        const onewire_memory_t *model, uint16_t start,
+                        const uint8_t *page, bool *matched)
+{
+    uint8_t command[3] = {ONEWIRE_MEMORY_WRITE_SCRATCHPAD, start & 0xFF, start >> 8};
+    uint8_t retries = ONEWIRE_MEMORY_RETRIES;
+    uint8_t received[2];
+    uint8_t status;
+    uint16_t crc;
+
+    for (;;) {
+        if (!memory_select(bus, address, model, matched)) {
+            status = ONEWIRE_NO_PRESENCE;
+        }
+        else {
+            onewire_sendBuffer(bus, command, 3);
+            onewire_sendBuffer(bus, page, model->page);
+            onewire_receiveBuffer(bus, received, 2);
+
+            // the device checks what it received, the copy follows if it matches
+            crc = crc16(crc16(0, command, 3), page, model->page);
+
+            if (received[0] == 0xFF && received[1] == 0xFF) {
+                status = ONEWIRE_NO_RESPONSE;
+            }
+            else if (!crc16_check(crc, received)) {
+                ONEWIRE_STATS_COUNT(bus, crc_failures);
+                status = ONEWIRE_CRC_ERROR;
+            }
+            else {
+                status = memory_copyPage(bus, address, model, start, matched);
+            }
+        }
+
+        if (status == ONEWIRE_OK || retries == 0) {
+            return status;
+        }
+
+        retries--;
+        ONEWIRE_STATS_COUNT(bus, retries);
+    }
+}
+
+
+//! \brief copy the scratchpad written with a whole page, wait for programming
+//!
+//! The device ignores the line while it programs, parasite-powered ones
+//! draw their current from it; no slot may run before tPROG has passed.
+//!
+uint8_t memory_copyPage(onewire_bus_t *bus, const uint8_t *address,
+                        const onewire_memory_t *model, uint16_t start, bool *matched)
+{
+    // authorization: target address and E/S, ending offset at the page end
+    uint8_t command[4] = {
+        ONEWIRE_MEMORY_COPY_SCRATCHPAD, start & 0xFF, start >> 8, model->page - 1
+    };
+    uint8_t data;
+
+    if (!memory_select(bus, address, model, matched)) {
+        return ONEWIRE_NO_PRESENCE;
+    }
+
+    onewire_sendBuffer(bus, command, 4);
+    onewire_idle(bus, model->program, model->strong);
+
+    // alternating 1 and 0 once programmed, all ones if the copy was refused
+    data = onewire_receive(bus);
+    if (data != 0xAA && data != 0x55) {
+        return ONEWIRE_PROGRAM_ERROR;
+    }
+
+    return ONEWIRE_OK;
+}
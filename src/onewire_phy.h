@@ -0,0 +1,59 @@
+//! \file onewire_phy.h
+//! \brief Select the 1-wire physical layer of the target platform
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 9
+//!
+//! Every physical layer provides the same set of static inline hooks, so
+//! that the protocol code in onewire.c compiles to direct register accesses:
+//!
+//! - holdBus(bus), releaseBus(bus), sampleBus(bus)
+//! - disableInterrupts(), enableInterrupts()
+//! - busTicks(time): convert tenths of microsecond to delay units
+//! - busDelay(bus, ticks): busy-wait for a number of delay units
+//! - holdPins(group, mask), releasePins(group, mask), samplePins(group)
+//! - groupDelay(group, ticks)
+//!
+//! Slots mask interrupts from their falling edge. With ONEWIRE_SHORT_MASK
+//! they are unmasked again at criticalEnd(), right after the low pulse
+//! or the sample point, and recovery time stays interruptible. Otherwise
+//! they are unmasked at slotEnd(), after recovery.
+
+#ifndef __ONEWIRE_PHY__
+#define __ONEWIRE_PHY__
+
+#if defined(__AVR__)
+#include "onewire_phy_avr.h"
+#elif defined(ONEWIRE_HOST)
+#include "onewire_phy_host.h"
+#else
+#include "onewire_phy_tiva.h"
+#endif
+
+
+#ifdef ONEWIRE_SHORT_MASK
+#define criticalEnd()       enableInterrupts()
+#define slotEnd()
+#else
+#define criticalEnd()
+#define slotEnd()           enableInterrupts()
+#endif
+
+
+//! \brief convert a timing profile to delay units of the platform
+//! \param delay converted profile
+//! \param timing timing profile
+//!
+static inline void convertTiming(onewire_timing_t *delay, const onewire_timing_t *timing) {
+    delay->write1_low = busTicks(timing->write1_low);
+    delay->write1_recovery = busTicks(timing->write1_recovery);
+    delay->write0_low = busTicks(timing->write0_low);
+    delay->write0_recovery = busTicks(timing->write0_recovery);
+    delay->read_sample = busTicks(timing->read_sample);
+    delay->read_recovery = busTicks(timing->read_recovery);
+    delay->reset_delay = busTicks(timing->reset_delay);
+    delay->reset_low = busTicks(timing->reset_low);
+    delay->presence_sample = busTicks(timing->presence_sample);
+    delay->reset_recovery = busTicks(timing->reset_recovery);
+}
+
+#endif
@@ -0,0 +1,94 @@
+//! \file onewire_phy_avr.h
+//! \brief 1-wire physical layer for AVR, GPIO bit-banging
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 9
+
+#ifndef __ONEWIRE_PHY_AVR__
+#define __ONEWIRE_PHY_AVR__
+
+#include "onewire.h"
+#include "onewire_group.h"
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay_basic.h>
+
+
+static inline void holdBus(const onewire_bus_t *bus) {
+    // config GPIO pin as OUTPUT with LOW signal, pull-up off first so
+    // that the pin never drives the line high
+    *(bus->pin.port) &= ~(1 << bus->pin.pin);
+    *(bus->pin.ddr) |= (1 << bus->pin.pin);
+}
+
+
+static inline void releaseBus(const onewire_bus_t *bus) {
+    // config GPIO pin as INPUT w/ PULL-UP
+    *(bus->pin.ddr) &= ~(1 << bus->pin.pin);
+    *(bus->pin.port) |= (1 << bus->pin.pin);
+}
+
+
+static inline uint8_t sampleBus(const onewire_bus_t *bus) {
+    return (*(bus->pin.value) & (1 << bus->pin.pin)) ? 1 : 0;
+}
+
+
+static inline void disableInterrupts(void) {
+    cli();
+}
+
+
+static inline void enableInterrupts(void) {
+    sei();
+}
+
+
+//! \brief convert tenths of microsecond to _delay_loop_2() iterations
+//!
+//! One iteration takes 4 CPU cycles. The conversion is folded at compile
+//! time for constant arguments, otherwise it is done once per profile by
+//! onewire_setTiming().
+//!
+static inline uint16_t busTicks(uint16_t time) {
+    return ((uint32_t)time * (F_CPU / 10000UL) + 2000) / 4000;
+}
+
+
+static inline void busDelay(const onewire_bus_t *bus, uint16_t ticks) {
+    (void)bus;
+
+    // _delay_loop_2(0) would spin 65536 times
+    if (ticks) {
+        _delay_loop_2(ticks);
+    }
+}
+
+
+
+static inline void holdPins(const onewire_group_t *group, uint8_t mask) {
+    *(group->port.port) &= ~mask;
+    *(group->port.ddr) |= mask;
+}
+
+
+static inline void releasePins(const onewire_group_t *group, uint8_t mask) {
+    *(group->port.ddr) &= ~mask;
+    *(group->port.port) |= mask;
+}
+
+
+static inline uint8_t samplePins(const onewire_group_t *group) {
+    return *(group->port.value);
+}
+
+
+static inline void groupDelay(const onewire_group_t *group, uint16_t ticks) {
+    (void)group;
+
+    if (ticks) {
+        _delay_loop_2(ticks);
+    }
+}
+
+#endif
@@ -0,0 +1,88 @@
+//! \file onewire_phy_host.h
+//! \brief 1-wire physical layer for the host, bit-banging a simulated line
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 16
+
+#ifndef __ONEWIRE_PHY_HOST__
+#define __ONEWIRE_PHY_HOST__
+
+#include "onewire.h"
+#include "onewire_group.h"
+#include "onewire_sim.h"
+
+
+static inline void holdBus(const onewire_bus_t *bus) {
+    onewire_sim_drive(bus->pin, true);
+}
+
+
+static inline void releaseBus(const onewire_bus_t *bus) {
+    onewire_sim_drive(bus->pin, false);
+}
+
+
+static inline uint8_t sampleBus(const onewire_bus_t *bus) {
+    return onewire_sim_sample(bus->pin);
+}
+
+
+static inline void disableInterrupts(void) {
+}
+
+
+static inline void enableInterrupts(void) {
+}
+
+
+//! \brief delay units are tenths of microsecond already
+//!
+static inline uint16_t busTicks(uint16_t time) {
+    return time;
+}
+
+
+static inline void busDelay(const onewire_bus_t *bus, uint16_t ticks) {
+    onewire_sim_advance(bus->pin, (uint32_t)ticks * 100);
+}
+
+
+
+static inline void holdPins(const onewire_group_t *group, uint8_t mask) {
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        if (mask & (1 << pin)) {
+            onewire_sim_drive(group->port[pin], true);
+        }
+    }
+}
+
+
+static inline void releasePins(const onewire_group_t *group, uint8_t mask) {
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        if (mask & (1 << pin)) {
+            onewire_sim_drive(group->port[pin], false);
+        }
+    }
+}
+
+
+static inline uint8_t samplePins(const onewire_group_t *group) {
+    uint8_t sample = 0;
+
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        if (group->mask & (1 << pin)) {
+            sample |= onewire_sim_sample(group->port[pin]) << pin;
+        }
+    }
+    return sample;
+}
+
+
+static inline void groupDelay(const onewire_group_t *group, uint16_t ticks) {
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        if (group->mask & (1 << pin)) {
+            onewire_sim_advance(group->port[pin], (uint32_t)ticks * 100);
+        }
+    }
+}
+
+#endif
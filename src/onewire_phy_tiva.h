@@ -0,0 +1,102 @@
+//! \file onewire_phy_tiva.h
+//! \brief 1-wire physical layer for Tiva C, GPIO bit-banging
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 9
+//!
+//! An edge of a bus is one store to the bit-band alias of its GPIODIR bit.
+//! bench/bench_edge_tiva.c measures it against the former driverlib calls
+//! on the target; its figures are still to be taken on a board.
+
+#ifndef __ONEWIRE_PHY_TIVA__
+#define __ONEWIRE_PHY_TIVA__
+
+#include "onewire.h"
+#include "onewire_group.h"
+
+#include <inc/hw_gpio.h>
+#include <driverlib/interrupt.h>
+
+
+// DATA of the pin is latched at 0: as an output it pulls the line low,
+// as an input it leaves it to the pull-up resistor
+static inline void holdBus(const onewire_bus_t *bus) {
+    *bus->pin.dir = 1;
+}
+
+
+static inline void releaseBus(const onewire_bus_t *bus) {
+    *bus->pin.dir = 0;
+}
+
+
+// only called with the line released, the pin is then an input
+static inline uint8_t sampleBus(const onewire_bus_t *bus) {
+    return (*bus->pin.data ? 1 : 0);
+}
+
+
+static inline void disableInterrupts(void) {
+    IntMasterDisable();
+}
+
+
+static inline void enableInterrupts(void) {
+    IntMasterEnable();
+}
+
+
+//! \brief convert tenths of microsecond to CPU cycles
+//!
+//! Fits 16 bits for every profile up to 80 MHz.
+//!
+static inline uint16_t busTicks(uint16_t time) {
+    return ((uint32_t)time * timebase_us + 5) / 10;
+}
+
+
+static inline void busDelay(const onewire_bus_t *bus, uint16_t ticks) {
+    (void)bus;
+
+    delay_cycles(ticks);
+}
+
+
+
+//! \brief DATA register alias that only reads pins in mask
+//!
+static inline volatile uint32_t *groupData(const onewire_group_t *group, uint8_t mask) {
+    return (volatile uint32_t *)(uintptr_t)(group->port.base + GPIO_O_DATA + ((uint32_t)mask << 2));
+}
+
+
+//! \brief GPIODIR register of the port of a group
+//!
+static inline volatile uint32_t *groupDir(const onewire_group_t *group) {
+    return (volatile uint32_t *)(uintptr_t)(group->port.base + GPIO_O_DIR);
+}
+
+
+// several pins change at once, GPIODIR is read-modify-written; slots
+// run with interrupts masked, nothing else may touch it meanwhile
+static inline void holdPins(const onewire_group_t *group, uint8_t mask) {
+    *groupDir(group) |= mask;
+}
+
+
+static inline void releasePins(const onewire_group_t *group, uint8_t mask) {
+    *groupDir(group) &= ~(uint32_t)mask;
+}
+
+
+static inline uint8_t samplePins(const onewire_group_t *group) {
+    return *groupData(group, group->mask);
+}
+
+
+static inline void groupDelay(const onewire_group_t *group, uint16_t ticks) {
+    (void)group;
+
+    delay_cycles(ticks);
+}
+
+#endif
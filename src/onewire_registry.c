@@ -0,0 +1,247 @@
+//! \file onewire_registry.c
+//! \brief Sorted registry of slave addresses, 7 bytes per slave
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 22
+
+#include "onewire_registry.h"
+#include "onewire_crc.h"
+
+#if defined(__AVR__)
+#define readEntry(registry, index, byte)    ((registry)->flash \
+            ? pgm_read_byte(&(registry)->entries[index][byte]) \
+            : (registry)->entries[index][byte])
+#else
+#define readEntry(registry, index, byte)    ((registry)->entries[index][byte])
+#endif
+
+
+static int8_t registry_compare(const onewire_registry_t *registry, uint8_t index,
+                                const uint8_t *address, uint8_t len);
+static uint8_t registry_lowerBound(const onewire_registry_t *registry,
+                                    const uint8_t *address, uint8_t len);
+
+
+//! \brief initialize an empty registry in RAM
+//! \param registry address registry
+//! \param entries storage for entries
+//! \param capacity size of entries
+//!
+void onewire_registry_init(onewire_registry_t *registry,
+                            uint8_t entries[][ONEWIRE_REGISTRY_ENTRY], uint8_t capacity)
+{
+    registry->entries = (const uint8_t (*)[ONEWIRE_REGISTRY_ENTRY])entries;
+    registry->count = 0;
+    registry->capacity = capacity;
+    registry->flash = false;
+}
+
+
+//! \brief initialize a read-only registry from a table in flash
+//! \param registry address registry
+//! \param entries table declared with ONEWIRE_REGISTRY_FLASH, in registry order
+//! \param count size of entries
+//!
+void onewire_registry_initFlash(onewire_registry_t *registry,
+                                const uint8_t entries[][ONEWIRE_REGISTRY_ENTRY],
+                                uint8_t count)
+{
+    registry->entries = entries;
+    registry->count = count;
+    registry->capacity = count;
+    registry->flash = true;
+}
+
+
+//! \brief add an address
+//! \param registry address registry
+//! \param address slave's address, 8 bytes
+//! \return false if the CRC is wrong, the registry is full or read-only
+//!
+bool onewire_registry_add(onewire_registry_t *registry, const uint8_t *address) {
+    uint8_t (*entries)[ONEWIRE_REGISTRY_ENTRY];
+    uint8_t index;
+
+    if (registry->flash || crc8(0, address, 8) != 0) {
+        return false;
+    }
+
+    if (onewire_registry_find(registry, address) >= 0) {
+        return true;
+    }
+
+    if (registry->count == registry->capacity) {
+        return false;
+    }
+
+    index = registry_lowerBound(registry, address, ONEWIRE_REGISTRY_ENTRY);
+    entries = (uint8_t (*)[ONEWIRE_REGISTRY_ENTRY])registry->entries;
+
+    for (uint8_t i = registry->count; i > index; i--) {
+        for (uint8_t j = 0; j < ONEWIRE_REGISTRY_ENTRY; j++) {
+            entries[i][j] = entries[i - 1][j];
+        }
+    }
+
+    for (uint8_t j = 0; j < ONEWIRE_REGISTRY_ENTRY; j++) {
+        entries[index][j] = address[j];
+    }
+
+    registry->count++;
+    return true;
+}
+
+
+//! \brief remove an address
+//! \param registry address registry
+//! \param address slave's address, CRC byte ignored
+//! \return true if it was registered
+//!
+bool onewire_registry_remove(onewire_registry_t *registry, const uint8_t *address) {
+    uint8_t (*entries)[ONEWIRE_REGISTRY_ENTRY];
+    int16_t index = onewire_registry_find(registry, address);
+
+    if (registry->flash || index < 0) {
+        return false;
+    }
+
+    entries = (uint8_t (*)[ONEWIRE_REGISTRY_ENTRY])registry->entries;
+    registry->count--;
+
+    for (uint8_t i = index; i < registry->count; i++) {
+        for (uint8_t j = 0; j < ONEWIRE_REGISTRY_ENTRY; j++) {
+            entries[i][j] = entries[i + 1][j];
+        }
+    }
+
+    return true;
+}
+
+
+//! \brief look up an address
+//! \param registry address registry
+//! \param address slave's address, CRC byte ignored
+//! \return index of its entry, -1 if not registered
+//!
+int16_t onewire_registry_find(const onewire_registry_t *registry, const uint8_t *address) {
+    uint8_t index = registry_lowerBound(registry, address, ONEWIRE_REGISTRY_ENTRY);
+
+    if (index == registry->count) {
+        return -1;
+    }
+
+    if (registry_compare(registry, index, address, ONEWIRE_REGISTRY_ENTRY) != 0) {
+        return -1;
+    }
+
+    return index;
+}
+
+
+//! \brief get the address of an entry
+//! \param registry address registry
+//! \param index entry index, below registry->count
+//! \param address slave's address, 8 bytes with its CRC
+//!
+void onewire_registry_get(const onewire_registry_t *registry, uint8_t index, uint8_t *address) {
+    for (uint8_t j = 0; j < ONEWIRE_REGISTRY_ENTRY; j++) {
+        address[j] = readEntry(registry, index, j);
+    }
+
+    address[ONEWIRE_REGISTRY_ENTRY] = crc8(0, address, ONEWIRE_REGISTRY_ENTRY);
+}
+
+
+//! \brief find the entries of a family
+//! \param registry address registry
+//! \param family_code family code, first byte of address
+//! \param first index of the first entry of the family
+//! \return number of entries of the family, contiguous from first
+//!
+uint8_t onewire_registry_family(const onewire_registry_t *registry, uint8_t family_code,
+                                uint8_t *first)
+{
+    uint8_t next = family_code + 1;
+    uint8_t end = registry->count;
+
+    *first = registry_lowerBound(registry, &family_code, 1);
+
+    if (family_code != 0xFF) {
+        end = registry_lowerBound(registry, &next, 1);
+    }
+
+    return end - *first;
+}
+
+
+//! \brief replace the entries with the slaves found by a search
+//! \param bus bus handle
+//! \param registry address registry in RAM
+//! \return number of addresses registered
+//!
+uint8_t onewire_registry_scan(onewire_bus_t *bus, onewire_registry_t *registry) {
+    uint8_t address[8];
+
+    if (registry->flash) {
+        return 0;
+    }
+
+    registry->count = 0;
+    onewire_searchStart(bus);
+
+    // as many passes as onewire_search() with an address_box of the same size
+    for (uint8_t i = 0; i < registry->capacity; i++) {
+        int8_t status = onewire_searchNext(bus, address);
+
+        if (status == 0) {
+            break;
+        }
+
+        if (status == 1) {
+            onewire_registry_add(registry, address);
+        }
+    }
+
+    return registry->count;
+}
+
+
+//! \brief compare an entry with the first len bytes of an address
+//! \return negative, 0 or positive as the entry sorts before, with or after it
+//!
+int8_t registry_compare(const onewire_registry_t *registry, uint8_t index,
+                        const uint8_t *address, uint8_t len)
+{
+    for (uint8_t j = 0; j < len; j++) {
+        uint8_t entry = readEntry(registry, index, j);
+
+        if (entry != address[j]) {
+            return entry < address[j] ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+
+//! \brief index of the first entry not sorting before an address
+//! \param len number of key bytes compared, 1 for the family code only
+//!
+uint8_t registry_lowerBound(const onewire_registry_t *registry,
+                            const uint8_t *address, uint8_t len)
+{
+    uint8_t low = 0;
+    uint8_t high = registry->count;
+
+    while (low < high) {
+        uint8_t middle = low + (high - low) / 2;
+
+        if (registry_compare(registry, middle, address, len) < 0) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
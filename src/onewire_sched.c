@@ -0,0 +1,342 @@
+//! \file onewire_sched.c
+//! \brief Deadline-driven polling of many slaves across buses
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 18
+
+#include "onewire_sched.h"
+
+#include <stddef.h>
+
+
+//! time a is at or after time b, modulo 2^32
+#define REACHED(a, b)   ((int32_t)((a) - (b)) >= 0)
+
+
+static bool sched_isBusy(const onewire_sched_t *sched, const onewire_sched_task_t *task,
+                        uint32_t now, uint32_t *ready);
+static void sched_start(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t now);
+static void sched_read(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t now);
+static void sched_convert(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t now);
+
+
+//! \brief initialize a scheduler without tasks
+//! \param sched scheduler
+//! \param clock returns the current time in milliseconds
+//! \param context argument of clock
+//! \param window a broadcast also starts conversions due within window ms
+//!
+void onewire_sched_init(onewire_sched_t *sched, uint32_t (*clock)(void *context),
+                        void *context, uint16_t window)
+{
+    sched->tasks = NULL;
+    sched->clock = clock;
+    sched->context = context;
+    sched->window = window;
+    sched->retries = 1;
+
+    sched->stats.conversions = 0;
+    sched->stats.broadcasts = 0;
+    sched->stats.reads = 0;
+    sched->stats.failures = 0;
+    sched->stats.missed = 0;
+    sched->stats.jitter_sum = 0;
+    sched->stats.jitter_max = 0;
+}
+
+
+//! \brief add a task
+//! \param sched scheduler
+//! \param task task with its application fields set
+//! \param start time of the first sample
+//!
+void onewire_sched_add(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t start) {
+    task->release = start;
+    task->deadline = start;
+    task->ready = start;
+    task->converting = false;
+    task->pending = false;
+    task->missed = 0;
+    task->jitter = 0;
+
+    task->next = sched->tasks;
+    sched->tasks = task;
+}
+
+
+//! \brief remove a task
+//! \param sched scheduler
+//! \param task task added to the scheduler
+//!
+void onewire_sched_remove(onewire_sched_t *sched, onewire_sched_task_t *task) {
+    for (onewire_sched_task_t **link = &sched->tasks; *link; link = &(*link)->next) {
+        if (*link == task) {
+            *link = task->next;
+            task->next = NULL;
+            break;
+        }
+    }
+}
+
+
+//! \brief run the bus operation with the earliest deadline
+//! \param sched scheduler
+//! \return 0 if an operation was run, otherwise time until the next one, ms
+//!
+//! Without tasks, UINT32_MAX is returned.
+//!
+uint32_t onewire_sched_run(onewire_sched_t *sched) {
+    uint32_t now = sched->clock(sched->context);
+    onewire_sched_task_t *next = NULL;
+    uint32_t next_deadline = 0;
+    uint32_t wait = UINT32_MAX;
+
+    // earliest deadline first among conversions due and results ready
+    for (onewire_sched_task_t *task = sched->tasks; task; task = task->next) {
+        uint32_t event = task->converting ? task->ready : task->release;
+        uint32_t deadline = task->deadline;
+
+        // a conversion must start early enough to be read in time
+        if (!task->converting) {
+            deadline = task->release + task->period - task->conversion;
+        }
+
+        // the previous result can be read until the conversion ends
+        if (task->pending) {
+            event = now;
+            deadline = task->previous;
+        }
+
+        // waits for the next broadcast
+        if (!task->converting && task->convert) {
+            sched_isBusy(sched, task, now, &event);
+        }
+
+        if (!REACHED(now, event)) {
+            if (event - now < wait) {
+                wait = event - now;
+            }
+            continue;
+        }
+
+        if (!next || !REACHED(deadline, next_deadline)) {
+            next = task;
+            next_deadline = deadline;
+        }
+    }
+
+    if (!next) {
+        return wait;
+    }
+
+    if (next->converting) {
+        sched_read(sched, next, now);
+    }
+    else if (next->convert) {
+        sched_convert(sched, next, now);
+    }
+    else {
+        sched_start(sched, next, now);
+        sched_read(sched, next, now);
+    }
+
+    return 0;
+}
+
+
+//! \brief conversions are running on a broadcast bus
+//! \param ready set to the end of the last one if so
+//!
+//! Results stay readable until the end of the next conversion, as with
+//! DS18B20, so a broadcast can start while the previous ones are read.
+//!
+bool sched_isBusy(const onewire_sched_t *sched, const onewire_sched_task_t *task,
+                uint32_t now, uint32_t *ready)
+{
+    bool busy = false;
+
+    for (const onewire_sched_task_t *other = sched->tasks; other; other = other->next) {
+        if (other->bus != task->bus) {
+            continue;
+        }
+
+        // tasks converting alone do not wait for each other
+        if (other->convert != task->convert) {
+            return false;
+        }
+
+        if (!other->converting || REACHED(now, other->ready)) {
+            continue;
+        }
+
+        if (!busy || !REACHED(*ready, other->ready)) {
+            *ready = other->ready;
+        }
+        busy = true;
+    }
+
+    return busy;
+}
+
+
+//! \brief begin the sample of a task due at or before now + window
+//!
+void sched_start(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t now) {
+    uint32_t delay = 0;
+
+    if (REACHED(now, task->release)) {
+        delay = now - task->release;
+    }
+
+    // samples whose whole period has passed are skipped
+    while (delay >= task->period) {
+        delay -= task->period;
+        task->release += task->period;
+        task->missed++;
+        sched->stats.missed++;
+    }
+
+    if (delay > UINT16_MAX) {
+        delay = UINT16_MAX;
+    }
+
+    if (delay > task->jitter) {
+        task->jitter = delay;
+    }
+
+    if (delay > sched->stats.jitter_max) {
+        sched->stats.jitter_max = delay;
+    }
+
+    sched->stats.jitter_sum += delay;
+
+    // samples keep their phase, a late one does not delay the next ones
+    task->deadline = task->release + task->period;
+    task->release = task->deadline;
+}
+
+
+//! \brief read the result of a task and account its deadline
+//!
+void sched_read(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t now) {
+    uint32_t deadline = task->deadline;
+    bool previous = false;
+    uint8_t status;
+    uint32_t end;
+
+    if (task->pending) {
+        task->pending = false;
+        previous = !REACHED(now, task->ready);
+
+        // overwritten by the next result, this sample is lost
+        if (previous) {
+            deadline = task->previous;
+        }
+        else {
+            task->missed++;
+            sched->stats.missed++;
+        }
+    }
+
+    status = onewire_transfer(task->bus, task->address, &task->read, 1,
+                            task->data, task->len, task->check, sched->retries);
+    end = sched->clock(sched->context);
+
+    // the running conversion is still to be read
+    if (!previous) {
+        task->converting = false;
+    }
+
+    sched->stats.reads++;
+
+    if (status != ONEWIRE_OK) {
+        sched->stats.failures++;
+    }
+
+    if (!REACHED(deadline, end)) {
+        task->missed++;
+        sched->stats.missed++;
+    }
+
+    if (task->done) {
+        task->done(task, status);
+    }
+}
+
+
+//! \brief all tasks of the bus share the command
+//!
+static bool sched_canBroadcast(const onewire_sched_t *sched, const onewire_sched_task_t *task) {
+    for (const onewire_sched_task_t *other = sched->tasks; other; other = other->next) {
+        if (other->bus == task->bus && other->convert != task->convert) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//! \brief start the conversion of a task, with others of its bus if possible
+//!
+void sched_convert(onewire_sched_t *sched, onewire_sched_task_t *task, uint32_t now) {
+    bool broadcast = sched_canBroadcast(sched, task);
+    bool presence;
+    uint32_t end;
+
+    if (broadcast) {
+        presence = onewire_selectAll(task->bus);
+    }
+    else {
+        presence = onewire_select(task->bus, task->address);
+    }
+
+    if (presence) {
+        onewire_send(task->bus, task->convert);
+    }
+
+    end = sched->clock(sched->context);
+
+    if (broadcast) {
+        sched->stats.broadcasts++;
+    }
+
+    for (onewire_sched_task_t *other = sched->tasks; other; other = other->next) {
+        if (broadcast && other->bus == task->bus) {
+            // conversions due soon are started early
+            if (other->converting && !REACHED(now, other->ready)) {
+                continue;
+            }
+
+            if (!REACHED(now + sched->window, other->release)) {
+                continue;
+            }
+        }
+        else if (other != task) {
+            continue;
+        }
+
+        uint32_t deadline = other->deadline;
+
+        sched_start(sched, other, now);
+
+        if (!presence) {
+            other->converting = false;
+            sched->stats.failures++;
+
+            if (other->done) {
+                other->done(other, ONEWIRE_NO_PRESENCE);
+            }
+            continue;
+        }
+
+        // a result not read yet stays readable during the conversion
+        if (other->converting) {
+            other->pending = true;
+            other->previous = deadline;
+        }
+
+        other->converting = true;
+        other->ready = end + other->conversion;
+        sched->stats.conversions++;
+    }
+}
@@ -0,0 +1,1003 @@
+//! \file onewire_sim.c
+//! \brief Host-side model of a 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 16
+
+#include "onewire_sim.h"
+#include "onewire_crc.h"
+
+#include <stddef.h>
+
+
+// slave timing in nanoseconds
+#define SIM_RESET_LOW               400000
+#define SIM_SLOT_SAMPLE             15000
+#define SIM_SEND_LOW                30000
+#define SIM_PRESENCE_WAIT           30000
+#define SIM_PRESENCE_LOW            60000
+
+#define SIM_OVERDRIVE_RESET_LOW     40000
+#define SIM_OVERDRIVE_RESET_MAX     80000
+#define SIM_OVERDRIVE_SLOT_SAMPLE   2000
+#define SIM_OVERDRIVE_SEND_LOW      3000
+#define SIM_OVERDRIVE_PRESENCE_WAIT 2000
+#define SIM_OVERDRIVE_PRESENCE_LOW  10000
+
+// ROM layer states of a device
+#define SIM_IDLE                    0
+#define SIM_ROM                     1
+#define SIM_MATCH                   2
+#define SIM_SEARCH                  3
+#define SIM_READ_ROM                4
+#define SIM_COMMAND                 5
+#define SIM_FUNCTION                6
+
+
+static void sim_uart_setBaudrate(void *context, uint32_t baudrate);
+static void sim_uart_transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len);
+static void sim_uart_delay(void *context, uint16_t ms);
+static void sim_uart_start(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                            void (*complete)(void *arg), void *arg);
+static bool sim_ds2482_write(void *context, uint8_t address, const uint8_t *data, uint8_t len);
+static bool sim_ds2482_read(void *context, uint8_t address, uint8_t *data, uint8_t len);
+static void sim_ds2482_delay(void *context, uint16_t ms);
+static void sim_timer_schedule(void *context, uint16_t time);
+static void sim_timer_stop(void *context);
+static void sim_fall(onewire_sim_t *sim);
+static void sim_rise(onewire_sim_t *sim);
+static void sim_reset(onewire_sim_t *sim, bool overdrive);
+static void sim_pullLow(onewire_sim_t *sim, uint64_t from, uint64_t until);
+static uint8_t device_send(onewire_sim_device_t *device, uint64_t now);
+static void device_slot(onewire_sim_t *sim, onewire_sim_device_t *device, uint8_t bit);
+static void device_romCommand(onewire_sim_t *sim, onewire_sim_device_t *device, uint8_t command);
+static bool device_receive(onewire_sim_device_t *device, uint8_t bit, uint8_t *data);
+
+
+//! \brief initialize a simulated line, released at time 0
+//! \param sim simulated line
+//!
+void onewire_sim_init(onewire_sim_t *sim) {
+    sim->now = 0;
+    sim->master_low = false;
+    sim->fall = 0;
+    sim->slave_low = 0;
+    sim->slave_release = 0;
+    sim->devices = NULL;
+    sim->active = NULL;
+    sim->overdrive_count = 0;
+
+    onewire_sim_clearCounters(sim);
+}
+
+
+//! \brief drive the line from the master side
+//! \param sim simulated line
+//! \param low true to pull the line low, false to release it
+//!
+void onewire_sim_drive(onewire_sim_t *sim, bool low) {
+    if (low && !sim->master_low) {
+        sim->master_low = true;
+        sim_fall(sim);
+    }
+    else if (!low && sim->master_low) {
+        sim->master_low = false;
+        sim_rise(sim);
+    }
+}
+
+
+//! \brief let virtual time pass
+//! \param sim simulated line
+//! \param ns duration in nanoseconds
+//!
+void onewire_sim_advance(onewire_sim_t *sim, uint32_t ns) {
+    sim->now += ns;
+}
+
+
+//! \brief sample the line at current virtual time
+//! \param sim simulated line
+//! \return 1 if the line is high, 0 if low
+//!
+uint8_t onewire_sim_sample(onewire_sim_t *sim) {
+    if (sim->master_low) {
+        return 0;
+    }
+
+    // master samples a short slot while a slave could answer
+    if (sim->short_slot && sim->now - sim->fall < SIM_SEND_LOW) {
+        sim->short_slot = false;
+        sim->counter.write1--;
+        sim->counter.read++;
+    }
+
+    if (sim->now >= sim->slave_low && sim->now < sim->slave_release) {
+        return 0;
+    }
+
+    return 1;
+}
+
+
+//! \brief start bus time accounting over
+//! \param sim simulated line
+//!
+void onewire_sim_clearCounters(onewire_sim_t *sim) {
+    sim->short_slot = false;
+    sim->counter_start = sim->now;
+    sim->counter.resets = 0;
+    sim->counter.write0 = 0;
+    sim->counter.write1 = 0;
+    sim->counter.read = 0;
+    sim->counter.slot_low_max = 0;
+    sim->counter.time = 0;
+}
+
+
+//! \brief read bus time spent since the last onewire_sim_clearCounters()
+//! \param sim simulated line
+//! \param counter output counters
+//!
+void onewire_sim_getCounters(const onewire_sim_t *sim, onewire_sim_counter_t *counter) {
+    *counter = sim->counter;
+    counter->time = sim->now - sim->counter_start;
+}
+
+
+//! \brief attach a virtual device to a line
+//! \param sim simulated line
+//! \param device initialized virtual device, not attached to another line
+//!
+void onewire_sim_attach(onewire_sim_t *sim, onewire_sim_device_t *device) {
+    device->state = SIM_IDLE;
+    device->overdrive = false;
+    device->next_active = NULL;
+    device->next = sim->devices;
+    sim->devices = device;
+}
+
+
+//! \brief detach a virtual device from a line
+//! \param sim simulated line
+//! \param device attached virtual device
+//!
+void onewire_sim_detach(onewire_sim_t *sim, onewire_sim_device_t *device) {
+    onewire_sim_device_t **link;
+
+    for (link = &sim->devices; *link; link = &(*link)->next) {
+        if (*link == device) {
+            *link = device->next;
+            break;
+        }
+    }
+
+    for (link = &sim->active; *link; link = &(*link)->next_active) {
+        if (*link == device) {
+            *link = device->next_active;
+            break;
+        }
+    }
+
+    if (device->overdrive) {
+        device->overdrive = false;
+        sim->overdrive_count--;
+    }
+
+    device->state = SIM_IDLE;
+    device->next = NULL;
+    device->next_active = NULL;
+}
+
+
+//! \brief initialize the ROM layer of a virtual device
+//! \param device virtual device
+//! \param model device model
+//! \param family family code
+//! \param serial 48-bit serial number
+//!
+void onewire_sim_deviceInit(onewire_sim_device_t *device, const onewire_sim_model_t *model,
+                            uint8_t family, uint64_t serial)
+{
+    device->ROM[0] = family;
+    for (uint8_t i = 1; i < 7; i++) {
+        device->ROM[i] = serial & 0xFF;
+        serial >>= 8;
+    }
+    device->ROM[7] = crc8(0, device->ROM, 7);
+
+    device->model = model;
+    device->next = NULL;
+    device->next_active = NULL;
+    device->state = SIM_IDLE;
+    device->bit_index = 0;
+    device->shift = 0;
+    device->overdrive = false;
+    device->resume = false;
+    device->reading = false;
+    device->reply_bits = 0;
+    device->reply_index = 0;
+}
+
+
+//! \brief queue bits sent by a device in the next read slots
+//! \param device virtual device
+//! \param data bits, LSB first
+//! \param bits number of bits, at most 128
+//!
+void onewire_sim_reply(onewire_sim_device_t *device, const uint8_t *data, uint8_t bits) {
+    if (bits > 8 * sizeof(device->reply)) {
+        bits = 8 * sizeof(device->reply);
+    }
+
+    for (uint8_t i = 0; i < (bits + 7) / 8; i++) {
+        device->reply[i] = data[i];
+    }
+
+    device->reply_bits = bits;
+    device->reply_index = 0;
+    device->reading = true;
+}
+
+
+static uint8_t romBit(const uint8_t *rom, uint8_t index) {
+    return (rom[index / 8] >> (index % 8)) & 0x01;
+}
+
+
+//! \brief falling edge of master: slaves sending a 0 hold the line low
+//!
+void sim_fall(onewire_sim_t *sim) {
+    sim->fall = sim->now;
+    sim->short_slot = false;
+
+    for (onewire_sim_device_t *device = sim->active; device; device = device->next_active) {
+        if (!device_send(device, sim->now)) {
+            sim_pullLow(sim, sim->now, sim->now + (device->overdrive ?
+                            SIM_OVERDRIVE_SEND_LOW : SIM_SEND_LOW));
+        }
+    }
+}
+
+
+//! \brief rising edge of master: the low time tells reset, 1 or 0
+//!
+void sim_rise(onewire_sim_t *sim) {
+    uint64_t low = sim->now - sim->fall;
+    onewire_sim_device_t **link = &sim->active;
+
+    if (low >= SIM_RESET_LOW) {
+        sim->counter.resets++;
+        sim_reset(sim, false);
+        return;
+    }
+
+    // too long for overdrive, slaves take it for a standard-speed reset
+    if (sim->overdrive_count && low > SIM_OVERDRIVE_RESET_MAX) {
+        sim->counter.resets++;
+        sim_reset(sim, false);
+        return;
+    }
+
+    if (sim->overdrive_count && low >= SIM_OVERDRIVE_RESET_LOW) {
+        sim->counter.resets++;
+        sim_reset(sim, true);
+        return;
+    }
+
+    if (low > sim->counter.slot_low_max) {
+        sim->counter.slot_low_max = low;
+    }
+
+    // counted as write-1 until the master samples the slot
+    if (low < (sim->overdrive_count ? SIM_OVERDRIVE_SLOT_SAMPLE : SIM_SLOT_SAMPLE)) {
+        sim->counter.write1++;
+        sim->short_slot = true;
+    }
+    else {
+        sim->counter.write0++;
+    }
+
+    // devices that stop listening leave the active list
+    while (*link) {
+        onewire_sim_device_t *device = *link;
+        uint8_t bit = low < (device->overdrive ? SIM_OVERDRIVE_SLOT_SAMPLE : SIM_SLOT_SAMPLE);
+
+        device_slot(sim, device, bit);
+
+        if (device->state == SIM_IDLE) {
+            *link = device->next_active;
+        }
+        else {
+            link = &device->next_active;
+        }
+    }
+}
+
+
+//! \brief reset every device, or only those at overdrive speed
+//!
+void sim_reset(onewire_sim_t *sim, bool overdrive) {
+    sim->active = NULL;
+
+    for (onewire_sim_device_t *device = sim->devices; device; device = device->next) {
+        if (overdrive && !device->overdrive) {
+            continue;
+        }
+
+        if (!overdrive && device->overdrive) {
+            device->overdrive = false;
+            sim->overdrive_count--;
+        }
+
+        device->state = SIM_ROM;
+        device->bit_index = 0;
+        device->shift = 0;
+        device->reading = false;
+        device->reply_bits = 0;
+        device->reply_index = 0;
+
+        if (device->model->reset) {
+            device->model->reset(device, sim->now);
+        }
+
+        device->next_active = sim->active;
+        sim->active = device;
+    }
+
+    if (sim->active) {
+        if (overdrive) {
+            sim_pullLow(sim, sim->now + SIM_OVERDRIVE_PRESENCE_WAIT,
+                        sim->now + SIM_OVERDRIVE_PRESENCE_WAIT + SIM_OVERDRIVE_PRESENCE_LOW);
+        }
+        else {
+            sim_pullLow(sim, sim->now + SIM_PRESENCE_WAIT,
+                        sim->now + SIM_PRESENCE_WAIT + SIM_PRESENCE_LOW);
+        }
+    }
+}
+
+
+void sim_pullLow(onewire_sim_t *sim, uint64_t from, uint64_t until) {
+    if (sim->slave_release <= sim->now) {
+        sim->slave_low = from;
+        sim->slave_release = until;
+        return;
+    }
+
+    if (from < sim->slave_low) {
+        sim->slave_low = from;
+    }
+
+    if (until > sim->slave_release) {
+        sim->slave_release = until;
+    }
+}
+
+
+//! \brief bit a device sends in the slot starting now, 1 if it stays silent
+//!
+uint8_t device_send(onewire_sim_device_t *device, uint64_t now) {
+    uint8_t bit;
+
+    switch (device->state) {
+        case SIM_SEARCH:
+            bit = romBit(device->ROM, device->bit_index);
+            if (device->shift == 0) {
+                return bit;
+            }
+            if (device->shift == 1) {
+                return !bit;
+            }
+            return 1;
+
+        case SIM_READ_ROM:
+            return romBit(device->ROM, device->bit_index);
+
+        case SIM_FUNCTION:
+            if (!device->reading) {
+                return 1;
+            }
+
+            if (device->reply_index >= device->reply_bits) {
+                device->reply_bits = 0;
+                device->reply_index = 0;
+
+                if (device->model->refill) {
+                    device->model->refill(device, now);
+                }
+            }
+
+            if (!device->reading || device->reply_index >= device->reply_bits) {
+                return 1;
+            }
+
+            bit = romBit(device->reply, device->reply_index);
+            device->reply_index++;
+            return bit;
+
+        default:
+            return 1;
+    }
+}
+
+
+//! \brief end of a slot in which master wrote bit
+//!
+void device_slot(onewire_sim_t *sim, onewire_sim_device_t *device, uint8_t bit) {
+    const onewire_sim_model_t *model = device->model;
+    uint8_t data;
+
+    switch (device->state) {
+        case SIM_ROM:
+            if (device_receive(device, bit, &data)) {
+                device_romCommand(sim, device, data);
+            }
+            break;
+
+        case SIM_MATCH:
+            if (bit != romBit(device->ROM, device->bit_index)) {
+                device->state = SIM_IDLE;
+            }
+            else if (++device->bit_index == 64) {
+                device->bit_index = 0;
+                device->resume = true;
+                device->state = SIM_COMMAND;
+            }
+            break;
+
+        case SIM_SEARCH:
+            // 2 read slots, then the direction written by master
+            if (device->shift < 2) {
+                device->shift++;
+            }
+            else if (bit != romBit(device->ROM, device->bit_index)) {
+                device->state = SIM_IDLE;
+            }
+            else {
+                device->shift = 0;
+                if (++device->bit_index == 64) {
+                    device->bit_index = 0;
+                    device->resume = true;
+                    device->state = SIM_COMMAND;
+                }
+            }
+            break;
+
+        case SIM_READ_ROM:
+            if (++device->bit_index == 64) {
+                device->bit_index = 0;
+                device->state = SIM_COMMAND;
+            }
+            break;
+
+        case SIM_COMMAND:
+            if (device_receive(device, bit, &data)) {
+                device->state = SIM_FUNCTION;
+                if (model->command) {
+                    model->command(device, data, sim->now);
+                }
+            }
+            break;
+
+        case SIM_FUNCTION:
+            if (!device->reading && device_receive(device, bit, &data) && model->receive) {
+                model->receive(device, data, sim->now);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+void device_romCommand(onewire_sim_t *sim, onewire_sim_device_t *device, uint8_t command) {
+    const onewire_sim_model_t *model = device->model;
+
+    // only a completed MATCH or search selects the device for RESUME
+    if (command == RESUME) {
+        device->state = (model->resume && device->resume) ? SIM_COMMAND : SIM_IDLE;
+        return;
+    }
+    device->resume = false;
+
+    switch (command) {
+        case ALARM_SEARCH:
+            if (model->alarm && model->alarm(device)) {
+                device->state = SIM_SEARCH;
+            }
+            else {
+                device->state = SIM_IDLE;
+            }
+            break;
+
+        case SEARCH_ROM:
+            device->state = SIM_SEARCH;
+            break;
+
+        case READ_ROM:
+            device->state = SIM_READ_ROM;
+            break;
+
+        case MATCH_ROM:
+            device->state = SIM_MATCH;
+            break;
+
+        case SKIP_ROM:
+            device->state = SIM_COMMAND;
+            break;
+
+        case OVERDRIVE_SKIP:
+        case OVERDRIVE_MATCH:
+            if (!model->overdrive) {
+                device->state = SIM_IDLE;
+                break;
+            }
+
+            if (!device->overdrive) {
+                device->overdrive = true;
+                sim->overdrive_count++;
+            }
+            device->state = (command == OVERDRIVE_SKIP) ? SIM_COMMAND : SIM_MATCH;
+            break;
+
+        default:
+            device->state = SIM_IDLE;
+            break;
+    }
+}
+
+
+//! \brief shift in a bit, LSB first
+//! \return true when a byte is complete
+//!
+bool device_receive(onewire_sim_device_t *device, uint8_t bit, uint8_t *data) {
+    if (bit) {
+        device->shift |= (1 << device->bit_index);
+    }
+
+    if (++device->bit_index < 8) {
+        return false;
+    }
+
+    *data = device->shift;
+    device->shift = 0;
+    device->bit_index = 0;
+
+    return true;
+}
+
+
+//! \brief bit-bang a bus on a simulated line
+//! \param bus bus handle
+//! \param sim simulated line
+//!
+void host_onewire_init(onewire_bus_t *bus, onewire_sim_t *sim) {
+    bus->pin = sim;
+    bus->driver = NULL;
+    bus->context = NULL;
+    bus->pullup = NULL;
+    bus->last_conflict_bit = 0;
+    bus->is_last_device_found = false;
+#ifdef ONEWIRE_STATS
+    onewire_stats_clear(bus);
+#endif
+
+    onewire_setTiming(bus, &onewire_timing_standard);
+}
+
+
+//! \brief bit-bang a group of buses on simulated lines
+//! \param group bus group
+//! \param lines 8 simulated lines, one per pin, only those in mask are used
+//! \param mask pins of the group
+//!
+void host_onewire_groupInit(onewire_group_t *group, onewire_sim_t **lines, uint8_t mask) {
+    group->port = lines;
+    group->mask = mask;
+#ifdef ONEWIRE_STATS
+    group->stats = (onewire_stats_t){0};
+#endif
+
+    onewire_group_setTiming(group, &onewire_timing_standard);
+}
+
+
+//! \brief initialize a simulated UART tied to a simulated line
+//! \param uart simulated UART
+//! \param sim simulated line
+//!
+void onewire_sim_uartInit(onewire_sim_uart_t *uart, onewire_sim_t *sim) {
+    uart->sim = sim;
+    uart->baudrate = ONEWIRE_UART_DATA_BAUDRATE;
+    uart->port.setBaudrate = sim_uart_setBaudrate;
+    uart->port.transfer = sim_uart_transfer;
+    uart->port.start = sim_uart_start;
+    uart->port.delay = sim_uart_delay;
+    uart->port.context = uart;
+    uart->complete = NULL;
+}
+
+
+//! \brief raise the interrupt ending a started transfer
+//! \param uart simulated UART
+//! \return false if no transfer was pending
+//!
+bool onewire_sim_uartInterrupt(onewire_sim_uart_t *uart) {
+    void (*complete)(void *arg) = uart->complete;
+
+    if (complete == NULL) {
+        return false;
+    }
+
+    // cleared first, the completion may start the next transfer
+    uart->complete = NULL;
+    complete(uart->complete_arg);
+
+    return true;
+}
+
+
+void sim_uart_setBaudrate(void *context, uint32_t baudrate) {
+    onewire_sim_uart_t *uart = (onewire_sim_uart_t*)context;
+
+    uart->baudrate = baudrate;
+}
+
+
+//! \brief send 8N1 frames on the line and sample each bit in its middle
+//!
+void sim_uart_transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    onewire_sim_uart_t *uart = (onewire_sim_uart_t*)context;
+    onewire_sim_t *sim = uart->sim;
+    uint32_t bit_time = 1000000000UL / uart->baudrate;
+
+    for (uint16_t i = 0; i < len; i++) {
+        // start bit, 8 data bits LSB first, stop bit
+        uint16_t frame = ((uint16_t)tx[i] << 1) | (1 << 9);
+        uint16_t echo = 0;
+
+        for (uint8_t bit = 0; bit < 10; bit++) {
+            onewire_sim_drive(sim, !(frame & (1 << bit)));
+            onewire_sim_advance(sim, bit_time / 2);
+            echo |= (uint16_t)onewire_sim_sample(sim) << bit;
+            onewire_sim_advance(sim, bit_time - bit_time / 2);
+        }
+
+        rx[i] = (uint8_t)(echo >> 1);
+    }
+}
+
+
+void sim_uart_start(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                    void (*complete)(void *arg), void *arg)
+{
+    onewire_sim_uart_t *uart = (onewire_sim_uart_t*)context;
+
+    sim_uart_transfer(context, tx, rx, len);
+
+    uart->complete = complete;
+    uart->complete_arg = arg;
+}
+
+
+void sim_uart_delay(void *context, uint16_t ms) {
+    onewire_sim_uart_t *uart = (onewire_sim_uart_t*)context;
+
+    for (uint16_t i = 0; i < ms; i++) {
+        onewire_sim_advance(uart->sim, 1000000);
+    }
+}
+
+
+//! \brief initialize a simulated DS2482 bridge on an I2C bus of its own
+//! \param bridge simulated bridge
+//! \param lines simulated line of each channel, NULL entries are left open
+//! \param channels DS2482_100_CHANNELS or DS2482_800_CHANNELS
+//! \param address 7-bit I2C address the bridge answers
+//!
+void onewire_sim_ds2482Init(onewire_sim_ds2482_t *bridge, onewire_sim_t **lines,
+                            uint8_t channels, uint8_t address)
+{
+    for (uint8_t i = 0; i < DS2482_800_CHANNELS; i++) {
+        bridge->lines[i] = (i < channels) ? lines[i] : NULL;
+    }
+
+    bridge->address = address;
+    bridge->channels = channels;
+    bridge->channel = 0;
+    bridge->pointer = DS2482_STATUS_REGISTER;
+    bridge->status = DS2482_STATUS_LL;
+    bridge->data = 0;
+    bridge->config = 0;
+    bridge->transactions = 0;
+    bridge->port.write = sim_ds2482_write;
+    bridge->port.read = sim_ds2482_read;
+    bridge->port.delay = sim_ds2482_delay;
+    bridge->port.context = bridge;
+}
+
+
+//! \brief one slot on the selected line of a bridge
+//! \return bit sampled, 1 on an open channel
+//!
+static uint8_t sim_ds2482_slot(onewire_sim_ds2482_t *bridge, uint8_t bit) {
+    onewire_sim_t *sim = bridge->lines[bridge->channel];
+    const onewire_timing_t *timing = (bridge->config & DS2482_CONFIG_1WS) ?
+                                    &onewire_timing_overdrive : &onewire_timing_standard;
+    uint8_t sample = 0;
+
+    if (!sim) {
+        return 1;
+    }
+
+    onewire_sim_drive(sim, true);
+
+    if (bit) {
+        onewire_sim_advance(sim, timing->write1_low * 100);
+        onewire_sim_drive(sim, false);
+        onewire_sim_advance(sim, timing->read_sample * 100);
+        sample = onewire_sim_sample(sim);
+        onewire_sim_advance(sim, timing->read_recovery * 100);
+    }
+    else {
+        onewire_sim_advance(sim, timing->write0_low * 100);
+        onewire_sim_drive(sim, false);
+        onewire_sim_advance(sim, timing->write0_recovery * 100);
+    }
+
+    return sample;
+}
+
+
+//! \brief reset pulse on the selected line of a bridge
+//! \return true if a slave answered
+//!
+static bool sim_ds2482_reset(onewire_sim_ds2482_t *bridge) {
+    onewire_sim_t *sim = bridge->lines[bridge->channel];
+    const onewire_timing_t *timing = (bridge->config & DS2482_CONFIG_1WS) ?
+                                    &onewire_timing_overdrive : &onewire_timing_standard;
+    bool presence;
+
+    if (!sim) {
+        return false;
+    }
+
+    onewire_sim_drive(sim, true);
+    onewire_sim_advance(sim, timing->reset_low * 100);
+    onewire_sim_drive(sim, false);
+    onewire_sim_advance(sim, timing->presence_sample * 100);
+    presence = !onewire_sim_sample(sim);
+    onewire_sim_advance(sim, timing->reset_recovery * 100);
+
+    return presence;
+}
+
+
+//! \brief run a 1-wire command and set the status register
+//!
+static void sim_ds2482_run(onewire_sim_ds2482_t *bridge, uint8_t command, uint8_t param) {
+    uint8_t status = bridge->status & DS2482_STATUS_RST;
+    uint8_t bit_A, bit_B, direction;
+
+    switch (command) {
+        case DS2482_1WIRE_RESET:
+            if (sim_ds2482_reset(bridge)) {
+                status |= DS2482_STATUS_PPD;
+            }
+            break;
+
+        case DS2482_1WIRE_BIT:
+            if (sim_ds2482_slot(bridge, param & 0x80)) {
+                status |= DS2482_STATUS_SBR;
+            }
+            break;
+
+        case DS2482_1WIRE_WRITE:
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                sim_ds2482_slot(bridge, param & (1 << bit));
+            }
+            break;
+
+        case DS2482_1WIRE_READ:
+            bridge->data = 0;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                bridge->data |= sim_ds2482_slot(bridge, 1) << bit;
+            }
+            break;
+
+        case DS2482_1WIRE_TRIPLET:
+            bit_A = sim_ds2482_slot(bridge, 1);
+            bit_B = sim_ds2482_slot(bridge, 1);
+            direction = (bit_A != bit_B) ? bit_A : (param & 0x80) != 0;
+            sim_ds2482_slot(bridge, direction);
+
+            status |= (bit_A ? DS2482_STATUS_SBR : 0) | (bit_B ? DS2482_STATUS_TSB : 0)
+                    | (direction ? DS2482_STATUS_DIR : 0);
+            break;
+    }
+
+    bridge->status = status | DS2482_STATUS_LL;
+    bridge->pointer = DS2482_STATUS_REGISTER;
+}
+
+
+bool sim_ds2482_write(void *context, uint8_t address, const uint8_t *data, uint8_t len) {
+    static const uint8_t channel_code[DS2482_800_CHANNELS] = {
+        0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87
+    };
+    onewire_sim_ds2482_t *bridge = (onewire_sim_ds2482_t*)context;
+    uint8_t param = (len > 1) ? data[1] : 0;
+
+    if (address != bridge->address || len == 0) {
+        return false;
+    }
+
+    bridge->transactions++;
+
+    switch (data[0]) {
+        case DS2482_DEVICE_RESET:
+            bridge->channel = 0;
+            bridge->config = 0;
+            bridge->status = DS2482_STATUS_RST | DS2482_STATUS_LL;
+            bridge->pointer = DS2482_STATUS_REGISTER;
+            break;
+
+        case DS2482_SET_POINTER:
+            bridge->pointer = param;
+            break;
+
+        case DS2482_WRITE_CONFIG:
+            // upper nibble must be the complement of the lower one
+            if ((param >> 4) != (~param & 0x0F)) {
+                return false;
+            }
+            bridge->config = param & 0x0F;
+            bridge->status &= ~DS2482_STATUS_RST;
+            bridge->pointer = DS2482_CONFIG_REGISTER;
+            break;
+
+        case DS2482_CHANNEL_SELECT:
+            for (uint8_t i = 0; i < bridge->channels; i++) {
+                if (channel_code[i] == param) {
+                    bridge->channel = i;
+                }
+            }
+            bridge->pointer = DS2482_CHANNEL_REGISTER;
+            break;
+
+        default:
+            sim_ds2482_run(bridge, data[0], param);
+            break;
+    }
+
+    return true;
+}
+
+
+bool sim_ds2482_read(void *context, uint8_t address, uint8_t *data, uint8_t len) {
+    static const uint8_t channel_check[DS2482_800_CHANNELS] = {
+        0xB8, 0xB1, 0xAA, 0xA3, 0x9C, 0x95, 0x8E, 0x87
+    };
+    onewire_sim_ds2482_t *bridge = (onewire_sim_ds2482_t*)context;
+    uint8_t value;
+
+    if (address != bridge->address) {
+        return false;
+    }
+
+    bridge->transactions++;
+
+    switch (bridge->pointer) {
+        case DS2482_DATA_REGISTER:
+            value = bridge->data;
+            break;
+
+        case DS2482_CONFIG_REGISTER:
+            value = bridge->config;
+            break;
+
+        case DS2482_CHANNEL_REGISTER:
+            value = channel_check[bridge->channel];
+            break;
+
+        default:
+            value = bridge->status;
+            break;
+    }
+
+    for (uint8_t i = 0; i < len; i++) {
+        data[i] = value;
+    }
+
+    return true;
+}
+
+
+//! \brief time passes on every channel, a line wired twice counts once
+//!
+void sim_ds2482_delay(void *context, uint16_t ms) {
+    onewire_sim_ds2482_t *bridge = (onewire_sim_ds2482_t*)context;
+
+    for (uint8_t i = 0; i < bridge->channels; i++) {
+        bool seen = false;
+
+        for (uint8_t j = 0; j < i; j++) {
+            seen |= bridge->lines[j] == bridge->lines[i];
+        }
+
+        if (bridge->lines[i] == NULL || seen) {
+            continue;
+        }
+
+        for (uint16_t k = 0; k < ms; k++) {
+            onewire_sim_advance(bridge->lines[i], 1000000);
+        }
+    }
+}
+
+
+//! \brief initialize a simulated one-shot timer
+//! \param timer simulated timer
+//! \param sim simulated line
+//! \param isr interrupt handler, e.g. a wrapper of onewire_async_tick()
+//! \param arg argument of the interrupt handler
+//!
+void onewire_sim_timerInit(onewire_sim_timer_t *timer, onewire_sim_t *sim,
+                            void (*isr)(void *arg), void *arg)
+{
+    timer->sim = sim;
+    timer->armed = false;
+    timer->deadline = 0;
+    timer->isr = isr;
+    timer->arg = arg;
+    timer->port.schedule = sim_timer_schedule;
+    timer->port.stop = sim_timer_stop;
+    timer->port.context = timer;
+}
+
+
+//! \brief run the main loop for some virtual time
+//! \param timer simulated timer
+//! \param ns duration in nanoseconds
+//! \return number of interrupts fired in that time
+//!
+uint16_t onewire_sim_timerRun(onewire_sim_timer_t *timer, uint32_t ns) {
+    onewire_sim_t *sim = timer->sim;
+    uint64_t end = sim->now + ns;
+    uint16_t fired = 0;
+
+    while (timer->armed && timer->deadline <= end) {
+        if (timer->deadline > sim->now) {
+            sim->now = timer->deadline;
+        }
+
+        timer->armed = false;
+        timer->isr(timer->arg);
+        fired++;
+
+        // time spent in the handler delays the main loop
+        if (sim->now > end) {
+            end = sim->now;
+        }
+    }
+
+    sim->now = end;
+
+    return fired;
+}
+
+
+void sim_timer_schedule(void *context, uint16_t time) {
+    onewire_sim_timer_t *timer = (onewire_sim_timer_t*)context;
+
+    timer->deadline = timer->sim->now + (uint64_t)time * 100;
+    timer->armed = true;
+}
+
+
+void sim_timer_stop(void *context) {
+    onewire_sim_timer_t *timer = (onewire_sim_timer_t*)context;
+
+    timer->armed = false;
+}
@@ -0,0 +1,400 @@
+//! \file onewire_sim_bench.c
+//! \brief Bus time accounting on the simulated 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 4
+
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+#include "onewire_sched.h"
+
+#include <stdlib.h>
+
+
+static const char *distribution_name[] = {"sequential", "random", "prefix"};
+
+
+//! \brief write counters as one CSV line
+//! \param file output stream
+//! \param label first column, e.g. scenario and API call
+//! \param counter counters
+//!
+void onewire_sim_printCsv(FILE *file, const char *label, const onewire_sim_counter_t *counter) {
+    fprintf(file, "%s,%u,%u,%u,%u,%.1f\n", label,
+            (unsigned)counter->resets, (unsigned)counter->write0,
+            (unsigned)counter->write1, (unsigned)counter->read,
+            counter->time / 1000.0);
+}
+
+
+//! \brief write counters as one JSON object, without separator
+//! \param file output stream
+//! \param label value of the "label" member
+//! \param counter counters
+//!
+void onewire_sim_printJson(FILE *file, const char *label, const onewire_sim_counter_t *counter) {
+    fprintf(file, "{\"label\": \"%s\", \"resets\": %u, \"write0\": %u, "
+            "\"write1\": %u, \"read\": %u, \"us\": %.1f}", label,
+            (unsigned)counter->resets, (unsigned)counter->write0,
+            (unsigned)counter->write1, (unsigned)counter->read,
+            counter->time / 1000.0);
+}
+
+
+//! \brief make a serial number for a scenario
+//! \param distribution ONEWIRE_SIM_SEQUENTIAL, ONEWIRE_SIM_RANDOM or ONEWIRE_SIM_PREFIX
+//! \param index device index
+//! \return 48-bit serial number
+//!
+uint64_t onewire_sim_serial(uint8_t distribution, uint32_t index) {
+    uint64_t x;
+
+    switch (distribution) {
+        case ONEWIRE_SIM_RANDOM:
+            // splitmix64 of the index
+            x = index + 0x9E3779B97F4A7C15ULL;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+            x = x ^ (x >> 31);
+            return x & 0xFFFFFFFFFFFFULL;
+
+        case ONEWIRE_SIM_PREFIX:
+            return 0x5A5A5A5A5AULL | ((uint64_t)(index & 0xFF) << 40);
+
+        default:
+            return index & 0xFFFFFFFFFFFFULL;
+    }
+}
+
+
+static void bench_row(FILE *file, uint8_t format, bool *first, uint8_t distribution,
+                        uint16_t count, const char *call, const onewire_sim_t *sim)
+{
+    onewire_sim_counter_t counter;
+    char label[64];
+
+    onewire_sim_getCounters(sim, &counter);
+
+    if (format == ONEWIRE_SIM_JSON) {
+        snprintf(label, sizeof(label), "%s/%u/%s",
+                distribution_name[distribution], count, call);
+        fprintf(file, *first ? "  " : ",\n  ");
+        onewire_sim_printJson(file, label, &counter);
+    }
+    else {
+        snprintf(label, sizeof(label), "%s,%u,%s",
+                distribution_name[distribution], count, call);
+        onewire_sim_printCsv(file, label, &counter);
+    }
+
+    *first = false;
+}
+
+
+//! \brief measure bus time of the core API on simulated DS18B20 lines
+//! \param file output stream
+//! \param format ONEWIRE_SIM_CSV or ONEWIRE_SIM_JSON
+//! \param counts device counts to sweep, each at most 255
+//! \param len number of device counts
+//! \return false if a search did not find every device
+//!
+bool onewire_sim_benchmark(FILE *file, uint8_t format, const uint16_t *counts, uint8_t len) {
+    onewire_sim_ds18b20_t *devices;
+    uint8_t (*address_box)[8];
+    uint8_t data[DS18B20_SCRATCHPAD_SIZE];
+    uint16_t max = 0;
+    bool first = true;
+    bool status = true;
+
+    for (uint8_t i = 0; i < len; i++) {
+        if (counts[i] > max) {
+            max = counts[i];
+        }
+    }
+    if (max > 255) {
+        max = 255;
+    }
+
+    devices = malloc(max * sizeof(*devices) + 1);
+    address_box = malloc(max * sizeof(*address_box) + 1);
+    if (!devices || !address_box) {
+        free(devices);
+        free(address_box);
+        return false;
+    }
+
+    if (format == ONEWIRE_SIM_JSON) {
+        fprintf(file, "[\n");
+    }
+    else {
+        fprintf(file, "distribution,devices,call,resets,write0,write1,read,us\n");
+    }
+
+    for (uint8_t distribution = 0; distribution < 3; distribution++) {
+        for (uint8_t i = 0; i < len; i++) {
+            uint16_t count = counts[i] > max ? max : counts[i];
+            onewire_sim_t sim;
+            onewire_bus_t bus;
+            uint8_t found;
+
+            onewire_sim_init(&sim);
+            host_onewire_init(&bus, &sim);
+
+            for (uint16_t k = 0; k < count; k++) {
+                onewire_sim_ds18b20Init(&devices[k], onewire_sim_serial(distribution, k));
+                onewire_sim_attach(&sim, &devices[k].device);
+            }
+
+            onewire_sim_clearCounters(&sim);
+            found = onewire_search(&bus, address_box, count);
+            bench_row(file, format, &first, distribution, count, "onewire_search", &sim);
+
+            if (found != count) {
+                status = false;
+                continue;
+            }
+
+            if (count == 0) {
+                continue;
+            }
+
+            onewire_sim_clearCounters(&sim);
+            onewire_select(&bus, address_box[0]);
+            bench_row(file, format, &first, distribution, count, "onewire_select", &sim);
+
+            // fixed pattern, half 0 and half 1 bits
+            for (uint8_t k = 0; k < sizeof(data); k++) {
+                data[k] = 0x0F;
+            }
+
+            onewire_sim_clearCounters(&sim);
+            onewire_sendBuffer(&bus, data, sizeof(data));
+            bench_row(file, format, &first, distribution, count, "onewire_sendBuffer", &sim);
+
+            onewire_sim_clearCounters(&sim);
+            onewire_receiveBuffer(&bus, data, sizeof(data));
+            bench_row(file, format, &first, distribution, count, "onewire_receiveBuffer", &sim);
+        }
+    }
+
+    if (format == ONEWIRE_SIM_JSON) {
+        fprintf(file, "\n]\n");
+    }
+
+    free(devices);
+    free(address_box);
+
+    return status;
+}
+
+
+//! sampling periods of onewire_sim_benchmarkScheduler(), ms
+static const uint32_t bench_period[] = {1000, 2000, 5000, 10000};
+
+typedef struct bench_line {
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+    uint16_t sensors;
+    uint32_t reads;
+    uint32_t failures;
+    uint32_t missed;
+    uint16_t jitter_max;
+} bench_line_t;
+
+typedef struct bench_clock {
+    bench_line_t *lines;
+    uint8_t count;
+} bench_clock_t;
+
+
+//! \brief common virtual time of all lines, the CPU drives one at a time
+//!
+static uint32_t bench_clock(void *context) {
+    bench_clock_t *clock = (bench_clock_t*)context;
+    uint64_t now = 0;
+
+    for (uint8_t i = 0; i < clock->count; i++) {
+        if (clock->lines[i].sim.now > now) {
+            now = clock->lines[i].sim.now;
+        }
+    }
+
+    for (uint8_t i = 0; i < clock->count; i++) {
+        clock->lines[i].sim.now = now;
+    }
+
+    return now / 1000000;
+}
+
+
+static void bench_done(onewire_sched_task_t *task, uint8_t status) {
+    bench_line_t *line = (bench_line_t*)task->arg;
+
+    line->reads++;
+
+    if (status != ONEWIRE_OK) {
+        line->failures++;
+    }
+}
+
+
+static void bench_schedRow(FILE *file, uint8_t format, bool first, const char *label,
+                            uint16_t sensors, uint32_t reads, uint32_t failures,
+                            uint32_t missed, uint16_t jitter_max, double utilisation)
+{
+    if (format == ONEWIRE_SIM_JSON) {
+        fprintf(file, "%s{\"line\": \"%s\", \"sensors\": %u, \"reads\": %u, "
+                "\"failures\": %u, \"missed\": %u, \"jitter_max_ms\": %u, "
+                "\"utilisation\": %.1f}", first ? "  " : ",\n  ", label,
+                sensors, (unsigned)reads, (unsigned)failures, (unsigned)missed,
+                jitter_max, utilisation);
+    }
+    else {
+        fprintf(file, "%s,%u,%u,%u,%u,%u,%.1f\n", label, sensors, (unsigned)reads,
+                (unsigned)failures, (unsigned)missed, jitter_max, utilisation);
+    }
+}
+
+
+//! \brief measure bus utilisation and jitter of the polling scheduler
+//! \param file output stream
+//! \param format ONEWIRE_SIM_CSV or ONEWIRE_SIM_JSON
+//! \param sensors number of simulated DS18B20
+//! \param lines number of buses, at most 8
+//! \param duration simulated time, ms
+//! \param window batching window of the scheduler, ms
+//! \return false if memory could not be allocated
+//!
+bool onewire_sim_benchmarkScheduler(FILE *file, uint8_t format, uint16_t sensors,
+                                    uint8_t lines, uint32_t duration, uint16_t window)
+{
+    onewire_sim_ds18b20_t *devices;
+    onewire_sched_task_t *tasks;
+    uint8_t (*data)[DS18B20_SCRATCHPAD_SIZE];
+    bench_line_t line[8];
+    bench_clock_t clock = {line, lines};
+    onewire_sched_t sched;
+    onewire_timing_t timing = onewire_timing_standard;
+    uint32_t reset_time = timing.reset_delay + timing.reset_low
+                        + timing.presence_sample + timing.reset_recovery;
+    uint32_t slot_time = timing.write0_low + timing.write0_recovery;
+    uint32_t reads = 0;
+    uint32_t failures = 0;
+    double busy_total = 0;
+    char label[8];
+
+    if (lines == 0 || lines > 8) {
+        lines = 8;
+        clock.count = 8;
+    }
+
+    devices = malloc(sensors * sizeof(*devices) + 1);
+    tasks = malloc(sensors * sizeof(*tasks) + 1);
+    data = malloc(sensors * sizeof(*data) + 1);
+    if (!devices || !tasks || !data) {
+        free(devices);
+        free(tasks);
+        free(data);
+        return false;
+    }
+
+    for (uint8_t i = 0; i < lines; i++) {
+        onewire_sim_init(&line[i].sim);
+        host_onewire_init(&line[i].bus, &line[i].sim);
+        line[i].sensors = 0;
+        line[i].reads = 0;
+        line[i].failures = 0;
+        line[i].missed = 0;
+        line[i].jitter_max = 0;
+    }
+
+    onewire_sched_init(&sched, bench_clock, &clock, window);
+
+    for (uint16_t k = 0; k < sensors; k++) {
+        bench_line_t *bench = &line[k % lines];
+        uint32_t period = bench_period[(k / lines) % 4];
+
+        onewire_sim_ds18b20Init(&devices[k], onewire_sim_serial(ONEWIRE_SIM_RANDOM, k));
+        onewire_sim_attach(&bench->sim, &devices[k].device);
+        bench->sensors++;
+
+        tasks[k].bus = &bench->bus;
+        tasks[k].address = devices[k].device.ROM;
+        tasks[k].convert = DS18B20_CONVERT_T;
+        tasks[k].read = DS18B20_READ_SCRATCHPAD;
+        tasks[k].len = DS18B20_SCRATCHPAD_SIZE;
+        tasks[k].check = ONEWIRE_CHECK_CRC8;
+        tasks[k].data = data[k];
+        tasks[k].period = period;
+        tasks[k].conversion = 750;
+        tasks[k].done = bench_done;
+        tasks[k].arg = bench;
+
+        // phases spread over the period
+        onewire_sched_add(&sched, &tasks[k], (k * 7919UL) % period);
+    }
+
+    for (uint8_t i = 0; i < lines; i++) {
+        onewire_sim_clearCounters(&line[i].sim);
+    }
+
+    while (bench_clock(&clock) < duration) {
+        uint32_t idle = onewire_sched_run(&sched);
+        uint32_t left = duration - bench_clock(&clock);
+
+        if (idle > left) {
+            idle = left;
+        }
+
+        if (idle) {
+            line[0].sim.now += (uint64_t)idle * 1000000;
+        }
+    }
+
+    for (uint16_t k = 0; k < sensors; k++) {
+        bench_line_t *bench = (bench_line_t*)tasks[k].arg;
+
+        bench->missed += tasks[k].missed;
+        if (tasks[k].jitter > bench->jitter_max) {
+            bench->jitter_max = tasks[k].jitter;
+        }
+    }
+
+    if (format == ONEWIRE_SIM_JSON) {
+        fprintf(file, "[\n");
+    }
+    else {
+        fprintf(file, "line,sensors,reads,failures,missed,jitter_max_ms,utilisation\n");
+    }
+
+    for (uint8_t i = 0; i < lines; i++) {
+        onewire_sim_counter_t counter;
+        double busy;
+
+        onewire_sim_getCounters(&line[i].sim, &counter);
+        busy = (double)counter.resets * reset_time
+            + (double)(counter.write0 + counter.write1 + counter.read) * slot_time;
+        busy_total += busy;
+        reads += line[i].reads;
+        failures += line[i].failures;
+
+        // bus time in tenths of us, elapsed time in ns
+        snprintf(label, sizeof(label), "%u", i);
+        bench_schedRow(file, format, i == 0, label, line[i].sensors, line[i].reads,
+                        line[i].failures, line[i].missed, line[i].jitter_max,
+                        counter.time ? 100.0 * busy * 100 / counter.time : 0);
+    }
+
+    bench_schedRow(file, format, false, "all", sensors, reads, failures,
+                    sched.stats.missed, sched.stats.jitter_max,
+                    duration ? 100.0 * busy_total / 10 / 1000 / duration / lines : 0);
+
+    if (format == ONEWIRE_SIM_JSON) {
+        fprintf(file, "\n]\n");
+    }
+
+    free(devices);
+    free(tasks);
+    free(data);
+
+    return true;
+}
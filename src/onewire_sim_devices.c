@@ -0,0 +1,448 @@
+//! \file onewire_sim_devices.c
+//! \brief Models of virtual devices for the simulated 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 27
+
+#include "onewire_sim.h"
+#include "onewire_crc.h"
+#include "onewire_ds18b20.h"
+
+
+#define DS18B20_RECALL_E2           0xB8
+#define DS18B20_READ_POWER_SUPPLY   0xB4
+
+#define DS2431_WRITE_SCRATCHPAD     0x0F
+#define DS2431_READ_SCRATCHPAD      0xAA
+#define DS2431_COPY_SCRATCHPAD      0x55
+#define DS2431_READ_MEMORY          0xF0
+
+#define DS2413_PIO_ACCESS_READ      0xF5
+#define DS2413_PIO_ACCESS_WRITE     0x5A
+
+// in nanoseconds
+#define DS18B20_CONVERSION_TIME_9   93750000ULL
+#define DS2431_PROGRAMMING_TIME     10000000ULL
+
+
+static void ds18b20_reset(onewire_sim_device_t *device, uint64_t now);
+static void ds18b20_command(onewire_sim_device_t *device, uint8_t command, uint64_t now);
+static void ds18b20_receive(onewire_sim_device_t *device, uint8_t data, uint64_t now);
+static void ds18b20_refill(onewire_sim_device_t *device, uint64_t now);
+static bool ds18b20_alarm(const onewire_sim_device_t *device);
+
+static void ds2431_command(onewire_sim_device_t *device, uint8_t command, uint64_t now);
+static void ds2431_receive(onewire_sim_device_t *device, uint8_t data, uint64_t now);
+static void ds2431_refill(onewire_sim_device_t *device, uint64_t now);
+
+static void ds2413_command(onewire_sim_device_t *device, uint8_t command, uint64_t now);
+static void ds2413_receive(onewire_sim_device_t *device, uint8_t data, uint64_t now);
+static void ds2413_refill(onewire_sim_device_t *device, uint64_t now);
+
+
+static const onewire_sim_model_t ds18b20_model = {
+    .overdrive  = false,
+    .reset      = ds18b20_reset,
+    .command    = ds18b20_command,
+    .receive    = ds18b20_receive,
+    .refill     = ds18b20_refill,
+    .alarm      = ds18b20_alarm,
+};
+
+static const onewire_sim_model_t ds2431_model = {
+    .overdrive  = true,
+    .resume     = true,
+    .command    = ds2431_command,
+    .receive    = ds2431_receive,
+    .refill     = ds2431_refill,
+};
+
+static const onewire_sim_model_t ds2413_model = {
+    .overdrive  = true,
+    .resume     = true,
+    .command    = ds2413_command,
+    .receive    = ds2413_receive,
+    .refill     = ds2413_refill,
+};
+
+
+//! \brief initialize a virtual DS18B20
+//! \param ds18b20 virtual thermometer
+//! \param serial 48-bit serial number
+//!
+void onewire_sim_ds18b20Init(onewire_sim_ds18b20_t *ds18b20, uint64_t serial) {
+    onewire_sim_deviceInit(&ds18b20->device, &ds18b20_model, DS18B20_FAMILY_CODE, serial);
+
+    ds18b20->temperature = 25 * 16;
+
+    ds18b20->eeprom[0] = 75;
+    ds18b20->eeprom[1] = 70;
+    ds18b20->eeprom[2] = DS18B20_RESOLUTION_12;
+
+    ds18b20->scratchpad[0] = 0x50;
+    ds18b20->scratchpad[1] = 0x05;
+    ds18b20->scratchpad[2] = ds18b20->eeprom[0];
+    ds18b20->scratchpad[3] = ds18b20->eeprom[1];
+    ds18b20->scratchpad[4] = ds18b20->eeprom[2];
+    ds18b20->scratchpad[5] = 0xFF;
+    ds18b20->scratchpad[6] = 0x0C;
+    ds18b20->scratchpad[7] = 0x10;
+    ds18b20->scratchpad[8] = crc8(0, ds18b20->scratchpad, 8);
+
+    ds18b20->ready = 0;
+    ds18b20->converting = false;
+    ds18b20->alarm = false;
+    ds18b20->index = 0;
+}
+
+
+//! \brief finish the running conversion if its time is over
+//!
+static void ds18b20_update(onewire_sim_ds18b20_t *ds18b20, uint64_t now) {
+    uint8_t *scratchpad = ds18b20->scratchpad;
+    uint8_t resolution = (scratchpad[4] >> 5) & 0x03;
+    int16_t temperature;
+
+    if (!ds18b20->converting || now < ds18b20->ready) {
+        return;
+    }
+
+    // undefined low bits read as 0
+    temperature = ds18b20->temperature & ~((1 << (3 - resolution)) - 1);
+
+    scratchpad[0] = temperature & 0xFF;
+    scratchpad[1] = (uint16_t)temperature >> 8;
+    scratchpad[8] = crc8(0, scratchpad, 8);
+
+    ds18b20->alarm = (temperature >> 4) >= (int8_t)scratchpad[2]
+                    || (temperature >> 4) <= (int8_t)scratchpad[3];
+    ds18b20->converting = false;
+}
+
+
+void ds18b20_reset(onewire_sim_device_t *device, uint64_t now) {
+    onewire_sim_ds18b20_t *ds18b20 = (onewire_sim_ds18b20_t*)device;
+
+    ds18b20_update(ds18b20, now);
+}
+
+
+void ds18b20_command(onewire_sim_device_t *device, uint8_t command, uint64_t now) {
+    onewire_sim_ds18b20_t *ds18b20 = (onewire_sim_ds18b20_t*)device;
+    uint8_t *scratchpad = ds18b20->scratchpad;
+
+    ds18b20_update(ds18b20, now);
+
+    switch (command) {
+        case DS18B20_CONVERT_T:
+            ds18b20->converting = true;
+            ds18b20->ready = now + (DS18B20_CONVERSION_TIME_9 << ((scratchpad[4] >> 5) & 0x03));
+            device->reading = true;
+            break;
+
+        case DS18B20_READ_SCRATCHPAD:
+            onewire_sim_reply(device, scratchpad, 8 * DS18B20_SCRATCHPAD_SIZE);
+            break;
+
+        case DS18B20_WRITE_SCRATCHPAD:
+            ds18b20->index = 0;
+            break;
+
+        case DS18B20_COPY_SCRATCHPAD:
+            for (uint8_t i = 0; i < 3; i++) {
+                ds18b20->eeprom[i] = scratchpad[2 + i];
+            }
+            device->reading = true;
+            break;
+
+        case DS18B20_RECALL_E2:
+            for (uint8_t i = 0; i < 3; i++) {
+                scratchpad[2 + i] = ds18b20->eeprom[i];
+            }
+            scratchpad[8] = crc8(0, scratchpad, 8);
+            device->reading = true;
+            break;
+
+        case DS18B20_READ_POWER_SUPPLY:
+            device->reading = true;
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+void ds18b20_receive(onewire_sim_device_t *device, uint8_t data, uint64_t now) {
+    onewire_sim_ds18b20_t *ds18b20 = (onewire_sim_ds18b20_t*)device;
+    uint8_t *scratchpad = ds18b20->scratchpad;
+
+    if (ds18b20->index >= 3) {
+        return;
+    }
+
+    // only the resolution bits of the configuration register are writable
+    if (ds18b20->index == 2) {
+        data = (data & 0x60) | 0x1F;
+    }
+
+    scratchpad[2 + ds18b20->index] = data;
+    scratchpad[8] = crc8(0, scratchpad, 8);
+    ds18b20->index++;
+}
+
+
+//! \brief read slots answer 0 while a conversion runs, 1 otherwise
+//!
+void ds18b20_refill(onewire_sim_device_t *device, uint64_t now) {
+    onewire_sim_ds18b20_t *ds18b20 = (onewire_sim_ds18b20_t*)device;
+    uint8_t done;
+
+    ds18b20_update(ds18b20, now);
+
+    done = ds18b20->converting ? 0 : 1;
+    onewire_sim_reply(device, &done, 1);
+}
+
+
+bool ds18b20_alarm(const onewire_sim_device_t *device) {
+    return ((const onewire_sim_ds18b20_t*)device)->alarm;
+}
+
+
+//! \brief initialize a virtual DS2431, memory erased to 0xFF
+//! \param ds2431 virtual EEPROM
+//! \param serial 48-bit serial number
+//!
+void onewire_sim_ds2431Init(onewire_sim_ds2431_t *ds2431, uint64_t serial) {
+    onewire_sim_deviceInit(&ds2431->device, &ds2431_model, DS2431_FAMILY_CODE, serial);
+
+    for (uint16_t i = 0; i < sizeof(ds2431->memory); i++) {
+        ds2431->memory[i] = 0xFF;
+    }
+
+    for (uint8_t i = 0; i < sizeof(ds2431->scratchpad); i++) {
+        ds2431->scratchpad[i] = 0xFF;
+    }
+
+    ds2431->command = 0;
+    ds2431->address = 0;
+    ds2431->status = 0;
+    ds2431->index = 0;
+    ds2431->crc = 0;
+    ds2431->ready = 0;
+}
+
+
+void ds2431_command(onewire_sim_device_t *device, uint8_t command, uint64_t now) {
+    onewire_sim_ds2431_t *ds2431 = (onewire_sim_ds2431_t*)device;
+    uint8_t reply[13];
+    uint8_t len = 0;
+    uint16_t crc;
+
+    ds2431->command = command;
+    ds2431->index = 0;
+    ds2431->crc = crc16_update(0, command);
+
+    if (command != DS2431_READ_SCRATCHPAD) {
+        return;
+    }
+
+    // TA1, TA2, E/S, scratchpad from T2:T0 to E2:E0, inverted CRC-16
+    reply[len++] = ds2431->address & 0xFF;
+    reply[len++] = ds2431->address >> 8;
+    reply[len++] = ds2431->status;
+    for (uint8_t i = ds2431->address & 0x07; i <= (ds2431->status & 0x07); i++) {
+        reply[len++] = ds2431->scratchpad[i];
+    }
+
+    crc = ~crc16(ds2431->crc, reply, len);
+    reply[len++] = crc & 0xFF;
+    reply[len++] = crc >> 8;
+
+    onewire_sim_reply(device, reply, 8 * len);
+}
+
+
+void ds2431_receive(onewire_sim_device_t *device, uint8_t data, uint64_t now) {
+    onewire_sim_ds2431_t *ds2431 = (onewire_sim_ds2431_t*)device;
+    uint8_t index = ds2431->index++;
+    uint8_t offset;
+    uint16_t crc;
+
+    ds2431->crc = crc16_update(ds2431->crc, data);
+
+    if (index < 3) {
+        ds2431->args[index] = data;
+    }
+
+    switch (ds2431->command) {
+        case DS2431_WRITE_SCRATCHPAD:
+            if (index == 1) {
+                ds2431->address = ds2431->args[0] | ((uint16_t)ds2431->args[1] << 8);
+                ds2431->status = ds2431->address & 0x07;
+            }
+            else if (index >= 2) {
+                offset = (ds2431->address & 0x07) + index - 2;
+                if (offset > 7) {
+                    break;
+                }
+
+                ds2431->scratchpad[offset] = data;
+                ds2431->status = offset;
+
+                // the CRC follows once the end of the row is reached
+                if (offset == 7) {
+                    crc = ~ds2431->crc;
+                    onewire_sim_reply(device, (const uint8_t[]){crc & 0xFF, crc >> 8}, 16);
+                }
+            }
+            break;
+
+        case DS2431_COPY_SCRATCHPAD:
+            if (index != 2) {
+                break;
+            }
+
+            // authorization pattern must repeat TA1, TA2 and E/S
+            if (ds2431->args[0] == (ds2431->address & 0xFF)
+                && ds2431->args[1] == (ds2431->address >> 8)
+                && ds2431->args[2] == ds2431->status
+                && ds2431->address < sizeof(ds2431->memory))
+            {
+                for (uint8_t i = 0; i < 8; i++) {
+                    ds2431->memory[(ds2431->address & ~0x07) + i] = ds2431->scratchpad[i];
+                }
+                ds2431->status |= 0x80;
+                ds2431->ready = now + DS2431_PROGRAMMING_TIME;
+            }
+            device->reading = true;
+            break;
+
+        case DS2431_READ_MEMORY:
+            if (index == 1) {
+                ds2431->address = ds2431->args[0] | ((uint16_t)ds2431->args[1] << 8);
+                device->reading = true;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+//! \brief stream memory, or the 0xAA pattern once programming is over
+//!
+//! As the real device, it leaves the line high during tPROG and after a
+//! refused copy.
+//!
+void ds2431_refill(onewire_sim_device_t *device, uint64_t now) {
+    onewire_sim_ds2431_t *ds2431 = (onewire_sim_ds2431_t*)device;
+    static const uint8_t done = 0xAA;
+
+    switch (ds2431->command) {
+        case DS2431_COPY_SCRATCHPAD:
+            if (!(ds2431->status & 0x80) || now < ds2431->ready) {
+                break;
+            }
+            onewire_sim_reply(device, &done, 8);
+            break;
+
+        case DS2431_READ_MEMORY:
+            if (ds2431->address < sizeof(ds2431->memory)) {
+                onewire_sim_reply(device, &ds2431->memory[ds2431->address], 8);
+                ds2431->address++;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+//! \brief initialize a virtual DS2413, latches off and pins pulled up
+//! \param ds2413 virtual switch
+//! \param serial 48-bit serial number
+//!
+void onewire_sim_ds2413Init(onewire_sim_ds2413_t *ds2413, uint64_t serial) {
+    onewire_sim_deviceInit(&ds2413->device, &ds2413_model, DS2413_FAMILY_CODE, serial);
+
+    ds2413->latch = 0x03;
+    ds2413->input = 0x03;
+    ds2413->command = 0;
+    ds2413->data = 0;
+    ds2413->index = 0;
+}
+
+
+//! \brief PIO status: pin and latch of PIOA and PIOB, then their complement
+//!
+static uint8_t ds2413_status(const onewire_sim_ds2413_t *ds2413) {
+    uint8_t pin = ds2413->latch & ds2413->input;
+    uint8_t status = (pin & 0x01)
+                    | ((ds2413->latch & 0x01) << 1)
+                    | ((pin & 0x02) << 1)
+                    | ((ds2413->latch & 0x02) << 2);
+
+    return status | ((~status & 0x0F) << 4);
+}
+
+
+void ds2413_command(onewire_sim_device_t *device, uint8_t command, uint64_t now) {
+    onewire_sim_ds2413_t *ds2413 = (onewire_sim_ds2413_t*)device;
+
+    ds2413->command = command;
+    ds2413->index = 0;
+
+    if (command == DS2413_PIO_ACCESS_READ) {
+        device->reading = true;
+    }
+}
+
+
+void ds2413_receive(onewire_sim_device_t *device, uint8_t data, uint64_t now) {
+    onewire_sim_ds2413_t *ds2413 = (onewire_sim_ds2413_t*)device;
+    uint8_t reply[2];
+
+    if (ds2413->command != DS2413_PIO_ACCESS_WRITE) {
+        return;
+    }
+
+    if (ds2413->index == 0) {
+        ds2413->data = data;
+        ds2413->index = 1;
+        return;
+    }
+
+    ds2413->index = 0;
+
+    // the byte is repeated inverted, a mismatch leaves the latches alone
+    if (data != (uint8_t)~ds2413->data) {
+        device->reading = true;
+        return;
+    }
+
+    ds2413->latch = ds2413->data & 0x03;
+
+    reply[0] = 0xAA;
+    reply[1] = ds2413_status(ds2413);
+    onewire_sim_reply(device, reply, 16);
+}
+
+
+void ds2413_refill(onewire_sim_device_t *device, uint64_t now) {
+    onewire_sim_ds2413_t *ds2413 = (onewire_sim_ds2413_t*)device;
+    uint8_t status;
+
+    if (ds2413->command == DS2413_PIO_ACCESS_WRITE) {
+        // back to receiving the next write
+        device->reading = false;
+        return;
+    }
+
+    if (ds2413->command == DS2413_PIO_ACCESS_READ) {
+        status = ds2413_status(ds2413);
+        onewire_sim_reply(device, &status, 8);
+    }
+}
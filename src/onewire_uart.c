@@ -0,0 +1,292 @@
+//! \file onewire_uart.c
+//! \brief UART driven physical layer for 1-wire bus
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 16
+
+#include "onewire_uart.h"
+
+#include <stddef.h>
+
+
+#define SLOT_1      0xFF
+#define SLOT_0      0x00
+#define RESET_PULSE 0xF0
+
+// start bit and 2 data bits low, 52 us at 57600 baud
+#define RESET_PULSE_OVERDRIVE   0xFC
+
+
+static bool uart_reset(onewire_bus_t *bus);
+static uint8_t uart_touchBit(onewire_bus_t *bus, uint8_t bit);
+static void uart_sendBuffer(onewire_bus_t *bus, const uint8_t *data, uint16_t len);
+static void uart_receiveBuffer(onewire_bus_t *bus, uint8_t *data, uint16_t len);
+static void uart_idle(onewire_bus_t *bus, uint16_t ms);
+static void uart_setTiming(onewire_bus_t *bus);
+static void uart_startJob(onewire_uart_job_t *job, onewire_bus_t *bus,
+                            const uint8_t *tx, uint8_t *rx, uint16_t len,
+                            void (*done)(onewire_uart_job_t *job), void *arg);
+static void uart_nextChunk(onewire_uart_job_t *job);
+static void uart_endChunk(onewire_uart_job_t *job);
+static void uart_complete(void *arg);
+
+static const onewire_driver_t uart_driver = {
+    .reset = uart_reset,
+    .touchBit = uart_touchBit,
+    .sendBuffer = uart_sendBuffer,
+    .receiveBuffer = uart_receiveBuffer,
+    .idle = uart_idle,
+    .setTiming = uart_setTiming,
+};
+
+
+//! \brief use a UART as physical layer of a bus
+//! \param bus bus handle
+//! \param port UART port, must stay valid while the bus is used
+//!
+void onewire_uart_init(onewire_bus_t *bus, const onewire_uart_port_t *port) {
+    bus->driver = &uart_driver;
+    bus->context = (void*)port;
+    bus->pullup = NULL;
+    bus->last_conflict_bit = 0;
+    bus->is_last_device_found = false;
+#ifdef ONEWIRE_STATS
+    onewire_stats_clear(bus);
+#endif
+
+    onewire_setTiming(bus, &onewire_timing_standard);
+}
+
+
+//! \brief overdrive profiles have reset pulses of 70 us, standard ones 480 us
+//!
+static bool uart_isOverdrive(const onewire_bus_t *bus) {
+    return bus->timing->reset_low < ONEWIRE_US(100);
+}
+
+
+bool uart_reset(onewire_bus_t *bus) {
+    const onewire_uart_port_t *port = (const onewire_uart_port_t*)bus->context;
+    bool overdrive = uart_isOverdrive(bus);
+    uint8_t tx = overdrive ? RESET_PULSE_OVERDRIVE : RESET_PULSE;
+    uint8_t rx;
+
+    port->setBaudrate(port->context, overdrive ?
+                        ONEWIRE_UART_OVERDRIVE_RESET_BAUDRATE : ONEWIRE_UART_RESET_BAUDRATE);
+    port->transfer(port->context, &tx, &rx, 1);
+    uart_setTiming(bus);
+
+    // low over the whole frame: shorted, not a presence pulse
+    if (rx == 0x00) {
+        ONEWIRE_STATS_COUNT(bus, line_timeouts);
+        return false;
+    }
+
+    return rx != tx;
+}
+
+
+uint8_t uart_touchBit(onewire_bus_t *bus, uint8_t bit) {
+    const onewire_uart_port_t *port = (const onewire_uart_port_t*)bus->context;
+    uint8_t tx = bit ? SLOT_1 : SLOT_0;
+    uint8_t rx;
+
+    port->transfer(port->context, &tx, &rx, 1);
+
+    return rx == SLOT_1;
+}
+
+
+//! \brief encode bytes into slots, 8 slots per byte, LSB first
+//! \param tx bytes to write, all '1' are sent if NULL (read slots)
+//!
+static void uart_encode(const uint8_t *tx, uint8_t *slots, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t data = tx ? tx[i] : 0xFF;
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            slots[i*8 + bit] = (data & (1 << bit)) ? SLOT_1 : SLOT_0;
+        }
+    }
+}
+
+
+//! \brief decode echoed slots into bytes
+//!
+static void uart_decode(const uint8_t *slots, uint8_t *rx, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t data = 0;
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            if (slots[i*8 + bit] == SLOT_1) {
+                data |= (1 << bit);
+            }
+        }
+        rx[i] = data;
+    }
+}
+
+
+//! \brief run len bytes of slots, 8 slots per byte, LSB first
+//! \param port UART port
+//! \param tx bytes to write, all '1' are sent if NULL (read slots)
+//! \param rx bytes read back, ignored if NULL
+//! \param len number of bytes
+//!
+static void uart_slots(const onewire_uart_port_t *port,
+                        const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    uint8_t slots_tx[ONEWIRE_UART_CHUNK];
+    uint8_t slots_rx[ONEWIRE_UART_CHUNK];
+    const uint16_t bytes_per_chunk = ONEWIRE_UART_CHUNK / 8;
+
+    while (len) {
+        uint16_t count = (len < bytes_per_chunk) ? len : bytes_per_chunk;
+
+        uart_encode(tx, slots_tx, count);
+        port->transfer(port->context, slots_tx, slots_rx, count * 8);
+
+        if (rx) {
+            uart_decode(slots_rx, rx, count);
+            rx += count;
+        }
+
+        if (tx) {
+            tx += count;
+        }
+        len -= count;
+    }
+}
+
+
+void uart_sendBuffer(onewire_bus_t *bus, const uint8_t *data, uint16_t len) {
+    uart_slots((const onewire_uart_port_t*)bus->context, data, NULL, len);
+}
+
+
+void uart_receiveBuffer(onewire_bus_t *bus, uint8_t *data, uint16_t len) {
+    uart_slots((const onewire_uart_port_t*)bus->context, NULL, data, len);
+}
+
+
+void uart_idle(onewire_bus_t *bus, uint16_t ms) {
+    const onewire_uart_port_t *port = (const onewire_uart_port_t*)bus->context;
+
+    port->delay(port->context, ms);
+}
+
+
+//! \brief data slots at the speed of the profile
+//!
+void uart_setTiming(onewire_bus_t *bus) {
+    const onewire_uart_port_t *port = (const onewire_uart_port_t*)bus->context;
+
+    port->setBaudrate(port->context, uart_isOverdrive(bus) ?
+                        ONEWIRE_UART_OVERDRIVE_DATA_BAUDRATE : ONEWIRE_UART_DATA_BAUDRATE);
+}
+
+
+//! \brief send a buffer in the background
+//! \param job transfer state, must stay valid until it is done
+//! \param bus bus handle of a UART bus, not used until the job is done
+//! \param buffer pointer to data buffer, must stay valid until the job is done
+//! \param len the size of data buffer
+//! \param done called from the interrupt at the end, optional
+//! \param arg stored in job->arg
+//!
+void onewire_uart_sendAsync(onewire_uart_job_t *job, onewire_bus_t *bus,
+                            const void *buffer, uint16_t len,
+                            void (*done)(onewire_uart_job_t *job), void *arg)
+{
+    uart_startJob(job, bus, (const uint8_t*)buffer, NULL, len, done, arg);
+}
+
+
+//! \brief receive a buffer in the background
+//! \param job transfer state, must stay valid until it is done
+//! \param bus bus handle of a UART bus, not used until the job is done
+//! \param buffer pointer to data buffer, filled when the job is done
+//! \param len the size of data buffer
+//! \param done called from the interrupt at the end, optional
+//! \param arg stored in job->arg
+//!
+void onewire_uart_receiveAsync(onewire_uart_job_t *job, onewire_bus_t *bus,
+                                void *buffer, uint16_t len,
+                                void (*done)(onewire_uart_job_t *job), void *arg)
+{
+    uart_startJob(job, bus, NULL, (uint8_t*)buffer, len, done, arg);
+}
+
+
+//! \brief fill a job and start its first chunk
+//!
+void uart_startJob(onewire_uart_job_t *job, onewire_bus_t *bus,
+                    const uint8_t *tx, uint8_t *rx, uint16_t len,
+                    void (*done)(onewire_uart_job_t *job), void *arg)
+{
+    job->port = (const onewire_uart_port_t*)bus->context;
+    job->tx = tx;
+    job->rx = rx;
+    job->len = len;
+    job->count = 0;
+    job->done = done;
+    job->arg = arg;
+    job->busy = true;
+
+    uart_nextChunk(job);
+}
+
+
+//! \brief start the next chunk of a job, or end it
+//!
+void uart_nextChunk(onewire_uart_job_t *job) {
+    const onewire_uart_port_t *port = job->port;
+    const uint16_t bytes_per_chunk = ONEWIRE_UART_CHUNK / 8;
+
+    // blocking ports run the whole job here
+    while (job->len) {
+        uint16_t count = (job->len < bytes_per_chunk) ? job->len : bytes_per_chunk;
+
+        job->count = count;
+        uart_encode(job->tx, job->slots_tx, count);
+
+        if (port->start) {
+            port->start(port->context, job->slots_tx, job->slots_rx, count * 8,
+                        uart_complete, job);
+            return;
+        }
+
+        port->transfer(port->context, job->slots_tx, job->slots_rx, count * 8);
+        uart_endChunk(job);
+    }
+
+    job->busy = false;
+
+    if (job->done) {
+        job->done(job);
+    }
+}
+
+
+//! \brief account the chunk just transferred
+//!
+void uart_endChunk(onewire_uart_job_t *job) {
+    if (job->rx) {
+        uart_decode(job->slots_rx, job->rx, job->count);
+        job->rx += job->count;
+    }
+
+    if (job->tx) {
+        job->tx += job->count;
+    }
+    job->len -= job->count;
+}
+
+
+//! \brief end of a chunk, called from the interrupt of the port
+//!
+void uart_complete(void *arg) {
+    onewire_uart_job_t *job = (onewire_uart_job_t*)arg;
+
+    uart_endChunk(job);
+    uart_nextChunk(job);
+}
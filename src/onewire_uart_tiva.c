@@ -0,0 +1,172 @@
+//! \file onewire_uart_tiva.c
+//! \brief UART driven physical layer for 1-wire bus, Tiva C port
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 16
+
+#include "onewire_uart.h"
+#include <stddef.h>
+
+#include <inc/hw_memmap.h>
+#include <inc/hw_types.h>
+#include <inc/hw_uart.h>
+#include <driverlib/sysctl.h>
+#include <driverlib/uart.h>
+#include <driverlib/udma.h>
+
+
+//! depth of Tiva C UART FIFOs
+#define UART_FIFO_DEPTH     16
+
+
+static void tiva_uart_setBaudrate(void *context, uint32_t baudrate);
+static void tiva_uart_delay(void *context, uint16_t ms) {
+    (void)context;
+
+    delay_ms(ms);
+}
+
+
+void tiva_uart_transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len);
+static void tiva_uart_start(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                            void (*complete)(void *arg), void *arg);
+static void tiva_uart_delay(void *context, uint16_t ms);
+static void tiva_uart_dmaSet(tiva_uart_t *uart, const uint8_t *tx, uint8_t *rx, uint16_t len);
+
+
+//! \brief use a Tiva C UART as physical layer of a bus
+//! \param bus bus handle
+//! \param uart UART description, must stay valid while the bus is used
+//!
+void tiva_onewire_uart_init(onewire_bus_t *bus, tiva_uart_t *uart) {
+    uart->port.setBaudrate = tiva_uart_setBaudrate;
+    uart->port.transfer = tiva_uart_transfer;
+    uart->port.start = tiva_uart_start;
+    uart->port.delay = tiva_uart_delay;
+    uart->port.context = uart;
+    uart->complete = NULL;
+
+    // idle times are counted by the cycle counter, no GPIO bus starts it
+    timebase_init();
+
+    if (uart->use_udma) {
+        UARTDMAEnable(uart->base, UART_DMA_RX | UART_DMA_TX);
+
+        uDMAChannelAttributeDisable(uart->rx_channel, UDMA_ATTR_ALL);
+        uDMAChannelAttributeDisable(uart->tx_channel, UDMA_ATTR_ALL);
+
+        uDMAChannelControlSet(uart->rx_channel | UDMA_PRI_SELECT,
+                                UDMA_SIZE_8 | UDMA_SRC_INC_NONE |
+                                UDMA_DST_INC_8 | UDMA_ARB_4);
+
+        uDMAChannelControlSet(uart->tx_channel | UDMA_PRI_SELECT,
+                                UDMA_SIZE_8 | UDMA_SRC_INC_8 |
+                                UDMA_DST_INC_NONE | UDMA_ARB_4);
+    }
+
+    onewire_uart_init(bus, &uart->port);
+}
+
+
+void tiva_uart_setBaudrate(void *context, uint32_t baudrate) {
+    tiva_uart_t *uart = (tiva_uart_t*)context;
+
+    // wait for the last stop bit before changing the clock
+    while (UARTBusy(uart->base));
+
+    UARTConfigSetExpClk(uart->base, SysCtlClockGet(), baudrate,
+                        UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE |
+                        UART_CONFIG_PAR_NONE);
+    UARTFIFOEnable(uart->base);
+
+    // drop anything left from the previous baudrate
+    while (UARTCharsAvail(uart->base)) {
+        UARTCharGetNonBlocking(uart->base);
+    }
+}
+
+
+void tiva_uart_transfer(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    tiva_uart_t *uart = (tiva_uart_t*)context;
+
+    if (uart->use_udma) {
+        tiva_uart_dmaSet(uart, tx, rx, len);
+
+        // channel is disabled by hardware once the last echo is received
+        while (uDMAChannelIsEnabled(uart->rx_channel));
+        return;
+    }
+
+    // keep the TX FIFO full without overflowing the RX FIFO
+    uint16_t sent = 0;
+    uint16_t received = 0;
+
+    while (received < len) {
+        if (sent < len && (sent - received) < UART_FIFO_DEPTH) {
+            if (UARTCharPutNonBlocking(uart->base, tx[sent])) {
+                sent++;
+            }
+        }
+
+        if (UARTCharsAvail(uart->base)) {
+            rx[received++] = UARTCharGetNonBlocking(uart->base);
+        }
+    }
+}
+
+
+//! \brief start a transfer, complete(arg) is called from tiva_onewire_uartIsr()
+//!
+//! Without uDMA the FIFO is served by the CPU, the transfer is run at once.
+//!
+void tiva_uart_start(void *context, const uint8_t *tx, uint8_t *rx, uint16_t len,
+                        void (*complete)(void *arg), void *arg)
+{
+    tiva_uart_t *uart = (tiva_uart_t*)context;
+
+    if (!uart->use_udma) {
+        tiva_uart_transfer(context, tx, rx, len);
+        complete(arg);
+        return;
+    }
+
+    uart->complete = complete;
+    uart->complete_arg = arg;
+    tiva_uart_dmaSet(uart, tx, rx, len);
+}
+
+
+//! \brief program and enable both uDMA channels for one transfer
+//!
+void tiva_uart_dmaSet(tiva_uart_t *uart, const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    void *data_register = (void*)(uintptr_t)(uart->base + UART_O_DR);
+
+    uDMAChannelTransferSet(uart->rx_channel | UDMA_PRI_SELECT,
+                            UDMA_MODE_BASIC, data_register, rx, len);
+    uDMAChannelTransferSet(uart->tx_channel | UDMA_PRI_SELECT,
+                            UDMA_MODE_BASIC, (void*)tx, data_register, len);
+
+    uDMAChannelEnable(uart->rx_channel);
+    uDMAChannelEnable(uart->tx_channel);
+}
+
+
+//! \brief UART interrupt handler of a Tiva C UART bus
+//! \param uart UART description
+//!
+//! uDMA completion of a UART channel is signalled on the UART interrupt.
+//! The transfer is over once the RX channel has stopped, the last echo
+//! being received after the last slot is sent.
+//!
+void tiva_onewire_uartIsr(tiva_uart_t *uart) {
+    void (*complete)(void *arg) = uart->complete;
+
+    UARTIntClear(uart->base, UARTIntStatus(uart->base, true));
+
+    if (complete == NULL || uDMAChannelIsEnabled(uart->rx_channel)) {
+        return;
+    }
+
+    // cleared first, the completion may start the next transfer
+    uart->complete = NULL;
+    complete(uart->complete_arg);
+}
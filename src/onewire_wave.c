@@ -0,0 +1,55 @@
+//! \file onewire_wave.c
+//! \brief Precomputed waveforms for bulk 1-wire writes
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 30
+
+#include "onewire_wave.h"
+
+
+static uint32_t wave_ticks(uint16_t time, uint32_t ticks_per_us) {
+    return ((uint32_t)time * ticks_per_us + 5) / 10;
+}
+
+
+//! \brief compute write slot symbols from a timing profile
+//! \param wave waveform description to fill
+//! \param timing timing profile
+//! \param ticks_per_us timer ticks per microsecond
+//!
+void onewire_wave_setup(onewire_wave_t *wave, const onewire_timing_t *timing,
+                        uint32_t ticks_per_us)
+{
+    uint16_t slot0 = timing->write0_low + timing->write0_recovery;
+    uint16_t slot1 = timing->write1_low + timing->write1_recovery;
+
+    // a longer recovery is always allowed, so both slots use the longer one
+    wave->period = wave_ticks((slot0 > slot1) ? slot0 : slot1, ticks_per_us);
+    wave->symbol[0] = wave_ticks(timing->write0_low, ticks_per_us);
+    wave->symbol[1] = wave_ticks(timing->write1_low, ticks_per_us);
+}
+
+
+//! \brief compile bytes into slot symbols, LSB first
+//! \param wave waveform description
+//! \param data pointer to data buffer
+//! \param len the size of data buffer
+//! \param table symbol table, room for 8 * len entries
+//! \return number of symbols written
+//!
+uint16_t onewire_wave_encode(const onewire_wave_t *wave, const uint8_t *data,
+                            uint16_t len, uint32_t *table)
+{
+    const uint32_t symbol0 = wave->symbol[0];
+    const uint32_t symbol1 = wave->symbol[1];
+
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t byte = data[i];
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            *table++ = (byte & 0x01) ? symbol1 : symbol0;
+            byte >>= 1;
+        }
+    }
+
+    return len * 8;
+}
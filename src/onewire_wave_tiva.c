@@ -0,0 +1,135 @@
+//! \file onewire_wave_tiva.c
+//! \brief Precomputed waveforms for bulk 1-wire writes, Tiva C timer + uDMA
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 30
+//!
+//! Timer A runs in PWM mode with inverted output, so the pin is low from
+//! the reload until the match: the match value of a slot is its period
+//! minus its low time. Match updates are latched at timeout, and every
+//! timeout requests one uDMA transfer of the next match value.
+
+#include "onewire_wave.h"
+
+#include <inc/hw_memmap.h>
+#include <inc/hw_types.h>
+#include <inc/hw_timer.h>
+#include <driverlib/gpio.h>
+#include <driverlib/sysctl.h>
+#include <driverlib/timer.h>
+#include <driverlib/udma.h>
+
+
+static void wave_burst(onewire_bus_t *bus, tiva_wave_t *out, uint16_t count);
+
+
+//! \brief prepare a Tiva C timer for waveform output on a bus
+//! \param out waveform output
+//! \param bus bus handle, its timing profile is used
+//! \return false if the symbol table cannot hold one byte
+//!
+bool tiva_onewire_waveInit(tiva_wave_t *out, const onewire_bus_t *bus) {
+    if (out->table_len < 8) {
+        return false;
+    }
+
+    onewire_wave_setup(&out->wave, bus->timing, SysCtlClockGet() / 1000000);
+
+    // symbols become match values of a down-counting timer
+    out->wave.symbol[0] = out->wave.period - out->wave.symbol[0];
+    out->wave.symbol[1] = out->wave.period - out->wave.symbol[1];
+
+    TimerDisable(out->timer_base, TIMER_A);
+    TimerConfigure(out->timer_base, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PWM);
+    TimerControlLevel(out->timer_base, TIMER_A, true);
+    TimerUpdateMode(out->timer_base, TIMER_A, TIMER_UP_MATCH_TIMEOUT);
+    TimerLoadSet(out->timer_base, TIMER_A, out->wave.period - 1);
+    TimerDMAEventSet(out->timer_base, TIMER_DMA_TIMEOUT_A);
+
+    uDMAChannelAttributeDisable(out->udma_channel, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(out->udma_channel | UDMA_PRI_SELECT,
+                            UDMA_SIZE_32 | UDMA_SRC_INC_32 |
+                            UDMA_DST_INC_NONE | UDMA_ARB_1);
+
+    GPIOPinConfigure(out->pin_config);
+
+    return true;
+}
+
+
+//! \brief send a buffer to slave through timer and uDMA
+//! \param bus bus handle
+//! \param out waveform output
+//! \param buffer pointer to data buffer
+//! \param len the size of data buffer
+//!
+void tiva_onewire_waveSend(onewire_bus_t *bus, tiva_wave_t *out,
+                            const void *buffer, uint16_t len)
+{
+    const uint8_t *data = (const uint8_t*)buffer;
+    const uint16_t bytes_per_burst = out->table_len / 8;
+
+    if (bytes_per_burst == 0) {
+        return;
+    }
+
+    while (len) {
+        uint16_t count = (len < bytes_per_burst) ? len : bytes_per_burst;
+
+        wave_burst(bus, out, onewire_wave_encode(&out->wave, data, count, out->table));
+
+        data += count;
+        len -= count;
+    }
+}
+
+
+//! \brief output count symbols from the table, then release the bus
+//!
+//! Returns at the end of the period of the last slot, so that its
+//! recovery time is kept before the next slot or burst.
+//!
+void wave_burst(onewire_bus_t *bus, tiva_wave_t *out, uint16_t count) {
+    const uint32_t base = out->timer_base;
+    uint32_t last_match = out->table[count - 1];
+
+    // slot 0 is loaded directly, slot 1 is latched at the first timeout,
+    // uDMA delivers the others one timeout in advance
+    TimerMatchSet(base, TIMER_A, out->table[0]);
+
+    if (count > 2) {
+        uDMAChannelTransferSet(out->udma_channel | UDMA_PRI_SELECT,
+                                UDMA_MODE_BASIC, &out->table[2],
+                                (void*)(uintptr_t)(base + TIMER_O_TAMATCHR),
+                                count - 2);
+        uDMAChannelEnable(out->udma_channel);
+    }
+
+    TimerIntClear(base, TIMER_TIMA_TIMEOUT);
+    GPIOPinTypeTimer(bus->pin.base, bus->pin.pin);
+    TimerEnable(base, TIMER_A);
+
+    if (count > 1) {
+        TimerMatchSet(base, TIMER_A, out->table[1]);
+    }
+
+    // CPU is free until the last symbol has been handed to the timer
+    if (count > 2) {
+        while (uDMAChannelIsEnabled(out->udma_channel));
+        TimerIntClear(base, TIMER_TIMA_TIMEOUT);
+    }
+
+    // wait for the start of the last slot, then for the end of its low time
+    if (count > 1) {
+        while (!(TimerIntStatus(base, false) & TIMER_TIMA_TIMEOUT));
+        TimerIntClear(base, TIMER_TIMA_TIMEOUT);
+    }
+    while (TimerValueGet(base, TIMER_A) > last_match);
+
+    // hand the line back to GPIO, released, before the next period starts
+    GPIOPinTypeGPIOInput(bus->pin.base, bus->pin.pin);
+
+    // a trailing '1' ends its low time 6 us in, the rest of the period is
+    // the recovery the slave needs before the next falling edge
+    while (!(TimerIntStatus(base, false) & TIMER_TIMA_TIMEOUT));
+    TimerDisable(base, TIMER_A);
+}
@@ -0,0 +1,42 @@
+//! \file test.h
+//! \brief Checks shared by the host tests
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 17
+//!
+//! A test is a program run by ctest: every failed check is printed with
+//! its location, and the exit status is not 0 if any check failed.
+
+#ifndef __ONEWIRE_TEST__
+#define __ONEWIRE_TEST__
+
+#include <stdio.h>
+
+
+static int test_failures = 0;
+
+//! \brief report a failed condition, go on with the test
+//!
+#define CHECK(condition)    do { \
+        if (!(condition)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test_failures++; \
+        } \
+    } while (0)
+
+//! \brief report two integers that differ, go on with the test
+//!
+#define CHECK_EQUAL(actual, expected)   do { \
+        long long actual_ = (long long)(actual); \
+        long long expected_ = (long long)(expected); \
+        if (actual_ != expected_) { \
+            printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+                    #actual, actual_, expected_); \
+            test_failures++; \
+        } \
+    } while (0)
+
+//! \brief exit status of a test
+//!
+#define TEST_RESULT()       (test_failures ? 1 : 0)
+
+#endif
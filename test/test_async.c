@@ -0,0 +1,170 @@
+//! \file test_async.c
+//! \brief Interrupt driven transactions against a virtual DS18B20
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 27
+//!
+//! The engine is ticked by the simulated one-shot timer; every interrupt
+//! is entered LATENCY ns after its deadline, as behind a higher priority
+//! handler.
+
+#include "onewire_sim.h"
+#include "onewire_async.h"
+#include "onewire_ds18b20.h"
+#include "onewire_memory.h"
+#include "onewire_crc.h"
+#include "test.h"
+
+#include <string.h>
+
+
+//! interrupt latency, ns
+#define LATENCY         70000
+
+//! tLOW0 max of the standard speed, ns
+#define WRITE0_LOW_MAX  120000
+
+
+static onewire_sim_t sim;
+static onewire_sim_timer_t timer;
+static onewire_async_t engine;
+static uint32_t latency;
+
+static void timerIsr(void *arg);
+static uint8_t runTransaction(onewire_transaction_t *transaction);
+static void test_overdrive(void);
+
+
+int main(void) {
+    onewire_sim_ds18b20_t thermometer;
+    onewire_bus_t bus;
+    onewire_transaction_t transaction;
+    onewire_sim_counter_t counter;
+    uint8_t command[2] = {DS18B20_WRITE_SCRATCHPAD, 0x4B};
+    uint8_t scratchpad[9];
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+    onewire_sim_timerInit(&timer, &sim, timerIsr, &engine);
+    onewire_async_init(&engine, &bus, &timer.port);
+
+    // nobody answers the reset
+    memset(&transaction, 0, sizeof(transaction));
+    transaction.reset = true;
+    transaction.rom_command = SKIP_ROM;
+    CHECK_EQUAL(runTransaction(&transaction), ONEWIRE_ASYNC_NO_PRESENCE);
+
+    onewire_sim_ds18b20Init(&thermometer, onewire_sim_serial(ONEWIRE_SIM_RANDOM, 0));
+    thermometer.temperature = 21 * 16 + 5;
+    onewire_sim_attach(&sim, &thermometer.device);
+
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        latency = pass ? LATENCY : 0;
+
+        // conversion started by a broadcast
+        memset(&transaction, 0, sizeof(transaction));
+        transaction.reset = true;
+        transaction.rom_command = SKIP_ROM;
+        command[0] = DS18B20_CONVERT_T;
+        transaction.tx = command;
+        transaction.tx_len = 1;
+        CHECK_EQUAL(runTransaction(&transaction), ONEWIRE_ASYNC_DONE);
+        CHECK(ds18b20_waitConversion(&bus));
+
+        // TH written, every write-0 kept short however late the interrupt
+        onewire_sim_clearCounters(&sim);
+        transaction.rom_command = MATCH_ROM;
+        transaction.address = thermometer.device.ROM;
+        command[0] = DS18B20_WRITE_SCRATCHPAD;
+        transaction.tx_len = 2;
+        CHECK_EQUAL(runTransaction(&transaction), ONEWIRE_ASYNC_DONE);
+        CHECK_EQUAL(thermometer.scratchpad[2], 0x4B);
+
+        onewire_sim_getCounters(&sim, &counter);
+        CHECK_EQUAL(counter.resets, 1);
+        CHECK(counter.write0 > 0);
+        CHECK(counter.slot_low_max <= WRITE0_LOW_MAX);
+
+        // scratchpad read back
+        memset(scratchpad, 0, sizeof(scratchpad));
+        command[0] = DS18B20_READ_SCRATCHPAD;
+        transaction.tx_len = 1;
+        transaction.rx = scratchpad;
+        transaction.rx_len = sizeof(scratchpad);
+        CHECK_EQUAL(runTransaction(&transaction), ONEWIRE_ASYNC_DONE);
+        CHECK(memcmp(scratchpad, thermometer.scratchpad, sizeof(scratchpad)) == 0);
+        CHECK_EQUAL(crc8(0, scratchpad, sizeof(scratchpad)), 0);
+        CHECK_EQUAL((int16_t)(scratchpad[0] | (scratchpad[1] << 8)), 21 * 16 + 5);
+        CHECK_EQUAL(scratchpad[2], 0x4B);
+    }
+
+    // a second transaction is refused while one runs
+    transaction.reset = true;
+    CHECK(onewire_async_submit(&engine, &transaction));
+    CHECK(!onewire_async_submit(&engine, &transaction));
+    CHECK(onewire_async_isBusy(&engine));
+    while (onewire_sim_timerRun(&timer, 1000000));
+    CHECK(!onewire_async_isBusy(&engine));
+
+    test_overdrive();
+
+    return TEST_RESULT();
+}
+
+
+//! \brief an EEPROM read at overdrive, the reset pulse kept below its
+//! 80 us max however late the interrupt
+//!
+void test_overdrive(void) {
+    onewire_sim_ds2431_t eeprom;
+    onewire_bus_t bus;
+    onewire_transaction_t transaction;
+    uint8_t command[3] = {ONEWIRE_MEMORY_READ, 0x00, 0x00};
+    uint8_t data[8];
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+    onewire_async_init(&engine, &bus, &timer.port);
+
+    onewire_sim_ds2431Init(&eeprom, onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000));
+    for (uint8_t i = 0; i < sizeof(data); i++) {
+        eeprom.memory[i] = i * 7 + 3;
+    }
+    onewire_sim_attach(&sim, &eeprom.device);
+    CHECK(onewire_overdriveSkip(&bus));
+
+    latency = LATENCY;
+
+    memset(&transaction, 0, sizeof(transaction));
+    transaction.reset = true;
+    transaction.rom_command = SKIP_ROM;
+    transaction.tx = command;
+    transaction.tx_len = sizeof(command);
+    transaction.rx = data;
+    transaction.rx_len = sizeof(data);
+    CHECK_EQUAL(runTransaction(&transaction), ONEWIRE_ASYNC_DONE);
+    CHECK(memcmp(data, eeprom.memory, sizeof(data)) == 0);
+    CHECK(eeprom.device.overdrive);
+}
+
+
+void timerIsr(void *arg) {
+    sim.now += latency;
+    onewire_async_tick((onewire_async_t*)arg);
+}
+
+
+//! \brief submit a transaction and run the main loop until it ends
+//! \return status of the transaction
+//!
+uint8_t runTransaction(onewire_transaction_t *transaction) {
+    CHECK(onewire_async_submit(&engine, transaction));
+
+    while (onewire_async_isBusy(&engine)) {
+        if (onewire_sim_timerRun(&timer, 1000000) == 0) {
+            CHECK(onewire_sim_timerRun(&timer, 1000000) != 0);
+            break;
+        }
+    }
+
+    return transaction->status;
+}
@@ -0,0 +1,374 @@
+//! \file test_cache.c
+//! \brief Address cache checked against simulated buses
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 21
+
+#include "onewire_sim.h"
+#include "onewire_cache.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define SLAVES          100
+#define POOL            300
+#define CAPACITY        255
+#define RUNS            200
+
+
+static onewire_sim_t sim;
+static onewire_bus_t bus;
+static onewire_sim_ds18b20_t pool[POOL];
+static bool attached[POOL];
+static uint32_t seed = 12345;
+
+static uint32_t random32(void);
+static void plug(uint16_t index, bool present);
+static void setup(uint16_t count);
+static uint16_t pick(bool present);
+static bool matchesSearch(const onewire_cache_t *cache);
+static void test_verify(void);
+static void test_save(void);
+static void test_refresh(void);
+static void test_update(void);
+static void test_updateRandom(void);
+static void test_updateMiss(void);
+static void report(void *context, const uint8_t *address, bool present);
+
+
+//! changes reported by onewire_cache_update()
+static uint8_t reported_added;
+static uint8_t reported_removed;
+static uint8_t reported_address[8];
+
+
+int main(void) {
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+
+    for (uint16_t i = 0; i < POOL; i++) {
+        onewire_sim_ds18b20Init(&pool[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        attached[i] = false;
+    }
+
+    test_verify();
+    test_save();
+    test_refresh();
+    test_update();
+    test_updateRandom();
+    test_updateMiss();
+
+    return TEST_RESULT();
+}
+
+
+//! \brief xorshift, fixed seed so that runs repeat
+//!
+uint32_t random32(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    return seed;
+}
+
+
+void plug(uint16_t index, bool present) {
+    if (present && !attached[index]) {
+        onewire_sim_attach(&sim, &pool[index].device);
+    }
+    else if (!present && attached[index]) {
+        onewire_sim_detach(&sim, &pool[index].device);
+    }
+
+    attached[index] = present;
+}
+
+
+//! \brief attach the first count slaves of the pool only
+//!
+void setup(uint16_t count) {
+    for (uint16_t i = 0; i < POOL; i++) {
+        plug(i, i < count);
+    }
+}
+
+
+//! \brief random slave of the pool, attached or not
+//!
+uint16_t pick(bool present) {
+    uint16_t index;
+
+    do {
+        index = random32() % POOL;
+    } while (attached[index] != present);
+
+    return index;
+}
+
+
+//! \brief the cache holds what a full search finds, in the same order
+//!
+bool matchesSearch(const onewire_cache_t *cache) {
+    static uint8_t address_box[CAPACITY][8];
+    uint8_t found = onewire_search(&bus, address_box, CAPACITY);
+
+    if (found != cache->count) {
+        return false;
+    }
+
+    return memcmp(address_box, cache->address_box, found * 8) == 0;
+}
+
+
+//! \brief removed and added slaves are seen
+//!
+void test_verify(void) {
+    static uint8_t address_box[CAPACITY][8];
+    onewire_cache_t cache;
+    uint16_t index;
+
+    onewire_cache_init(&cache, address_box, CAPACITY);
+    setup(0);
+    CHECK(onewire_cache_verify(&bus, &cache, false));
+
+    setup(SLAVES);
+    CHECK(!onewire_cache_verify(&bus, &cache, false));
+    CHECK(!onewire_cache_refresh(&bus, &cache, false));
+    CHECK_EQUAL(cache.count, SLAVES);
+    CHECK(matchesSearch(&cache));
+
+    CHECK(onewire_cache_verify(&bus, &cache, false));
+    CHECK(onewire_cache_verify(&bus, &cache, true));
+    CHECK(onewire_cache_refresh(&bus, &cache, false));
+
+    index = pick(true);
+    plug(index, false);
+    CHECK(!onewire_cache_verify(&bus, &cache, false));
+    plug(index, true);
+    CHECK(onewire_cache_verify(&bus, &cache, false));
+
+    index = pick(false);
+    plug(index, true);
+    CHECK(!onewire_cache_verify(&bus, &cache, false));
+    CHECK(!onewire_cache_verify(&bus, &cache, true));
+    plug(index, false);
+}
+
+
+//! \brief saved caches load back, damaged ones are refused
+//!
+void test_save(void) {
+    static uint8_t address_box[SLAVES][8];
+    static uint8_t loaded_box[SLAVES][8];
+    static uint8_t buffer[ONEWIRE_CACHE_SIZE(SLAVES)];
+    onewire_cache_t cache;
+    onewire_cache_t loaded;
+    uint16_t len;
+
+    setup(SLAVES);
+    onewire_cache_init(&cache, address_box, SLAVES);
+    onewire_cache_init(&loaded, loaded_box, SLAVES);
+    onewire_cache_refresh(&bus, &cache, false);
+
+    CHECK_EQUAL(onewire_cache_save(&cache, buffer, sizeof(buffer) - 1), 0);
+    len = onewire_cache_save(&cache, buffer, sizeof(buffer));
+    CHECK_EQUAL(len, sizeof(buffer));
+
+    CHECK(onewire_cache_load(&loaded, buffer, len));
+    CHECK_EQUAL(loaded.count, SLAVES);
+    CHECK(memcmp(loaded_box, address_box, sizeof(address_box)) == 0);
+    CHECK(onewire_cache_verify(&bus, &loaded, true));
+
+    buffer[1 + 8 * 40 + 3] ^= 0x10;
+    CHECK(!onewire_cache_load(&loaded, buffer, len));
+    CHECK_EQUAL(loaded.count, 0);
+}
+
+
+//! \brief random changes of a 100 slave bus, the cache is rebuilt to
+//! what a full search finds
+//!
+void test_refresh(void) {
+    static uint8_t address_box[CAPACITY][8];
+    static bool changed[POOL];
+    onewire_cache_t cache;
+
+    onewire_cache_init(&cache, address_box, CAPACITY);
+
+    for (uint16_t run = 0; run < RUNS; run++) {
+        uint8_t changes = 1 + random32() % 3;
+
+        setup(0);
+        for (uint16_t i = 0; i < SLAVES; i++) {
+            plug(pick(false), true);
+        }
+        onewire_cache_refresh(&bus, &cache, false);
+
+        // a slave removed in this run is not added back
+        memset(changed, 0, sizeof(changed));
+        for (uint8_t k = 0; k < changes; k++) {
+            uint16_t index;
+
+            do {
+                index = random32() % POOL;
+            } while (changed[index]);
+
+            changed[index] = true;
+            plug(index, !attached[index]);
+        }
+
+        CHECK(!onewire_cache_verify(&bus, &cache, false));
+        CHECK(!onewire_cache_refresh(&bus, &cache, false));
+        CHECK(matchesSearch(&cache));
+        CHECK(onewire_cache_verify(&bus, &cache, true));
+    }
+}
+
+
+void report(void *context, const uint8_t *address, bool present) {
+    (void)context;
+
+    if (present) {
+        reported_added++;
+    }
+    else {
+        reported_removed++;
+    }
+    memcpy(reported_address, address, 8);
+}
+
+
+//! \brief a slave added, removed or moved is reported alone
+//!
+void test_update(void) {
+    static uint8_t address_box[CAPACITY][8];
+    onewire_cache_t cache;
+    uint16_t index;
+    uint16_t other;
+
+    setup(SLAVES);
+    onewire_cache_init(&cache, address_box, CAPACITY);
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, false, report, NULL), SLAVES);
+    CHECK(matchesSearch(&cache));
+
+    reported_added = 0;
+    reported_removed = 0;
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, false, report, NULL), 0);
+
+    // added
+    index = pick(false);
+    plug(index, true);
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, true, report, NULL), 1);
+    CHECK_EQUAL(reported_added, 1);
+    CHECK(memcmp(reported_address, pool[index].device.ROM, 8) == 0);
+    CHECK(matchesSearch(&cache));
+
+    // removed
+    index = pick(true);
+    plug(index, false);
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, false, report, NULL), 1);
+    CHECK_EQUAL(reported_removed, 1);
+    CHECK(memcmp(reported_address, pool[index].device.ROM, 8) == 0);
+    CHECK(matchesSearch(&cache));
+
+    // moved: a probe swapped for another one
+    reported_added = 0;
+    reported_removed = 0;
+    index = pick(true);
+    other = pick(false);
+    plug(index, false);
+    plug(other, true);
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, true, report, NULL), 2);
+    CHECK_EQUAL(reported_added, 1);
+    CHECK_EQUAL(reported_removed, 1);
+    CHECK(matchesSearch(&cache));
+
+    // all gone, then back
+    setup(0);
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, false, report, NULL), SLAVES);
+    CHECK_EQUAL(cache.count, 0);
+    setup(SLAVES);
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, false, report, NULL), SLAVES);
+    CHECK(matchesSearch(&cache));
+}
+
+
+//! \brief three random changes of a 100 slave bus, the updated cache is
+//! what a full search finds
+//!
+void test_updateRandom(void) {
+    static uint8_t address_box[CAPACITY][8];
+    static bool changed[POOL];
+    onewire_cache_t cache;
+    uint16_t mismatches = 0;
+
+    onewire_cache_init(&cache, address_box, CAPACITY);
+
+    for (uint16_t run = 0; run < RUNS; run++) {
+        setup(0);
+        for (uint16_t i = 0; i < SLAVES; i++) {
+            plug(pick(false), true);
+        }
+        cache.count = 0;
+        onewire_cache_update(&bus, &cache, false, NULL, NULL);
+
+        memset(changed, 0, sizeof(changed));
+        for (uint8_t k = 0; k < 3; k++) {
+            uint16_t index;
+
+            do {
+                index = random32() % POOL;
+            } while (changed[index]);
+
+            changed[index] = true;
+            plug(index, !attached[index]);
+        }
+
+        CHECK_EQUAL(onewire_cache_update(&bus, &cache, false, NULL, NULL), 3);
+        mismatches += !matchesSearch(&cache);
+    }
+
+    CHECK_EQUAL(mismatches, 0);
+}
+
+
+//! \brief a new slave sharing ONEWIRE_CACHE_LEAF_DEPTH bits past the last
+//! branch of a cached path is missed by verify and update, strict mode
+//! finds it
+//!
+void test_updateMiss(void) {
+    static uint8_t address_box[CAPACITY][8];
+    onewire_sim_ds18b20_t twin;
+    onewire_cache_t cache;
+    const uint8_t *rom;
+    uint64_t serial = 0;
+    uint8_t depth = 0;
+
+    setup(SLAVES);
+    onewire_cache_init(&cache, address_box, CAPACITY);
+    onewire_cache_update(&bus, &cache, false, NULL, NULL);
+
+    // first bit past the checked depth of the first cached path
+    rom = address_box[0];
+    while (depth < 64 && ((rom[depth / 8] ^ address_box[1][depth / 8]) & (1 << (depth % 8))) == 0) {
+        depth++;
+    }
+    depth += 1 + ONEWIRE_CACHE_LEAF_DEPTH;
+    CHECK(depth >= 8 && depth < 56);
+
+    for (uint8_t i = 6; i > 0; i--) {
+        serial = (serial << 8) | rom[i];
+    }
+    onewire_sim_ds18b20Init(&twin, serial ^ (1ULL << (depth - 8)));
+    onewire_sim_attach(&sim, &twin.device);
+
+    CHECK(onewire_cache_verify(&bus, &cache, false));
+    CHECK(!onewire_cache_verify(&bus, &cache, true));
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, false, NULL, NULL), 0);
+    CHECK(!matchesSearch(&cache));
+    CHECK_EQUAL(onewire_cache_update(&bus, &cache, true, NULL, NULL), 1);
+    CHECK(matchesSearch(&cache));
+
+    onewire_sim_detach(&sim, &twin.device);
+}
@@ -0,0 +1,107 @@
+//! \file test_crc.c
+//! \brief Known CRC-8 and CRC-16 values for the three strategies
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 3
+
+#include "onewire_crc.h"
+#include "test.h"
+
+
+typedef struct strategy {
+    const char *name;
+    uint8_t (*update8)(uint8_t crc, uint8_t data);
+    uint16_t (*update16)(uint16_t crc, uint8_t data);
+} strategy_t;
+
+static const strategy_t strategies[] = {
+    {"bitwise", crc8_update_bitwise, crc16_update_bitwise},
+    {"nibble", crc8_update_nibble, crc16_update_nibble},
+    {"table", crc8_update_table, crc16_update_table},
+};
+
+
+//! ROM code of the Maxim application note 27 example, family code first
+static const uint8_t an27_rom[8] = {0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2};
+
+//! DS18B20 scratchpad at power-up, 85 C
+static const uint8_t ds18b20_scratchpad[9] = {
+    0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0x1C,
+};
+
+//! DS2431 WRITE SCRATCHPAD at address 0x0000, then the inverted CRC-16
+//! the device sends back, LSB first
+static const uint8_t ds2431_frame[13] = {
+    0x0F, 0x00, 0x00, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0xA3, 0x0A,
+};
+
+//! check string of the CRC catalogues
+static const uint8_t check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+
+static uint8_t run8(const strategy_t *strategy, const uint8_t *data, uint16_t len);
+static uint16_t run16(const strategy_t *strategy, const uint8_t *data, uint16_t len);
+
+
+int main(void) {
+    for (uint8_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+        const strategy_t *strategy = &strategies[i];
+
+        printf("%s\n", strategy->name);
+
+        // CRC-8/MAXIM
+        CHECK_EQUAL(run8(strategy, an27_rom, 7), 0xA2);
+        CHECK_EQUAL(run8(strategy, an27_rom, 8), 0);
+        CHECK_EQUAL(run8(strategy, ds18b20_scratchpad, 8), 0x1C);
+        CHECK_EQUAL(run8(strategy, ds18b20_scratchpad, 9), 0);
+        CHECK_EQUAL(run8(strategy, check, sizeof(check)), 0xA1);
+
+        // CRC-16/ARC, sent inverted by the devices
+        CHECK_EQUAL(run16(strategy, check, sizeof(check)), 0xBB3D);
+        CHECK_EQUAL(run16(strategy, ds2431_frame, 11), 0xF55C);
+        CHECK(crc16_check(run16(strategy, ds2431_frame, 11), &ds2431_frame[11]));
+        CHECK_EQUAL(run16(strategy, ds2431_frame, 13), 0xB001);
+
+        // every byte from every state agrees with the bitwise method
+        for (uint16_t crc = 0; crc < 256; crc++) {
+            for (uint16_t data = 0; data < 256; data++) {
+                uint16_t state = crc << 8 | data;
+                uint8_t actual8 = strategy->update8(crc, data);
+                uint16_t actual16 = strategy->update16(state, data);
+
+                CHECK_EQUAL(actual8, crc8_update_bitwise(crc, data));
+                CHECK_EQUAL(actual16, crc16_update_bitwise(state, data));
+            }
+        }
+    }
+
+    // buffer functions use the configured strategy
+    CHECK_EQUAL(crc8(0, an27_rom, 8), 0);
+    CHECK_EQUAL(crc8(0, check, sizeof(check)), 0xA1);
+    CHECK_EQUAL(crc16(0, check, sizeof(check)), 0xBB3D);
+    CHECK(crc16_check(crc16(0, ds2431_frame, 11), &ds2431_frame[11]));
+
+    return TEST_RESULT();
+}
+
+
+uint8_t run8(const strategy_t *strategy, const uint8_t *data, uint16_t len) {
+    uint8_t crc = 0;
+
+    for (uint16_t i = 0; i < len; i++) {
+        crc = strategy->update8(crc, data[i]);
+    }
+
+    return crc;
+}
+
+
+uint16_t run16(const strategy_t *strategy, const uint8_t *data, uint16_t len) {
+    uint16_t crc = 0;
+
+    for (uint16_t i = 0; i < len; i++) {
+        crc = strategy->update16(crc, data[i]);
+    }
+
+    return crc;
+}
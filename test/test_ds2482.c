@@ -0,0 +1,230 @@
+//! \file test_ds2482.c
+//! \brief DS2482 physical layer against a simulated bridge
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 15
+
+#include "onewire_sim.h"
+#include "onewire_memory.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define THERMOMETERS    12
+#define EEPROMS         4
+
+
+static onewire_sim_ds18b20_t thermometer[THERMOMETERS];
+static onewire_sim_ds2431_t eeprom[EEPROMS];
+static onewire_sim_ds2431_t channel_eeprom[DS2482_800_CHANNELS];
+
+static bool isFound(const uint8_t *ROM, uint8_t address_box[][8], uint8_t count);
+static void test_search(void);
+static void test_channels(void);
+static void test_overdrive(void);
+static void test_memory(void);
+
+
+int main(void) {
+    test_search();
+    test_channels();
+    test_overdrive();
+    test_memory();
+
+    return TEST_RESULT();
+}
+
+
+bool isFound(const uint8_t *ROM, uint8_t address_box[][8], uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (memcmp(ROM, address_box[i], 8) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//! \brief a mixed bus enumerated with 1-Wire Triplet commands
+//!
+void test_search(void) {
+    uint8_t address_box[THERMOMETERS + EEPROMS + 1][8];
+    onewire_sim_t sim;
+    onewire_sim_t *lines[DS2482_100_CHANNELS] = {&sim};
+    onewire_sim_ds2482_t simulated;
+    onewire_ds2482_t bridge;
+    onewire_bus_t bus;
+    uint8_t found;
+    uint8_t missing = 0;
+
+    onewire_sim_init(&sim);
+    onewire_sim_ds2482Init(&simulated, lines, DS2482_100_CHANNELS, DS2482_ADDRESS);
+    CHECK(onewire_ds2482_init(&bridge, &simulated.port, DS2482_ADDRESS, DS2482_100_CHANNELS));
+    onewire_ds2482_busInit(&bus, &bridge, 0);
+
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        onewire_sim_attach(&sim, &thermometer[i].device);
+    }
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        onewire_sim_ds2431Init(&eeprom[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000 + i));
+        onewire_sim_attach(&sim, &eeprom[i].device);
+    }
+
+    // one I2C write and one status poll per search bit, not three slots
+    simulated.transactions = 0;
+    found = onewire_search(&bus, address_box, THERMOMETERS + EEPROMS + 1);
+    CHECK_EQUAL(found, THERMOMETERS + EEPROMS);
+    CHECK(simulated.transactions < (uint32_t)found * 64 * 3);
+
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        missing += !isFound(thermometer[i].device.ROM, address_box, found);
+    }
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        missing += !isFound(eeprom[i].device.ROM, address_box, found);
+    }
+    CHECK_EQUAL(missing, 0);
+
+    found = onewire_searchFamily(&bus, DS2431_FAMILY_CODE, address_box, EEPROMS + 1);
+    CHECK_EQUAL(found, EEPROMS);
+
+    // nothing answers on an empty line
+    onewire_sim_init(&sim);
+    CHECK_EQUAL(onewire_search(&bus, address_box, 1), 0);
+    CHECK(!onewire_reset(&bus));
+}
+
+
+//! \brief each bus of a DS2482-800 reaches the line of its own channel,
+//! in any order
+//!
+void test_channels(void) {
+    static const uint8_t order[] = {0, 1, 2, 3, 4, 5, 6, 7, 5, 0, 7, 2, 2, 6, 1, 3, 4};
+    onewire_sim_t sim[DS2482_800_CHANNELS];
+    onewire_sim_t *lines[DS2482_800_CHANNELS];
+    onewire_sim_ds2482_t simulated;
+    onewire_ds2482_t bridge;
+    onewire_bus_t bus[DS2482_800_CHANNELS];
+    uint8_t address[8];
+
+    for (uint8_t i = 0; i < DS2482_800_CHANNELS; i++) {
+        onewire_sim_init(&sim[i]);
+        lines[i] = &sim[i];
+        onewire_sim_ds2431Init(&channel_eeprom[i],
+                               onewire_sim_serial(ONEWIRE_SIM_SEQUENTIAL, 2000 + i));
+        onewire_sim_attach(&sim[i], &channel_eeprom[i].device);
+    }
+    onewire_sim_ds2482Init(&simulated, lines, DS2482_800_CHANNELS, DS2482_ADDRESS + 3);
+
+    // a bridge at another address does not answer
+    CHECK(!onewire_ds2482_init(&bridge, &simulated.port, DS2482_ADDRESS, DS2482_800_CHANNELS));
+    CHECK(onewire_ds2482_init(&bridge, &simulated.port, DS2482_ADDRESS + 3,
+                              DS2482_800_CHANNELS));
+
+    for (uint8_t i = 0; i < DS2482_800_CHANNELS; i++) {
+        onewire_ds2482_busInit(&bus[i], &bridge, i);
+    }
+
+    for (uint8_t i = 0; i < sizeof(order); i++) {
+        uint8_t channel = order[i];
+
+        CHECK(onewire_getSlaveAddress(&bus[channel], address));
+        CHECK_EQUAL(simulated.channel, channel);
+        CHECK_EQUAL(bridge.channel, channel);
+        CHECK(memcmp(address, channel_eeprom[channel].device.ROM, 8) == 0);
+    }
+
+    // an empty line answers on its own channel only
+    onewire_sim_detach(&sim[4], &channel_eeprom[4].device);
+    CHECK(!onewire_reset(&bus[4]));
+    CHECK(onewire_reset(&bus[5]));
+    CHECK_EQUAL(simulated.channel, 5);
+}
+
+
+//! \brief the timing profile of a bus sets the 1WS bit before its next
+//! operation, searches and reads run at overdrive
+//!
+void test_overdrive(void) {
+    const onewire_memory_t *model = &onewire_memory_ds2431;
+    uint8_t address_box[EEPROMS + 1][8];
+    onewire_sim_t sim;
+    onewire_sim_t *lines[DS2482_100_CHANNELS] = {&sim};
+    onewire_sim_ds2482_t simulated;
+    onewire_ds2482_t bridge;
+    onewire_bus_t bus;
+    uint8_t data[16];
+
+    onewire_sim_init(&sim);
+    onewire_sim_ds2482Init(&simulated, lines, DS2482_100_CHANNELS, DS2482_ADDRESS);
+    CHECK(onewire_ds2482_init(&bridge, &simulated.port, DS2482_ADDRESS, DS2482_100_CHANNELS));
+    onewire_ds2482_busInit(&bus, &bridge, 0);
+
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        onewire_sim_ds2431Init(&eeprom[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000 + i));
+        for (uint8_t j = 0; j < sizeof(data); j++) {
+            eeprom[i].memory[j] = i * 16 + j;
+        }
+        onewire_sim_attach(&sim, &eeprom[i].device);
+    }
+
+    CHECK(onewire_overdriveSkip(&bus));
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        CHECK(eeprom[i].device.overdrive);
+    }
+
+    CHECK_EQUAL(onewire_search(&bus, address_box, EEPROMS + 1), EEPROMS);
+    CHECK(simulated.config & DS2482_CONFIG_1WS);
+    CHECK(simulated.config & DS2482_CONFIG_APU);
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        CHECK(isFound(eeprom[i].device.ROM, address_box, EEPROMS));
+        CHECK_EQUAL(onewire_memory_readBuffer(&bus, eeprom[i].device.ROM, model, 0,
+                                              data, sizeof(data)), ONEWIRE_OK);
+        CHECK(memcmp(data, eeprom[i].memory, sizeof(data)) == 0);
+    }
+
+    // the standard reset goes out with 1WS cleared
+    CHECK(onewire_standardSpeed(&bus));
+    CHECK(!(simulated.config & DS2482_CONFIG_1WS));
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        CHECK(!eeprom[i].device.overdrive);
+    }
+    CHECK_EQUAL(onewire_memory_readBuffer(&bus, eeprom[0].device.ROM, model, 0,
+                                          data, sizeof(data)), ONEWIRE_OK);
+    CHECK(memcmp(data, eeprom[0].memory, sizeof(data)) == 0);
+}
+
+
+//! \brief pages written through the bridge, tPROG waited by the I2C port
+//!
+void test_memory(void) {
+    const onewire_memory_t *model = &onewire_memory_ds2431;
+    const uint8_t *address = eeprom[0].device.ROM;
+    onewire_sim_t sim;
+    onewire_sim_t *lines[DS2482_100_CHANNELS] = {&sim};
+    onewire_sim_ds2482_t simulated;
+    onewire_ds2482_t bridge;
+    onewire_bus_t bus;
+    uint8_t image[32];
+    uint8_t data[32];
+
+    onewire_sim_init(&sim);
+    onewire_sim_ds2482Init(&simulated, lines, DS2482_100_CHANNELS, DS2482_ADDRESS);
+    CHECK(onewire_ds2482_init(&bridge, &simulated.port, DS2482_ADDRESS, DS2482_100_CHANNELS));
+    onewire_ds2482_busInit(&bus, &bridge, 0);
+
+    onewire_sim_ds2431Init(&eeprom[0], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000));
+    onewire_sim_attach(&sim, &eeprom[0].device);
+
+    for (uint8_t i = 0; i < sizeof(image); i++) {
+        image[i] = i * 7 + 3;
+    }
+
+    CHECK_EQUAL(onewire_memory_write(&bus, address, model, 0, image, sizeof(image)), ONEWIRE_OK);
+    CHECK(memcmp(eeprom[0].memory, image, sizeof(image)) == 0);
+
+    CHECK_EQUAL(onewire_memory_readBuffer(&bus, address, model, 0, data, sizeof(data)),
+                ONEWIRE_OK);
+    CHECK(memcmp(data, image, sizeof(image)) == 0);
+}
@@ -0,0 +1,173 @@
+//! \file test_group.c
+//! \brief Resets of a bus group with absent slaves and stuck lines,
+//! per-line data and thermometers read in lockstep
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 13
+
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+#include "test.h"
+
+#include <string.h>
+
+
+static onewire_sim_t sim[8];
+static onewire_sim_t *lines[8];
+static onewire_sim_ds18b20_t thermometer[16];
+
+static void setup(void);
+static void test_reset(void);
+static void test_select(void);
+static void test_temperature(void);
+
+
+int main(void) {
+    test_reset();
+    test_select();
+    test_temperature();
+
+    return TEST_RESULT();
+}
+
+
+void setup(void) {
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        onewire_sim_init(&sim[pin]);
+        lines[pin] = &sim[pin];
+    }
+}
+
+
+//! \brief presence of each line, stuck lines and slot timing
+//!
+void test_reset(void) {
+    onewire_timing_t timing = onewire_timing_standard;
+    onewire_group_t group;
+
+    setup();
+    for (uint8_t pin = 0; pin < 3; pin++) {
+        onewire_sim_ds18b20Init(&thermometer[pin], onewire_sim_serial(ONEWIRE_SIM_SEQUENTIAL, pin));
+        onewire_sim_attach(&sim[pin], &thermometer[pin].device);
+    }
+
+    host_onewire_groupInit(&group, lines, 0x0F);
+    CHECK_EQUAL(onewire_group_reset(&group), 0x07);
+
+    // lines shorted to ground are not reported as present
+    sim[1].slave_low = 0;
+    sim[1].slave_release = UINT64_MAX;
+    sim[3].slave_low = 0;
+    sim[3].slave_release = UINT64_MAX;
+    CHECK_EQUAL(onewire_group_reset(&group), 0x05);
+
+    // a write-0 shorter than a write-1 is extended to it
+    timing.write1_low = timing.write0_low + ONEWIRE_US(1);
+    onewire_group_setTiming(&group, &timing);
+    CHECK_EQUAL(group.delay.write0_low, group.delay.write1_low);
+}
+
+
+//! \brief one slave of two selected on each line, different bytes written
+//! to each and read back untangled
+//!
+void test_select(void) {
+    uint8_t address[8][8];
+    uint8_t data[8];
+    uint8_t scratchpad[8][DS18B20_SCRATCHPAD_SIZE];
+    onewire_group_t group;
+
+    setup();
+    for (uint8_t i = 0; i < 16; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        onewire_sim_attach(&sim[i / 2], &thermometer[i].device);
+    }
+
+    // first slave on even lines, second on odd ones
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        memcpy(address[pin], thermometer[pin * 2 + (pin & 1)].device.ROM, 8);
+    }
+
+    host_onewire_groupInit(&group, lines, 0xFF);
+
+    CHECK_EQUAL(onewire_group_select(&group, address), 0xFF);
+    onewire_group_send(&group, DS18B20_WRITE_SCRATCHPAD);
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        data[pin] = 1 << pin;
+    }
+    onewire_group_sendEach(&group, data);
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        data[pin] = 0xF0 - pin * 3;
+    }
+    onewire_group_sendEach(&group, data);
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        data[pin] = (pin & 0x03) << 5 | 0x1F;
+    }
+    onewire_group_sendEach(&group, data);
+
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        const onewire_sim_ds18b20_t *selected = &thermometer[pin * 2 + (pin & 1)];
+        const onewire_sim_ds18b20_t *other = &thermometer[pin * 2 + !(pin & 1)];
+
+        CHECK_EQUAL(selected->scratchpad[2], 1 << pin);
+        CHECK_EQUAL(selected->scratchpad[3], 0xF0 - pin * 3);
+        CHECK_EQUAL(selected->scratchpad[4], (pin & 0x03) << 5 | 0x1F);
+        CHECK_EQUAL(other->scratchpad[2], 75);
+    }
+
+    // pin k gets its own 9 bytes at scratchpad[k]
+    CHECK_EQUAL(onewire_group_select(&group, address), 0xFF);
+    onewire_group_send(&group, DS18B20_READ_SCRATCHPAD);
+    onewire_group_receiveBuffer(&group, scratchpad, DS18B20_SCRATCHPAD_SIZE);
+
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        const onewire_sim_ds18b20_t *selected = &thermometer[pin * 2 + (pin & 1)];
+
+        CHECK(memcmp(scratchpad[pin], selected->scratchpad, DS18B20_SCRATCHPAD_SIZE) == 0);
+    }
+}
+
+
+//! \brief a different thermometer on each line, one line empty
+//!
+void test_temperature(void) {
+    uint8_t address[8][8] = {{0}};
+    int16_t temperature[8];
+    onewire_group_t group;
+
+    setup();
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        if (pin == 5) {
+            continue;
+        }
+        onewire_sim_ds18b20Init(&thermometer[pin],
+                                onewire_sim_serial(ONEWIRE_SIM_RANDOM, 100 + pin));
+        thermometer[pin].temperature = (pin - 3) * 150 + pin;
+        onewire_sim_attach(&sim[pin], &thermometer[pin].device);
+        memcpy(address[pin], thermometer[pin].device.ROM, 8);
+    }
+
+    host_onewire_groupInit(&group, lines, 0xFF);
+
+    CHECK_EQUAL(ds18b20_groupConvertAll(&group), 0xDF);
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        onewire_sim_advance(&sim[pin], 750000000);
+    }
+
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        temperature[pin] = DS18B20_NO_READING;
+    }
+    CHECK_EQUAL(ds18b20_groupReadTemperature(&group, address, temperature), 0xDF);
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        CHECK_EQUAL(temperature[pin], (pin == 5) ? DS18B20_NO_READING : (pin - 3) * 150 + pin);
+    }
+
+    // single-drop lines skip the ROM
+    thermometer[2].temperature = -55 * 16;
+    CHECK_EQUAL(ds18b20_groupConvertAll(&group), 0xDF);
+    for (uint8_t pin = 0; pin < 8; pin++) {
+        onewire_sim_advance(&sim[pin], 750000000);
+    }
+    CHECK_EQUAL(ds18b20_groupReadTemperature(&group, NULL, temperature), 0xDF);
+    CHECK_EQUAL(temperature[2], -55 * 16);
+    CHECK_EQUAL(temperature[7], 4 * 150 + 7);
+}
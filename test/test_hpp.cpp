@@ -0,0 +1,153 @@
+//! \file test_hpp.cpp
+//! \brief C++ layer of onewire.hpp on a simulated line, both lock policies
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 13
+
+#include "onewire.hpp"
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define THERMOMETERS    3
+
+
+// example of Maxim application note 27, checked at compile time
+static_assert(onewire::Rom(0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2).valid(),
+                "Rom::valid() must be usable in constant expressions");
+static_assert(!onewire::Rom(0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA3).valid(),
+                "a wrong CRC must be caught at compile time");
+static_assert(!onewire::Rom().valid(), "all-zero ROM codes are invalid");
+
+static onewire_sim_t sim;
+static onewire_sim_ds18b20_t thermometer[THERMOMETERS];
+
+struct SimPhy {
+    static void init(onewire_bus_t *bus) { host_onewire_init(bus, &sim); }
+};
+
+template <typename Lock>
+using SimBus = onewire::Bus<SimPhy, onewire::timing::Standard, Lock>;
+
+template <typename Lock>
+using SimTransaction = onewire::Transaction<SimPhy, onewire::timing::Standard, Lock>;
+
+template <typename Lock>
+static void test_bus(void);
+static void test_lock(void);
+
+
+int main(void) {
+    test_bus<onewire::lock::None>();
+    test_bus<onewire::lock::Flag>();
+    test_lock();
+
+    return TEST_RESULT();
+}
+
+
+//! \brief search, transactions and transfers give what the C API gives
+//!
+template <typename Lock>
+void test_bus(void) {
+    SimBus<Lock> bus;
+    onewire::Rom roms[THERMOMETERS + 1];
+    uint8_t command[] = {DS18B20_READ_SCRATCHPAD};
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_SIZE];
+
+    onewire_sim_init(&sim);
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        onewire_sim_attach(&sim, &thermometer[i].device);
+    }
+
+    CHECK(memcmp(bus.native()->timing, &onewire_timing_standard, sizeof(onewire_timing_t)) == 0);
+    CHECK(bus.reset());
+    CHECK_EQUAL(bus.search(roms), THERMOMETERS);
+    CHECK_EQUAL(bus.searchFamily(DS18B20_FAMILY_CODE, roms), THERMOMETERS);
+    CHECK_EQUAL(bus.searchFamily(DS2431_FAMILY_CODE, roms), 0);
+    CHECK_EQUAL(bus.search(roms), THERMOMETERS);
+
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        const onewire::Rom &rom = roms[i];
+        uint8_t j = 0;
+
+        CHECK(rom.valid());
+        CHECK_EQUAL(rom.family(), DS18B20_FAMILY_CODE);
+        while (j < THERMOMETERS && rom != onewire::Rom::from(thermometer[j].device.ROM)) {
+            j++;
+        }
+        CHECK(j < THERMOMETERS);
+
+        if (SimTransaction<Lock> t{bus, rom}) {
+            t.send(DS18B20_READ_SCRATCHPAD);
+            t.receive(scratchpad);
+            CHECK(memcmp(scratchpad, thermometer[j].scratchpad, sizeof(scratchpad)) == 0);
+        }
+        else {
+            CHECK(false);
+        }
+
+        memset(scratchpad, 0, sizeof(scratchpad));
+        CHECK_EQUAL(bus.transfer(rom, command, scratchpad, ONEWIRE_CHECK_CRC8), ONEWIRE_OK);
+        CHECK(memcmp(scratchpad, thermometer[j].scratchpad, sizeof(scratchpad)) == 0);
+    }
+
+    // nothing answers on an empty line
+    onewire_sim_init(&sim);
+    CHECK(!bus.reset());
+    CHECK(!SimTransaction<Lock>{bus});
+    CHECK_EQUAL(bus.transfer(command, scratchpad, ONEWIRE_CHECK_CRC8), ONEWIRE_NO_PRESENCE);
+}
+
+
+//! \brief lock::Flag refuses a nested transaction until the first ends,
+//! lock::None lets it through
+//!
+void test_lock(void) {
+    SimBus<onewire::lock::None> open;
+    SimBus<onewire::lock::Flag> locked;
+
+    onewire_sim_init(&sim);
+    onewire_sim_ds18b20Init(&thermometer[0], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 0));
+    onewire_sim_attach(&sim, &thermometer[0].device);
+
+    {
+        SimTransaction<onewire::lock::None> a{open};
+        SimTransaction<onewire::lock::None> b{open};
+
+        CHECK(a);
+        CHECK(b);
+    }
+
+    {
+        SimTransaction<onewire::lock::Flag> a{locked};
+        SimTransaction<onewire::lock::Flag> b{locked};
+
+        CHECK(a);
+        CHECK(!b);
+    }
+
+    // released when the owner is destroyed, not by the refused one
+    {
+        SimTransaction<onewire::lock::Flag> a{locked};
+
+        CHECK(a);
+    }
+
+    // a transaction without presence still releases the lock
+    onewire_sim_detach(&sim, &thermometer[0].device);
+    {
+        SimTransaction<onewire::lock::Flag> a{locked};
+
+        CHECK(!a);
+    }
+    onewire_sim_attach(&sim, &thermometer[0].device);
+    {
+        SimTransaction<onewire::lock::Flag> a{locked};
+
+        CHECK(a);
+    }
+}
@@ -0,0 +1,281 @@
+//! \file test_registry.c
+//! \brief Sorted address registry in RAM and in flash, filled by a search
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 22
+
+#include "onewire_registry.h"
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+#include "onewire_crc.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define THERMOMETERS    6
+#define EEPROMS         3
+
+
+//! family 0x28 serials 5 and 9, family 0xFF serial 1, in registry order
+static const uint8_t flash_entries[][ONEWIRE_REGISTRY_ENTRY] ONEWIRE_REGISTRY_FLASH = {
+    {0x28, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0x28, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00},
+    {0xFF, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00},
+};
+
+static onewire_sim_ds18b20_t thermometer[THERMOMETERS];
+static onewire_sim_ds2431_t eeprom[EEPROMS];
+
+static void makeAddress(uint8_t *address, uint8_t family_code, uint32_t serial);
+static bool isSorted(const onewire_registry_t *registry);
+static void test_add(void);
+static void test_family(void);
+static void test_flash(void);
+static void test_scan(void);
+
+
+int main(void) {
+    test_add();
+    test_family();
+    test_flash();
+    test_scan();
+
+    return TEST_RESULT();
+}
+
+
+//! \brief build an address with a valid CRC, serial stored LSB first
+//!
+void makeAddress(uint8_t *address, uint8_t family_code, uint32_t serial) {
+    address[0] = family_code;
+    for (uint8_t i = 1; i < 7; i++) {
+        address[i] = serial & 0xFF;
+        serial >>= 8;
+    }
+    address[7] = crc8(0, address, 7);
+}
+
+
+bool isSorted(const onewire_registry_t *registry) {
+    for (uint8_t i = 1; i < registry->count; i++) {
+        if (memcmp(registry->entries[i - 1], registry->entries[i], ONEWIRE_REGISTRY_ENTRY) >= 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+//! \brief entries kept sorted through adds and removes, duplicates, bad
+//! CRCs and a full registry refused without a new entry
+//!
+void test_add(void) {
+    static const uint8_t family[] = {0x28, 0x10, 0x2D, 0x28, 0x01, 0x3A, 0x28, 0x10};
+    uint8_t entries[8][ONEWIRE_REGISTRY_ENTRY];
+    uint8_t address[8];
+    uint8_t other[8];
+    onewire_registry_t registry;
+
+    onewire_registry_init(&registry, entries, 8);
+    CHECK_EQUAL(registry.count, 0);
+
+    makeAddress(address, 0x28, 1);
+    CHECK_EQUAL(onewire_registry_find(&registry, address), -1);
+    CHECK(!onewire_registry_remove(&registry, address));
+
+    // inserted out of order, serials decreasing within a family
+    for (uint8_t i = 0; i < 8; i++) {
+        makeAddress(address, family[i], 1000 - i * 7);
+        CHECK(onewire_registry_add(&registry, address));
+        CHECK(isSorted(&registry));
+    }
+    CHECK_EQUAL(registry.count, 8);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        int16_t index;
+
+        makeAddress(address, family[i], 1000 - i * 7);
+        index = onewire_registry_find(&registry, address);
+        CHECK(index >= 0);
+
+        // the CRC byte is ignored by lookups and rebuilt by get
+        address[7] ^= 0x5A;
+        CHECK_EQUAL(onewire_registry_find(&registry, address), index);
+        onewire_registry_get(&registry, index, other);
+        address[7] ^= 0x5A;
+        CHECK(memcmp(other, address, 8) == 0);
+    }
+
+    // a duplicate succeeds without a new entry, even when full
+    makeAddress(address, 0x2D, 1000 - 2 * 7);
+    CHECK(onewire_registry_add(&registry, address));
+    CHECK_EQUAL(registry.count, 8);
+
+    makeAddress(address, 0x28, 2);
+    CHECK(!onewire_registry_add(&registry, address));
+    CHECK_EQUAL(registry.count, 8);
+    CHECK_EQUAL(onewire_registry_find(&registry, address), -1);
+
+    // removed from the middle, the order is kept and the slot reused
+    makeAddress(other, 0x28, 1000 - 3 * 7);
+    CHECK(onewire_registry_remove(&registry, other));
+    CHECK(!onewire_registry_remove(&registry, other));
+    CHECK_EQUAL(registry.count, 7);
+    CHECK_EQUAL(onewire_registry_find(&registry, other), -1);
+    CHECK(isSorted(&registry));
+
+    // a wrong CRC is refused, a right one fills the free slot
+    address[7] ^= 0x01;
+    CHECK(!onewire_registry_add(&registry, address));
+    CHECK_EQUAL(registry.count, 7);
+    address[7] ^= 0x01;
+    CHECK(onewire_registry_add(&registry, address));
+    CHECK_EQUAL(registry.count, 8);
+    CHECK(isSorted(&registry));
+
+    // first and last entries
+    makeAddress(address, 0x01, 1000 - 4 * 7);
+    CHECK_EQUAL(onewire_registry_find(&registry, address), 0);
+    makeAddress(address, 0x3A, 1000 - 5 * 7);
+    CHECK_EQUAL(onewire_registry_find(&registry, address), 7);
+    CHECK(onewire_registry_remove(&registry, address));
+    makeAddress(address, 0x01, 1000 - 4 * 7);
+    CHECK(onewire_registry_remove(&registry, address));
+    CHECK_EQUAL(registry.count, 6);
+    CHECK(isSorted(&registry));
+}
+
+
+//! \brief family ranges at both ends of the code space and absent ones
+//!
+void test_family(void) {
+    static const uint8_t family[] = {0x00, 0x28, 0x28, 0x28, 0x2D, 0xFE, 0xFF, 0xFF};
+    uint8_t entries[8][ONEWIRE_REGISTRY_ENTRY];
+    uint8_t address[8];
+    onewire_registry_t registry;
+    uint8_t first;
+
+    onewire_registry_init(&registry, entries, 8);
+    CHECK_EQUAL(onewire_registry_family(&registry, 0xFF, &first), 0);
+    CHECK_EQUAL(first, 0);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        makeAddress(address, family[i], i);
+        CHECK(onewire_registry_add(&registry, address));
+    }
+
+    CHECK_EQUAL(onewire_registry_family(&registry, 0x00, &first), 1);
+    CHECK_EQUAL(first, 0);
+    CHECK_EQUAL(onewire_registry_family(&registry, 0x28, &first), 3);
+    CHECK_EQUAL(first, 1);
+    CHECK_EQUAL(onewire_registry_family(&registry, 0x2D, &first), 1);
+    CHECK_EQUAL(first, 4);
+    CHECK_EQUAL(onewire_registry_family(&registry, 0xFE, &first), 1);
+    CHECK_EQUAL(first, 5);
+    CHECK_EQUAL(onewire_registry_family(&registry, 0xFF, &first), 2);
+    CHECK_EQUAL(first, 6);
+
+    // absent families are empty at their sorted position
+    CHECK_EQUAL(onewire_registry_family(&registry, 0x10, &first), 0);
+    CHECK_EQUAL(first, 1);
+    CHECK_EQUAL(onewire_registry_family(&registry, 0x80, &first), 0);
+    CHECK_EQUAL(first, 5);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        onewire_registry_get(&registry, i, address);
+        CHECK_EQUAL(address[0], family[i]);
+        CHECK_EQUAL(crc8(0, address, 8), 0);
+    }
+}
+
+
+//! \brief a table in flash is searched but never changed
+//!
+void test_flash(void) {
+    onewire_registry_t registry;
+    onewire_bus_t bus;
+    onewire_sim_t sim;
+    uint8_t address[8];
+    uint8_t first;
+
+    onewire_registry_initFlash(&registry, flash_entries, 3);
+    CHECK_EQUAL(registry.count, 3);
+
+    makeAddress(address, 0x28, 9);
+    CHECK_EQUAL(onewire_registry_find(&registry, address), 1);
+    CHECK(!onewire_registry_remove(&registry, address));
+    CHECK_EQUAL(registry.count, 3);
+
+    makeAddress(address, 0x28, 7);
+    CHECK(!onewire_registry_add(&registry, address));
+    CHECK_EQUAL(registry.count, 3);
+    CHECK_EQUAL(onewire_registry_find(&registry, address), -1);
+
+    CHECK_EQUAL(onewire_registry_family(&registry, 0x28, &first), 2);
+    CHECK_EQUAL(first, 0);
+    CHECK_EQUAL(onewire_registry_family(&registry, 0xFF, &first), 1);
+    CHECK_EQUAL(first, 2);
+
+    onewire_registry_get(&registry, 2, address);
+    CHECK_EQUAL(address[1], 0x01);
+    CHECK_EQUAL(crc8(0, address, 8), 0);
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+    onewire_sim_ds18b20Init(&thermometer[0], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 0));
+    onewire_sim_attach(&sim, &thermometer[0].device);
+    CHECK_EQUAL(onewire_registry_scan(&bus, &registry), 0);
+    CHECK_EQUAL(registry.count, 3);
+}
+
+
+//! \brief a search replaces the entries, up to the capacity
+//!
+void test_scan(void) {
+    uint8_t entries[THERMOMETERS + EEPROMS][ONEWIRE_REGISTRY_ENTRY];
+    uint8_t address[8];
+    onewire_registry_t registry;
+    onewire_bus_t bus;
+    onewire_sim_t sim;
+    uint8_t first;
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        onewire_sim_attach(&sim, &thermometer[i].device);
+    }
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        onewire_sim_ds2431Init(&eeprom[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000 + i));
+        onewire_sim_attach(&sim, &eeprom[i].device);
+    }
+
+    // stale entries are dropped
+    onewire_registry_init(&registry, entries, THERMOMETERS + EEPROMS);
+    makeAddress(address, 0x28, 123);
+    CHECK(onewire_registry_add(&registry, address));
+
+    CHECK_EQUAL(onewire_registry_scan(&bus, &registry), THERMOMETERS + EEPROMS);
+    CHECK_EQUAL(onewire_registry_find(&registry, address), -1);
+    CHECK(isSorted(&registry));
+
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        CHECK(onewire_registry_find(&registry, thermometer[i].device.ROM) >= 0);
+    }
+    for (uint8_t i = 0; i < EEPROMS; i++) {
+        CHECK(onewire_registry_find(&registry, eeprom[i].device.ROM) >= 0);
+    }
+
+    CHECK_EQUAL(onewire_registry_family(&registry, DS18B20_FAMILY_CODE, &first), THERMOMETERS);
+    CHECK_EQUAL(onewire_registry_family(&registry, DS2431_FAMILY_CODE, &first), EEPROMS);
+
+    // one pass per entry, the slaves after them are left out
+    onewire_registry_init(&registry, entries, 4);
+    CHECK_EQUAL(onewire_registry_scan(&bus, &registry), 4);
+    CHECK(isSorted(&registry));
+
+    onewire_sim_init(&sim);
+    CHECK_EQUAL(onewire_registry_scan(&bus, &registry), 0);
+}
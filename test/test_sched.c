@@ -0,0 +1,162 @@
+//! \file test_sched.c
+//! \brief Deadline misses and bus time of the polling scheduler
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 25
+//!
+//! Runs onewire_sim_benchmarkScheduler() for a minute of virtual time and
+//! checks its rows: no sample missed while the buses have room, misses
+//! once they are overloaded, and bus time between the slots of the reads
+//! alone and the slots of reads and conversions.
+
+#include "onewire_sim.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define DURATION        60000
+
+//! standard speed, us: reset, one slot
+#define RESET_TIME      960
+#define SLOT_TIME       70
+
+//! MATCH ROM, READ SCRATCHPAD and 9 bytes, then a SKIP ROM CONVERT T
+#define READ_TIME       (RESET_TIME + (8 + 64 + 8 + 9 * 8) * SLOT_TIME)
+#define CONVERT_TIME    (RESET_TIME + 16 * SLOT_TIME)
+
+
+typedef struct row {
+    unsigned sensors;
+    unsigned reads;
+    unsigned failures;
+    unsigned missed;
+    unsigned jitter;
+    double utilisation;
+} row_t;
+
+static uint8_t runScheduler(uint16_t sensors, uint8_t lines, uint16_t window, row_t *rows);
+static void checkBusTime(const row_t *row, uint8_t lines);
+static uint32_t expectedReads(uint16_t sensors, uint8_t lines);
+
+
+int main(void) {
+    row_t rows[9];
+    uint8_t count;
+
+    // one line, conversions batched: every deadline is met
+    count = runScheduler(8, 1, 750, rows);
+    CHECK_EQUAL(count, 2);
+    CHECK_EQUAL(rows[1].missed, 0);
+    CHECK_EQUAL(rows[1].failures, 0);
+    CHECK(rows[1].reads <= expectedReads(8, 1));
+    CHECK(rows[1].reads + 8 >= expectedReads(8, 1));
+    checkBusTime(&rows[1], 1);
+
+    // a conversion per sensor, each one waiting for the previous one
+    count = runScheduler(8, 1, 0, rows);
+    CHECK_EQUAL(count, 2);
+    CHECK(rows[1].missed > 0);
+    CHECK_EQUAL(rows[1].failures, 0);
+
+    // four lines served by one CPU
+    count = runScheduler(64, 4, 750, rows);
+    CHECK_EQUAL(count, 5);
+    for (uint8_t i = 0; i < count; i++) {
+        CHECK_EQUAL(rows[i].missed, 0);
+        CHECK_EQUAL(rows[i].failures, 0);
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        checkBusTime(&rows[i], 1);
+    }
+    checkBusTime(&rows[4], 4);
+    CHECK(rows[4].reads <= expectedReads(64, 4));
+    CHECK(rows[4].reads + 64 >= expectedReads(64, 4));
+
+    // a busy line stays within its deadlines
+    count = runScheduler(100, 1, 750, rows);
+    CHECK_EQUAL(rows[1].missed, 0);
+    checkBusTime(&rows[1], 1);
+
+    // eight lines need more than the whole CPU time: samples are missed
+    count = runScheduler(200, 8, 750, rows);
+    CHECK_EQUAL(count, 9);
+    CHECK(rows[8].missed > 0);
+    CHECK_EQUAL(rows[8].failures, 0);
+    CHECK(rows[8].utilisation * 8 > 90);
+    CHECK(rows[8].utilisation * 8 <= 100);
+
+    return TEST_RESULT();
+}
+
+
+//! \brief run one minute of scheduling
+//! \return number of rows, one per line and one for all of them
+//!
+uint8_t runScheduler(uint16_t sensors, uint8_t lines, uint16_t window, row_t *rows) {
+    FILE *file = tmpfile();
+    char text[128];
+    uint8_t count = 0;
+
+    if (!file) {
+        CHECK(file != NULL);
+        return 0;
+    }
+
+    CHECK(onewire_sim_benchmarkScheduler(file, ONEWIRE_SIM_CSV, sensors, lines,
+                                            DURATION, window));
+    rewind(file);
+
+    printf("%u sensors, %u lines, window %u ms\n", sensors, lines, window);
+
+    // header
+    if (fgets(text, sizeof(text), file)) {
+        printf("%s", text);
+    }
+
+    while (count <= lines && fgets(text, sizeof(text), file)) {
+        row_t *row = &rows[count];
+        char *fields = strchr(text, ',');
+
+        printf("%s", text);
+
+        if (fields == NULL) {
+            continue;
+        }
+
+        if (sscanf(fields, ",%u,%u,%u,%u,%u,%lf", &row->sensors, &row->reads,
+                    &row->failures, &row->missed, &row->jitter, &row->utilisation) == 6)
+        {
+            count++;
+        }
+    }
+
+    fclose(file);
+
+    return count;
+}
+
+
+//! \brief bus time between the reads alone and one conversion per read
+//! \param lines lines the row is averaged over
+//!
+void checkBusTime(const row_t *row, uint8_t lines) {
+    double low = 100.0 * row->reads * READ_TIME / 1000 / DURATION / lines;
+    double high = 100.0 * row->reads * (READ_TIME + CONVERT_TIME) / 1000 / DURATION / lines;
+
+    CHECK(row->utilisation >= low - 0.1);
+    CHECK(row->utilisation <= high + 0.1);
+}
+
+
+//! \brief samples released during the run, periods of 1, 2, 5 and 10 s
+//!
+uint32_t expectedReads(uint16_t sensors, uint8_t lines) {
+    static const uint32_t period[] = {1000, 2000, 5000, 10000};
+    uint32_t reads = 0;
+
+    for (uint16_t k = 0; k < sensors; k++) {
+        reads += DURATION / period[(k / lines) % 4];
+    }
+
+    return reads;
+}
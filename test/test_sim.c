@@ -0,0 +1,214 @@
+//! \file test_sim.c
+//! \brief Search, DS18B20 reads and memory writes against virtual devices
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 17
+
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+#include "onewire_memory.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define THERMOMETERS    200
+#define EEPROMS         30
+#define SWITCHES        20
+#define DEVICES         (THERMOMETERS + EEPROMS + SWITCHES)
+
+
+static onewire_sim_ds18b20_t thermometer[THERMOMETERS];
+static onewire_sim_ds2431_t eeprom[EEPROMS];
+static onewire_sim_ds2413_t pio[SWITCHES];
+
+static bool isFound(const uint8_t *ROM, uint8_t address_box[][8], uint8_t count);
+static void test_search(void);
+static void test_ds18b20(void);
+static void test_memory(void);
+
+
+int main(void) {
+    test_search();
+    test_ds18b20();
+    test_memory();
+
+    return TEST_RESULT();
+}
+
+
+bool isFound(const uint8_t *ROM, uint8_t address_box[][8], uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        if (memcmp(ROM, address_box[i], 8) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+//! \brief a mixed bus is enumerated completely, a family on its own
+//!
+void test_search(void) {
+    static uint8_t address_box[255][8];
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+    uint8_t found;
+    uint8_t missing = 0;
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+
+    for (uint16_t i = 0; i < THERMOMETERS; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        onewire_sim_attach(&sim, &thermometer[i].device);
+    }
+    for (uint16_t i = 0; i < EEPROMS; i++) {
+        onewire_sim_ds2431Init(&eeprom[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000 + i));
+        onewire_sim_attach(&sim, &eeprom[i].device);
+    }
+    for (uint16_t i = 0; i < SWITCHES; i++) {
+        onewire_sim_ds2413Init(&pio[i], onewire_sim_serial(ONEWIRE_SIM_PREFIX, i));
+        onewire_sim_attach(&sim, &pio[i].device);
+    }
+
+    found = onewire_search(&bus, address_box, 255);
+    CHECK_EQUAL(found, DEVICES);
+
+    for (uint16_t i = 0; i < THERMOMETERS; i++) {
+        missing += !isFound(thermometer[i].device.ROM, address_box, found);
+    }
+    for (uint16_t i = 0; i < EEPROMS; i++) {
+        missing += !isFound(eeprom[i].device.ROM, address_box, found);
+    }
+    for (uint16_t i = 0; i < SWITCHES; i++) {
+        missing += !isFound(pio[i].device.ROM, address_box, found);
+    }
+    CHECK_EQUAL(missing, 0);
+
+    found = onewire_searchFamily(&bus, DS2431_FAMILY_CODE, address_box, 255);
+    CHECK_EQUAL(found, EEPROMS);
+    for (uint8_t i = 0; i < found; i++) {
+        CHECK_EQUAL(address_box[i][0], DS2431_FAMILY_CODE);
+    }
+
+    // nothing answers on an empty line
+    onewire_sim_init(&sim);
+    CHECK_EQUAL(onewire_search(&bus, address_box, 255), 0);
+    CHECK(!onewire_reset(&bus));
+}
+
+
+//! \brief one broadcast conversion, every thermometer read with its CRC
+//!
+void test_ds18b20(void) {
+    uint8_t address_box[10][8];
+    int16_t temperature[10];
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+
+    for (uint8_t i = 0; i < 10; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_SEQUENTIAL, i));
+        thermometer[i].temperature = (i - 5) * 37;
+        onewire_sim_attach(&sim, &thermometer[i].device);
+        memcpy(address_box[i], thermometer[i].device.ROM, 8);
+    }
+
+    CHECK(ds18b20_convertAll(&bus));
+    CHECK(ds18b20_waitConversion(&bus));
+
+    for (uint8_t i = 0; i < 10; i++) {
+        int16_t value = 0;
+
+        CHECK(ds18b20_readTemperature(&bus, address_box[i], &value));
+        CHECK_EQUAL(value, (i - 5) * 37);
+    }
+
+    for (uint8_t i = 0; i < 10; i++) {
+        thermometer[i].temperature = 25 * 16 + i;
+    }
+
+    CHECK_EQUAL(ds18b20_readAll(&bus, address_box, temperature, 10, true), 10);
+    for (uint8_t i = 0; i < 10; i++) {
+        CHECK_EQUAL(temperature[i], 25 * 16 + i);
+    }
+
+    // an absent thermometer is reported, the others are still read
+    onewire_sim_detach(&sim, &thermometer[3].device);
+    CHECK_EQUAL(ds18b20_readAll(&bus, address_box, temperature, 10, true), 9);
+    CHECK_EQUAL(temperature[3], DS18B20_NO_READING);
+
+    // the other slaves answer the reset, the absent one reads all ones
+    CHECK_EQUAL(ds18b20_readAll(&bus, address_box, temperature, 10, false), 9);
+    CHECK_EQUAL(temperature[3], DS18B20_NO_READING);
+    CHECK_EQUAL(temperature[4], 25 * 16 + 4);
+}
+
+
+//! \brief page writes, partial pages and the line during programming
+//!
+void test_memory(void) {
+    const onewire_memory_t *model = &onewire_memory_ds2431;
+    const uint8_t *address;
+    uint8_t image[128];
+    uint8_t data[128];
+    uint8_t command[4];
+    uint8_t crc[2];
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+
+    onewire_sim_ds2431Init(&eeprom[0], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000));
+    onewire_sim_attach(&sim, &eeprom[0].device);
+    onewire_sim_ds18b20Init(&thermometer[0], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 0));
+    onewire_sim_attach(&sim, &thermometer[0].device);
+    address = eeprom[0].device.ROM;
+
+    for (uint8_t i = 0; i < sizeof(image); i++) {
+        image[i] = i * 7 + 3;
+    }
+
+    CHECK_EQUAL(onewire_memory_write(&bus, address, model, 0, image, sizeof(image)), ONEWIRE_OK);
+    CHECK(memcmp(eeprom[0].memory, image, sizeof(image)) == 0);
+
+    CHECK_EQUAL(onewire_memory_readBuffer(&bus, address, model, 0, data, sizeof(data)),
+                ONEWIRE_OK);
+    CHECK(memcmp(data, image, sizeof(image)) == 0);
+
+    // across three pages, the bytes around it are kept
+    for (uint8_t i = 13; i < 24; i++) {
+        image[i] = 0xA0 + i;
+    }
+    CHECK_EQUAL(onewire_memory_write(&bus, address, model, 13, &image[13], 11), ONEWIRE_OK);
+    CHECK(memcmp(eeprom[0].memory, image, sizeof(image)) == 0);
+
+    CHECK_EQUAL(onewire_memory_readBuffer(&bus, address, model, 120, data, 10),
+                ONEWIRE_RANGE_ERROR);
+    CHECK_EQUAL(onewire_memory_write(&bus, address, model, 128, data, 1), ONEWIRE_RANGE_ERROR);
+
+    // the device leaves the line high during tPROG, then sends 0xAA
+    CHECK(onewire_select(&bus, address));
+    command[0] = ONEWIRE_MEMORY_WRITE_SCRATCHPAD;
+    command[1] = 0x08;
+    command[2] = 0x00;
+    onewire_sendBuffer(&bus, command, 3);
+    onewire_sendBuffer(&bus, image, 8);
+    onewire_receiveBuffer(&bus, crc, 2);
+
+    CHECK(onewire_select(&bus, address));
+    command[0] = ONEWIRE_MEMORY_COPY_SCRATCHPAD;
+    command[3] = 0x07;
+    onewire_sendBuffer(&bus, command, 4);
+    CHECK_EQUAL(onewire_receive(&bus), 0xFF);
+    onewire_idle(&bus, model->program, model->strong);
+    CHECK_EQUAL(onewire_receive(&bus), 0xAA);
+
+    onewire_sim_detach(&sim, &eeprom[0].device);
+    onewire_sim_detach(&sim, &thermometer[0].device);
+    CHECK_EQUAL(onewire_memory_write(&bus, address, model, 0, image, 8), ONEWIRE_NO_PRESENCE);
+}
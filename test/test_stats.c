@@ -0,0 +1,153 @@
+//! \file test_stats.c
+//! \brief Event counters and histograms of ONEWIRE_STATS builds
+//! \author Nguyen Trong Phuong
+//! \date 2020 July 8
+//!
+//! Built against a copy of the library compiled with ONEWIRE_STATS.
+//! Standard slots last 70 us (bucket 6), a reset 960 us (bucket 9), a
+//! MATCH ROM scratchpad read 11600 us (bucket 13).
+
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+#include "test.h"
+
+
+#define SLOT_BUCKET         6
+#define RESET_BUCKET        9
+#define READ_BUCKET         13
+
+// MATCH ROM, address, command and scratchpad
+#define READ_SLOTS          (8 + 64 + 8 + 8 * DS18B20_SCRATCHPAD_SIZE)
+
+
+static onewire_sim_ds18b20_t thermometer[2];
+
+static uint32_t total(const uint16_t *histogram);
+static void test_transfer(void);
+static void test_reset(void);
+
+
+int main(void) {
+    test_transfer();
+    test_reset();
+
+    return TEST_RESULT();
+}
+
+
+uint32_t total(const uint16_t *histogram) {
+    uint32_t sum = 0;
+
+    for (uint8_t i = 0; i < ONEWIRE_STATS_BUCKETS; i++) {
+        sum += histogram[i];
+    }
+
+    return sum;
+}
+
+
+//! \brief a good read, a read failing its CRC on every retry, then a
+//! read good again
+//!
+void test_transfer(void) {
+    uint8_t command = DS18B20_READ_SCRATCHPAD;
+    uint8_t scratchpad[DS18B20_SCRATCHPAD_SIZE];
+    const uint8_t *address = thermometer[0].device.ROM;
+    onewire_stats_t stats;
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+    onewire_sim_ds18b20Init(&thermometer[0], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 0));
+    onewire_sim_attach(&sim, &thermometer[0].device);
+
+    CHECK_EQUAL(onewire_transfer(&bus, address, &command, 1, scratchpad, sizeof(scratchpad),
+                                ONEWIRE_CHECK_CRC8, 2), ONEWIRE_OK);
+
+    // the transaction runs until the next reset
+    onewire_stats_snapshot(&bus, &stats);
+    CHECK_EQUAL(stats.resets, 1);
+    CHECK_EQUAL(stats.retries, 0);
+    CHECK_EQUAL(stats.crc_failures, 0);
+    CHECK_EQUAL(stats.transaction, 116000);     // tenths of us
+    CHECK_EQUAL(total(stats.duration), 0);
+
+    // every attempt fails, 2 retries
+    thermometer[0].scratchpad[8] ^= 0x01;
+    CHECK_EQUAL(onewire_transfer(&bus, address, &command, 1, scratchpad, sizeof(scratchpad),
+                                ONEWIRE_CHECK_CRC8, 2), ONEWIRE_CRC_ERROR);
+
+    onewire_stats_snapshot(&bus, &stats);
+    CHECK_EQUAL(stats.resets, 4);
+    CHECK_EQUAL(stats.retries, 2);
+    CHECK_EQUAL(stats.crc_failures, 3);
+    CHECK_EQUAL(stats.presence_failures, 0);
+    CHECK_EQUAL(stats.duration[READ_BUCKET], 3);
+    CHECK_EQUAL(total(stats.duration), 3);
+
+    // masked windows of a bit-banged bus, one per reset and per slot
+    CHECK_EQUAL(stats.masked[RESET_BUCKET], 4);
+    CHECK_EQUAL(stats.masked[SLOT_BUCKET], 4 * READ_SLOTS);
+    CHECK_EQUAL(total(stats.masked), 4 * (1 + READ_SLOTS));
+
+    // good again, no retry needed
+    thermometer[0].scratchpad[8] ^= 0x01;
+    CHECK_EQUAL(onewire_transfer(&bus, address, &command, 1, scratchpad, sizeof(scratchpad),
+                                ONEWIRE_CHECK_CRC8, 2), ONEWIRE_OK);
+
+    onewire_stats_snapshot(&bus, &stats);
+    CHECK_EQUAL(stats.resets, 5);
+    CHECK_EQUAL(stats.retries, 2);
+    CHECK_EQUAL(stats.crc_failures, 3);
+    CHECK_EQUAL(stats.duration[READ_BUCKET], 4);
+
+    onewire_stats_clear(&bus);
+    onewire_stats_snapshot(&bus, &stats);
+    CHECK_EQUAL(stats.resets, 0);
+    CHECK_EQUAL(stats.transaction, 0);
+    CHECK_EQUAL(total(stats.duration), 0);
+    CHECK_EQUAL(total(stats.masked), 0);
+}
+
+
+//! \brief bare resets, missing slaves, a stuck line and a search
+//!
+void test_reset(void) {
+    uint8_t address_box[3][8];
+    onewire_stats_t stats;
+    onewire_sim_t sim;
+    onewire_bus_t bus;
+
+    onewire_sim_init(&sim);
+    host_onewire_init(&bus, &sim);
+
+    // a reset alone is a transaction of 960 us
+    CHECK(!onewire_reset(&bus));
+    CHECK(!onewire_reset(&bus));
+
+    onewire_stats_snapshot(&bus, &stats);
+    CHECK_EQUAL(stats.resets, 2);
+    CHECK_EQUAL(stats.presence_failures, 2);
+    CHECK_EQUAL(stats.duration[RESET_BUCKET], 1);
+    CHECK_EQUAL(total(stats.duration), 1);
+
+    sim.slave_low = 0;
+    sim.slave_release = UINT64_MAX;
+    CHECK(!onewire_reset(&bus));
+    onewire_stats_snapshot(&bus, &stats);
+    CHECK_EQUAL(stats.line_timeouts, 1);
+
+    onewire_sim_init(&sim);
+    for (uint8_t i = 0; i < 2; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        onewire_sim_attach(&sim, &thermometer[i].device);
+    }
+
+    onewire_stats_clear(&bus);
+    CHECK_EQUAL(onewire_search(&bus, address_box, 3), 2);
+    onewire_stats_snapshot(&bus, &stats);
+    CHECK_EQUAL(stats.searches, 1);
+    CHECK_EQUAL(stats.crc_failures, 0);
+    CHECK(stats.resets >= 2);
+}
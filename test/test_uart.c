@@ -0,0 +1,252 @@
+//! \file test_uart.c
+//! \brief UART physical layer looped back on a simulated line
+//! \author Nguyen Trong Phuong
+//! \date 2020 June 20
+
+#include "onewire_sim.h"
+#include "onewire_ds18b20.h"
+#include "onewire_memory.h"
+#include "onewire_crc.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define THERMOMETERS    5
+
+
+static onewire_sim_ds18b20_t thermometer[THERMOMETERS];
+static onewire_sim_ds2431_t eeprom;
+static onewire_sim_ds2431_t fast[2];
+
+static void test_loopback(void);
+static void test_ds18b20(void);
+static void test_async(void);
+static void test_memory(void);
+static void test_overdrive(void);
+static void jobDone(onewire_uart_job_t *job);
+
+
+int main(void) {
+    test_loopback();
+    test_ds18b20();
+    test_async();
+    test_memory();
+    test_overdrive();
+
+    return TEST_RESULT();
+}
+
+
+void jobDone(onewire_uart_job_t *job) {
+    (*(uint8_t*)job->arg)++;
+}
+
+
+//! \brief nothing attached: slots read back what was sent, no presence
+//!
+void test_loopback(void) {
+    onewire_sim_t sim;
+    onewire_sim_uart_t uart;
+    onewire_bus_t bus;
+    uint8_t data[3] = {0x00, 0xA5, 0xFF};
+
+    onewire_sim_init(&sim);
+    onewire_sim_uartInit(&uart, &sim);
+    onewire_uart_init(&bus, &uart.port);
+
+    CHECK(!onewire_reset(&bus));
+    CHECK_EQUAL(onewire_receiveBit(&bus), 1);
+    CHECK_EQUAL(onewire_receive(&bus), 0xFF);
+
+    onewire_sendBuffer(&bus, data, sizeof(data));
+    CHECK_EQUAL(uart.baudrate, ONEWIRE_UART_DATA_BAUDRATE);
+
+    // a line held low echoes 0x00 for the reset frame, it is not a presence
+    sim.slave_low = 0;
+    sim.slave_release = UINT64_MAX;
+    CHECK(!onewire_reset(&bus));
+}
+
+
+//! \brief a whole bus searched and read through the UART
+//!
+void test_ds18b20(void) {
+    uint8_t address_box[THERMOMETERS + 1][8];
+    onewire_sim_t sim;
+    onewire_sim_uart_t uart;
+    onewire_bus_t bus;
+
+    onewire_sim_init(&sim);
+    onewire_sim_uartInit(&uart, &sim);
+    onewire_uart_init(&bus, &uart.port);
+
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        onewire_sim_ds18b20Init(&thermometer[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, i));
+        thermometer[i].temperature = 20 * 16 + i;
+        onewire_sim_attach(&sim, &thermometer[i].device);
+    }
+
+    CHECK(onewire_reset(&bus));
+    CHECK_EQUAL(onewire_search(&bus, address_box, THERMOMETERS + 1), THERMOMETERS);
+
+    CHECK(ds18b20_convertAll(&bus));
+    CHECK(ds18b20_waitConversion(&bus));
+
+    for (uint8_t i = 0; i < THERMOMETERS; i++) {
+        int16_t value = 0;
+
+        CHECK(ds18b20_readTemperature(&bus, thermometer[i].device.ROM, &value));
+        CHECK_EQUAL(value, 20 * 16 + i);
+    }
+}
+
+
+//! \brief background transfers give the bytes of blocking ones,
+//! one interrupt per chunk
+//!
+void test_async(void) {
+    const uint8_t *address = thermometer[0].device.ROM;
+    onewire_sim_t sim;
+    onewire_sim_uart_t uart;
+    onewire_bus_t bus;
+    onewire_uart_job_t job;
+    uint8_t scratchpad[9];
+    uint8_t expected[9];
+    uint8_t command = DS18B20_READ_SCRATCHPAD;
+    uint8_t done = 0;
+    uint8_t interrupts = 0;
+
+    onewire_sim_init(&sim);
+    onewire_sim_uartInit(&uart, &sim);
+    onewire_uart_init(&bus, &uart.port);
+    onewire_sim_attach(&sim, &thermometer[0].device);
+
+    CHECK(onewire_select(&bus, address));
+    onewire_send(&bus, DS18B20_READ_SCRATCHPAD);
+    onewire_receiveBuffer(&bus, expected, sizeof(expected));
+    CHECK_EQUAL(crc8(0, expected, sizeof(expected)), 0);
+
+    CHECK(onewire_select(&bus, address));
+    onewire_uart_sendAsync(&job, &bus, &command, 1, jobDone, &done);
+    CHECK(job.busy);
+    while (onewire_sim_uartInterrupt(&uart)) {
+        interrupts++;
+    }
+    CHECK(!job.busy);
+    CHECK_EQUAL(interrupts, 1);
+    CHECK_EQUAL(done, 1);
+
+    memset(scratchpad, 0, sizeof(scratchpad));
+    interrupts = 0;
+    onewire_uart_receiveAsync(&job, &bus, scratchpad, sizeof(scratchpad), jobDone, &done);
+    while (onewire_sim_uartInterrupt(&uart)) {
+        interrupts++;
+    }
+    CHECK(!job.busy);
+    CHECK_EQUAL(done, 2);
+    CHECK_EQUAL(interrupts, (sizeof(scratchpad) * 8 + ONEWIRE_UART_CHUNK - 1) / ONEWIRE_UART_CHUNK);
+    CHECK(memcmp(scratchpad, expected, sizeof(expected)) == 0);
+
+    // a blocking port ends the job before returning
+    uart.port.start = NULL;
+    CHECK(onewire_select(&bus, address));
+    onewire_uart_sendAsync(&job, &bus, &command, 1, jobDone, &done);
+    CHECK(!job.busy);
+    CHECK_EQUAL(done, 3);
+    CHECK(!onewire_sim_uartInterrupt(&uart));
+}
+
+
+//! \brief pages written through the UART, tPROG waited by the port
+//!
+void test_memory(void) {
+    const onewire_memory_t *model = &onewire_memory_ds2431;
+    const uint8_t *address = eeprom.device.ROM;
+    onewire_sim_t sim;
+    onewire_sim_uart_t uart;
+    onewire_bus_t bus;
+    uint8_t image[32];
+    uint8_t data[32];
+
+    onewire_sim_init(&sim);
+    onewire_sim_uartInit(&uart, &sim);
+    onewire_uart_init(&bus, &uart.port);
+    onewire_sim_ds2431Init(&eeprom, onewire_sim_serial(ONEWIRE_SIM_RANDOM, 1000));
+    onewire_sim_attach(&sim, &eeprom.device);
+
+    for (uint8_t i = 0; i < sizeof(image); i++) {
+        image[i] = i * 7 + 3;
+    }
+
+    CHECK_EQUAL(onewire_memory_write(&bus, address, model, 0, image, sizeof(image)), ONEWIRE_OK);
+    CHECK(memcmp(eeprom.memory, image, sizeof(image)) == 0);
+
+    CHECK_EQUAL(onewire_memory_readBuffer(&bus, address, model, 0, data, sizeof(data)),
+                ONEWIRE_OK);
+    CHECK(memcmp(data, image, sizeof(image)) == 0);
+}
+
+
+//! \brief overdrive profiles switch the UART to overdrive resets and slots
+//!
+void test_overdrive(void) {
+    const onewire_memory_t *model = &onewire_memory_ds2431;
+    uint8_t address_box[3][8];
+    onewire_sim_counter_t counter;
+    onewire_sim_t sim;
+    onewire_sim_uart_t uart;
+    onewire_bus_t bus;
+    uint8_t image[8] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+    uint8_t data[16];
+
+    onewire_sim_init(&sim);
+    onewire_sim_uartInit(&uart, &sim);
+    onewire_uart_init(&bus, &uart.port);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        onewire_sim_ds2431Init(&fast[i], onewire_sim_serial(ONEWIRE_SIM_RANDOM, 2000 + i));
+        for (uint8_t j = 0; j < sizeof(data); j++) {
+            fast[i].memory[j] = i * 16 + j;
+        }
+        onewire_sim_attach(&sim, &fast[i].device);
+    }
+
+    CHECK(onewire_overdriveSkip(&bus));
+    CHECK_EQUAL(uart.baudrate, ONEWIRE_UART_OVERDRIVE_DATA_BAUDRATE);
+    CHECK(fast[0].device.overdrive);
+    CHECK(fast[1].device.overdrive);
+
+    // overdrive resets keep the slaves at overdrive, slots stay short
+    onewire_sim_clearCounters(&sim);
+    CHECK(onewire_reset(&bus));
+    CHECK_EQUAL(onewire_search(&bus, address_box, 3), 2);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        CHECK_EQUAL(onewire_memory_readBuffer(&bus, fast[i].device.ROM, model, 0,
+                                              data, sizeof(data)), ONEWIRE_OK);
+        CHECK(memcmp(data, fast[i].memory, sizeof(data)) == 0);
+        CHECK(fast[i].device.overdrive);
+    }
+
+    CHECK_EQUAL(onewire_memory_write(&bus, fast[1].device.ROM, model, 8, image, sizeof(image)),
+                ONEWIRE_OK);
+    CHECK(memcmp(&fast[1].memory[8], image, sizeof(image)) == 0);
+    CHECK(fast[1].device.overdrive);
+
+    onewire_sim_getCounters(&sim, &counter);
+    CHECK(counter.slot_low_max < 10000);
+
+    // back to standard speed, then one slave alone at overdrive
+    CHECK(onewire_standardSpeed(&bus));
+    CHECK_EQUAL(uart.baudrate, ONEWIRE_UART_DATA_BAUDRATE);
+    CHECK(!fast[0].device.overdrive);
+    CHECK(!fast[1].device.overdrive);
+
+    CHECK(onewire_overdriveSelect(&bus, fast[0].device.ROM));
+    CHECK_EQUAL(uart.baudrate, ONEWIRE_UART_OVERDRIVE_DATA_BAUDRATE);
+    CHECK(fast[0].device.overdrive);
+    CHECK_EQUAL(onewire_memory_readBuffer(&bus, fast[0].device.ROM, model, 0,
+                                          data, sizeof(data)), ONEWIRE_OK);
+    CHECK(memcmp(data, fast[0].memory, sizeof(data)) == 0);
+}
@@ -0,0 +1,112 @@
+//! \file test_wave.c
+//! \brief Slot symbols and burst encoding of precomputed waveforms
+//! \author Nguyen Trong Phuong
+//! \date 2020 May 30
+
+#include "onewire_wave.h"
+#include "test.h"
+
+#include <string.h>
+
+
+#define TICKS_PER_US    80
+
+
+static void test_setup(const onewire_timing_t *timing);
+static void test_encode(void);
+static void test_bursts(void);
+
+
+int main(void) {
+    test_setup(&onewire_timing_standard);
+    test_setup(&onewire_timing_overdrive);
+    test_setup(&onewire_timing_longline);
+    test_encode();
+    test_bursts();
+
+    return TEST_RESULT();
+}
+
+
+//! \brief symbols are the low times of the profile, one period for both slots
+//!
+void test_setup(const onewire_timing_t *timing) {
+    onewire_wave_t wave;
+    uint16_t slot0 = timing->write0_low + timing->write0_recovery;
+    uint16_t slot1 = timing->write1_low + timing->write1_recovery;
+
+    onewire_wave_setup(&wave, timing, TICKS_PER_US);
+
+    CHECK_EQUAL(wave.symbol[0], timing->write0_low * TICKS_PER_US / 10);
+    CHECK_EQUAL(wave.symbol[1], timing->write1_low * TICKS_PER_US / 10);
+    CHECK_EQUAL(wave.period, (slot0 > slot1 ? slot0 : slot1) * TICKS_PER_US / 10);
+
+    // recovery of both slots stays at least the one of the profile
+    CHECK(wave.period - wave.symbol[0] >= timing->write0_recovery * TICKS_PER_US / 10);
+    CHECK(wave.period - wave.symbol[1] >= timing->write1_recovery * TICKS_PER_US / 10);
+}
+
+
+//! \brief one symbol per bit, LSB first
+//!
+void test_encode(void) {
+    const uint8_t data[] = {0x01, 0x80, 0xA5, 0x00, 0xFF};
+    uint32_t table[8 * sizeof(data)];
+    onewire_wave_t wave;
+    uint8_t errors = 0;
+
+    onewire_wave_setup(&wave, &onewire_timing_standard, TICKS_PER_US);
+
+    CHECK_EQUAL(onewire_wave_encode(&wave, data, sizeof(data), table), 8 * sizeof(data));
+
+    for (uint8_t i = 0; i < 8 * sizeof(data); i++) {
+        uint8_t bit = (data[i / 8] >> (i % 8)) & 0x01;
+
+        errors += table[i] != wave.symbol[bit];
+    }
+    CHECK_EQUAL(errors, 0);
+
+    // standard speed windows: write-0 low 60 to 120 us, write-1 low 1 to 15 us
+    CHECK(table[0] >= 1 * TICKS_PER_US && table[0] <= 15 * TICKS_PER_US);
+    CHECK(table[1] >= 60 * TICKS_PER_US && table[1] <= 120 * TICKS_PER_US);
+
+    CHECK_EQUAL(onewire_wave_encode(&wave, data, 0, table), 0);
+}
+
+
+//! \brief bursts sized as tiva_onewire_waveSend() does match one encoding
+//!
+void test_bursts(void) {
+    uint8_t data[37];
+    uint32_t whole[8 * sizeof(data)];
+    uint32_t split[8 * sizeof(data) + 80];
+    onewire_wave_t wave;
+
+    for (uint8_t i = 0; i < sizeof(data); i++) {
+        data[i] = i * 53 + 11;
+    }
+
+    onewire_wave_setup(&wave, &onewire_timing_overdrive, TICKS_PER_US);
+    onewire_wave_encode(&wave, data, sizeof(data), whole);
+
+    for (uint16_t table_len = 8; table_len <= 80; table_len += 3) {
+        const uint16_t bytes_per_burst = table_len / 8;
+        uint16_t symbols = 0;
+        uint16_t bursts = 0;
+
+        for (uint16_t done = 0; done < sizeof(data); done += bytes_per_burst) {
+            uint16_t count = sizeof(data) - done;
+
+            if (count > bytes_per_burst) {
+                count = bytes_per_burst;
+            }
+
+            symbols += onewire_wave_encode(&wave, &data[done], count, &split[symbols]);
+            bursts++;
+        }
+
+        CHECK_EQUAL(symbols, 8 * sizeof(data));
+        CHECK_EQUAL(bursts, (sizeof(data) + bytes_per_burst - 1) / bytes_per_burst);
+        CHECK(memcmp(whole, split, sizeof(whole)) == 0);
+    }
+}